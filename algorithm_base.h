@@ -32,12 +32,9 @@ inline const T &min(const T &a, const T &b, Compare comp) {
     return comp(a, b) ? b : a;
 }
 
-template<class T>
-inline void swap(T &a, T &b) {
-    T temp = a;
-    a = b;
-    b = temp;
-}
+// the standard algorithms call swap unqualified, so a second swap template here would make
+// every such call ambiguous for element types declared at global scope
+using std::swap;
 
 template<class InputIterator1, class InputIterator2>
 inline bool equal(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2) {
@@ -138,6 +135,9 @@ mismatch(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, Inp
     return std::pair<InputIterator1, InputIterator2>(first1, first2);
 }
 
+template<class InputIterator, class OutputIterator>
+struct copy_dispatch;
+
 template<class InputIterator, class OutputIterator>
 inline OutputIterator copy(InputIterator first, InputIterator last, OutputIterator result) {
     return copy_dispatch<InputIterator, OutputIterator>()(first, last, result);
@@ -924,6 +924,48 @@ RandomAccessIterator _lower_bound(RandomAccessIterator first, RandomAccessIterat
     return first;
 }
 
+template<class ForwardIterator, class T, class Compare, class Distance>
+ForwardIterator _lower_bound(ForwardIterator first, ForwardIterator last,
+                             const T &value, Compare comp, Distance *, forward_iterator_tag) {
+    Distance len = distance(first, last);
+    Distance half;
+    ForwardIterator middle;
+
+    while (len > 0) {
+        half = len / 2;
+        middle = first;
+        advance(middle, half);
+        if (comp(*middle, value)) {
+            first = middle;
+            ++first;
+            len = len - half - 1;
+        } else {
+            len = half;
+        }
+    }
+    return first;
+}
+
+template<class RandomAccessIterator, class T, class Compare, class Distance>
+RandomAccessIterator _lower_bound(RandomAccessIterator first, RandomAccessIterator last,
+                                  const T &value, Compare comp, Distance *, random_access_iterator_tag) {
+    Distance len = last - first;
+    Distance half;
+    RandomAccessIterator middle;
+
+    while (len > 0) {
+        half = len / 2;
+        middle = first + half;
+        if (comp(*middle, value)) {
+            first = middle + 1;
+            len = len - half - 1;
+        } else {
+            len = half;
+        }
+    }
+    return first;
+}
+
 template<class ForwardIterator, class T>
 inline ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
                                    const T &value) {
@@ -980,16 +1022,58 @@ RandomAccessIterator _upper_bound(RandomAccessIterator first, RandomAccessIterat
     return first;
 }
 
+template<class ForwardIterator, class T, class Compare, class Distance>
+ForwardIterator _upper_bound(ForwardIterator first, ForwardIterator last,
+                             const T &value, Compare comp, Distance *, forward_iterator_tag) {
+    Distance len = distance(first, last);
+    Distance half;
+    ForwardIterator middle;
+
+    while (len > 0) {
+        half = len / 2;
+        middle = first;
+        advance(middle, half);
+        if (comp(value, *middle)) {
+            len = half;
+        } else {
+            first = middle;
+            ++first;
+            len = len - half - 1;
+        }
+    }
+    return first;
+}
+
+template<class RandomAccessIterator, class T, class Compare, class Distance>
+RandomAccessIterator _upper_bound(RandomAccessIterator first, RandomAccessIterator last,
+                                  const T &value, Compare comp, Distance *, random_access_iterator_tag) {
+    Distance len = last - first;
+    Distance half;
+    RandomAccessIterator middle;
+
+    while (len > 0) {
+        half = len / 2;
+        middle = first + half;
+        if (comp(value, *middle)) {
+            len = half;
+        } else {
+            first = middle + 1;
+            len = len - half - 1;
+        }
+    }
+    return first;
+}
+
 template<class ForwardIterator, class T>
 bool binary_search(ForwardIterator first, ForwardIterator last, const T &value) {
-    ForwardIterator i = lower_bound(first, last, value);
+    ForwardIterator i = ::lower_bound(first, last, value);
     return i != last && value == *i; // or !(value<*i)
 }
 
 template<class ForwardIterator, class T, class Compare>
 bool binary_search(ForwardIterator first, ForwardIterator last, const T &value, Compare comp) {
-    ForwardIterator i = lower_bound(first, last, value, comp);
-    return i != last && !comp(value, i);
+    ForwardIterator i = ::lower_bound(first, last, value, comp);
+    return i != last && !comp(value, *i);
 }
 
 template<class BidirectionalIterator>
@@ -5,9 +5,11 @@
 #ifndef BETHSTL_ALLOC_H
 #define BETHSTL_ALLOC_H
 
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <new>
+#include <utility>
 
 // define first level memory allocator
 class firstLevelAlloc {
@@ -30,6 +32,12 @@ public:
         free(pointer);
     }
 
+    // malloc has no runs to hand out, every object is a block of its own
+    static void *allocate_run(size_t n, int &nobjs) {
+        nobjs = 1;
+        return allocate(n);
+    }
+
     static void *reallocate(void *pointer, size_t old_size, size_t new_size) {
         void *result = realloc(pointer, new_size);
         if (nullptr == result) oom_realloc_handler(pointer, new_size);
@@ -89,6 +97,11 @@ public:
 
     static void *reallocate(void *pointer, size_t oldSize, size_t newSize);
 
+    // up to nobjs objects of n bytes laid end to end, nobjs is set to how many. each one
+    // goes back on its own through deallocate(p, n), as the objects of a refill do. while
+    // the free list for n has objects the run is one of them, so freed memory is used first.
+    static void *allocate_run(size_t n, int &nobjs);
+
 private:
     enum {
         ALIGN = 8
@@ -166,6 +179,21 @@ void secondLevelAlloc::deallocate(void *pointer, size_t n) {
     *myFreeList = temp;
 }
 
+void *secondLevelAlloc::allocate_run(size_t n, int &nobjs) {
+    if (n > (size_t) MAX_BYTES) {
+        nobjs = 1;
+        return (malloc_alloc::allocate(n));
+    }
+    obj *volatile *myFreeList = freeList + freeListIndex(n);
+    obj *result = *myFreeList;
+    if (nullptr != result) {
+        *myFreeList = result->next_link;
+        nobjs = 1;
+        return (result);
+    }
+    return chunk_alloc(chuckRoundUp(n), nobjs);
+}
+
 void *secondLevelAlloc::refill(size_t n) {
     int nobj = 20;
     char *chuck = chunk_alloc(n, nobj);
@@ -252,15 +280,203 @@ public:
 
     static void deallocate(T *pointer, size_t n) {
         if (0 != n) {
-            Alloc::deallocate(pointer, n);
+            Alloc::deallocate(pointer, n * sizeof(T));
         }
     }
 
     static void deallocate(T *pointer) {
         Alloc::deallocate(pointer, sizeof(T));
     }
+
+    // up to n objects side by side, n is set to how many; each is freed with deallocate(p)
+    static T *allocate_run(int &n) {
+        return (T *) Alloc::allocate_run(sizeof(T), n);
+    }
+};
+
+// node_pool hands out fixed size nodes for one container from slabs that container owns.
+// a freed node goes onto the pool's own free list and is reused by the next allocate();
+// memory only goes back to Alloc when release() drops every slab at once, so filling and
+// clearing a big container costs a handful of Alloc calls instead of one per node.
+template<class T, class Alloc>
+class node_pool {
+private:
+    union obj {
+        union obj *next_link;
+        char client_data[sizeof(T)];
+    };
+
+    struct slab {
+        slab *next;
+        size_t bytes;
+    };
+
+    enum {
+        ALIGN = alignof(T) > alignof(slab) ? alignof(T) : alignof(slab)
+    };
+    enum {
+        MIN_SLAB = 16
+    };
+    enum {
+        MAX_SLAB = 1 << 20
+    };
+
+    static size_t roundUp(size_t n) {
+        return ((n + (size_t) ALIGN - 1) & ~((size_t) ALIGN - 1));
+    }
+
+    static size_t nodeSize() { return roundUp(sizeof(obj)); }
+
+    // Alloc only promises alignment enough for a pointer, so a slab has ALIGN - 1 spare bytes
+    // to move its first node up to a multiple of ALIGN in memory, not just in the slab
+    static size_t headerSize() { return sizeof(slab) + (size_t) ALIGN - 1; }
+
+    static char *first_node(slab *s) {
+        return (char *) (((uintptr_t) (s + 1) + (size_t) ALIGN - 1) & ~(uintptr_t) (ALIGN - 1));
+    }
+
+    slab *slabs;
+    obj *freeList;
+    char *start_free;
+    char *end_free;
+    size_t next_slab;
+
+    // a loose node sits in a slab of its own, with the slab's address in the word before it
+    static size_t looseBytes() { return sizeof(slab) + sizeof(slab *) + (size_t) ALIGN - 1 + nodeSize(); }
+
+    static slab *&loose_slab(T *p) { return ((slab **) p)[-1]; }
+
+    // the unused tail of the current slab is kept on the free list before moving on
+    void retire_tail() {
+        while ((size_t) (end_free - start_free) >= nodeSize()) {
+            obj *o = (obj *) start_free;
+            o->next_link = freeList;
+            freeList = o;
+            start_free += nodeSize();
+        }
+        start_free = end_free = nullptr;
+    }
+
+    void add_slab(size_t n) {
+        size_t bytes = headerSize() + n * nodeSize();
+        slab *s = (slab *) Alloc::allocate(bytes);
+        retire_tail();
+        s->next = slabs;
+        s->bytes = bytes;
+        slabs = s;
+        start_free = first_node(s);
+        end_free = start_free + n * nodeSize();
+    }
+
+public:
+    node_pool() : slabs(nullptr), freeList(nullptr), start_free(nullptr), end_free(nullptr), next_slab(MIN_SLAB) {}
+
+    ~node_pool() { release(); }
+
+    node_pool(const node_pool &) = delete;
+
+    node_pool &operator=(const node_pool &) = delete;
+
+    T *allocate() {
+        if (freeList) {
+            obj *result = freeList;
+            freeList = result->next_link;
+            return (T *) result;
+        }
+        if ((size_t) (end_free - start_free) < nodeSize()) {
+            add_slab(next_slab);
+            if (next_slab < (size_t) MAX_SLAB) next_slab *= 2;
+        }
+        T *result = (T *) start_free;
+        start_free += nodeSize();
+        return result;
+    }
+
+    void deallocate(T *p) {
+        obj *o = (obj *) p;
+        o->next_link = freeList;
+        freeList = o;
+    }
+
+    // make room for n more nodes in one contiguous slab, ahead of a bulk insert
+    void reserve(size_t n) {
+        if ((size_t) (end_free - start_free) / nodeSize() < n)
+            add_slab(n);
+    }
+
+    // gives every slab back to Alloc. nodes still handed out become invalid.
+    void release() {
+        while (slabs) {
+            slab *next = slabs->next;
+            Alloc::deallocate(slabs, slabs->bytes);
+            slabs = next;
+        }
+        freeList = nullptr;
+        start_free = end_free = nullptr;
+        next_slab = MIN_SLAB;
+    }
+
+    // takes over every slab of x, and so every node x handed out, leaving x empty. the free
+    // nodes of x join this pool's free list, which costs a walk over them but no allocation.
+    void adopt(node_pool &x) {
+        if (&x == this || !x.slabs) return;
+        x.retire_tail();
+        slab *last = x.slabs;
+        while (last->next) last = last->next;
+        last->next = slabs;
+        slabs = x.slabs;
+        if (x.freeList) {
+            obj *tail = x.freeList;
+            while (tail->next_link) tail = tail->next_link;
+            tail->next_link = freeList;
+            freeList = x.freeList;
+        }
+        if (x.next_slab > next_slab) next_slab = x.next_slab;
+        x.slabs = nullptr;
+        x.freeList = nullptr;
+        x.next_slab = MIN_SLAB;
+    }
+
+    // a node that belongs to no pool, for an element that outlives its container in a node
+    // handle. deallocate_loose() frees it, or adopt_loose() gives it to a pool, which then
+    // reuses it like its own nodes and frees it with its slabs.
+    static T *allocate_loose() {
+        slab *s = (slab *) Alloc::allocate(looseBytes());
+        s->next = nullptr;
+        s->bytes = looseBytes();
+        T *p = (T *) (((uintptr_t) (s + 1) + sizeof(slab *) + (size_t) ALIGN - 1) & ~(uintptr_t) (ALIGN - 1));
+        loose_slab(p) = s;
+        return p;
+    }
+
+    static void deallocate_loose(T *p) {
+        slab *s = loose_slab(p);
+        Alloc::deallocate(s, s->bytes);
+    }
+
+    void adopt_loose(T *p) {
+        slab *s = loose_slab(p);
+        s->next = slabs;
+        slabs = s;
+    }
+
+    // bytes currently taken from Alloc, slab headers and unused space included
+    size_t bytes() const {
+        size_t result = 0;
+        for (const slab *s = slabs; s; s = s->next)
+            result += s->bytes;
+        return result;
+    }
+
+    void swap(node_pool &x) {
+        std::swap(slabs, x.slabs);
+        std::swap(freeList, x.freeList);
+        std::swap(start_free, x.start_free);
+        std::swap(end_free, x.end_free);
+        std::swap(next_slab, x.next_slab);
+    }
 };
 
-typedef freeList_alloc STL_DEFAULT_ALLOCATOR
+typedef freeList_alloc STL_DEFAULT_ALLOCATOR;
 
 #endif //BETHSTL_ALLOC_H
@@ -0,0 +1,46 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "bench.h"
+#include "map.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+template<class Fill>
+static double fill_ms(Fill fill) {
+    return time_ms([&] {
+        map<long, long> m;
+        fill(m);
+        consume((long) m.size());
+    });
+}
+
+// n long keys into an empty map<long, long>: ascending through insert, operator[] and an
+// insert hinted at the last element, then the same keys in scrambled order for reference
+int main(int argc, char **argv) {
+    const size_t n = bench_size(argc, argv, 2000000);
+    std::vector<long> keys;
+    for (size_t i = 0; i < n; ++i) keys.push_back((long) i);
+    std::vector<long> scrambled(keys);
+    std::shuffle(scrambled.begin(), scrambled.end(), std::mt19937_64(1));
+
+    double insert = fill_ms([&](map<long, long> &m) {
+        for (size_t i = 0; i < n; ++i) m.insert(std::make_pair(keys[i], keys[i]));
+    });
+    double subscript = fill_ms([&](map<long, long> &m) {
+        for (size_t i = 0; i < n; ++i) m[keys[i]] = keys[i];
+    });
+    double hinted = fill_ms([&](map<long, long> &m) {
+        map<long, long>::iterator it = m.end();
+        for (size_t i = 0; i < n; ++i) it = m.insert(it, std::make_pair(keys[i], keys[i]));
+    });
+    double random = fill_ms([&](map<long, long> &m) {
+        for (size_t i = 0; i < n; ++i) m.insert(std::make_pair(scrambled[i], scrambled[i]));
+    });
+
+    std::printf("%zu keys ascending: insert %.1f ms, operator[] %.1f ms, hinted insert %.1f ms; "
+                "scrambled insert %.1f ms\n", n, insert, subscript, hinted, random);
+    return 0;
+}
@@ -0,0 +1,41 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_BENCH_H
+#define BETHSTL_BENCH_H
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// wall time of fn() in milliseconds, best of runs so that a cold first pass doesn't count
+template<class Fn>
+inline double time_ms(Fn fn, int runs = 3) {
+    double best = 0;
+    for (int i = 0; i < runs; ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+inline size_t bench_size(int argc, char **argv, size_t fallback) {
+    return argc > 1 ? (size_t) std::strtoull(argv[1], nullptr, 10) : fallback;
+}
+
+// keeps a result alive so the timed loop is not optimized away: the empty asm claims to read
+// x from a register, which the compiler has to honour without any store being emitted
+inline void consume(long x) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(x));
+#else
+    static volatile long sink;
+    sink = x;
+    (void) sink;
+#endif
+}
+
+#endif //BETHSTL_BENCH_H
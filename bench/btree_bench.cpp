@@ -0,0 +1,47 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "bench.h"
+#include "btree.h"
+#include "set.h"
+#include <random>
+#include <vector>
+
+// random uint32 keys: insert all, find each once, then an in-order scan, for the red-black
+// default and for the B+-tree backend
+template<class Set>
+static void run(const char *name, const std::vector<unsigned> &keys) {
+    double insert = time_ms([&] {
+        Set s;
+        for (size_t i = 0; i < keys.size(); ++i) s.insert(keys[i]);
+        consume((long) s.size());
+    }, 1);
+
+    Set s;
+    for (size_t i = 0; i < keys.size(); ++i) s.insert(keys[i]);
+    double find = time_ms([&] {
+        long hits = 0;
+        for (size_t i = 0; i < keys.size(); ++i) hits += s.find(keys[i]) != s.end();
+        consume(hits);
+    });
+    double scan = time_ms([&] {
+        long sum = 0;
+        for (typename Set::const_iterator it = s.begin(); it != s.end(); ++it) sum += *it;
+        consume(sum);
+    });
+
+    std::printf("%-8s %zu keys: insert %.1f ms, find %.1f ms, scan %.1f ms\n",
+                name, keys.size(), insert, find, scan);
+}
+
+int main(int argc, char **argv) {
+    const size_t n = bench_size(argc, argv, 4000000);
+    std::vector<unsigned> keys;
+    std::mt19937 rng(1);
+    for (size_t i = 0; i < n; ++i) keys.push_back((unsigned) rng());
+
+    run<set<unsigned> >("rb_tree", keys);
+    run<set<unsigned, std::less<unsigned>, STL_DEFAULT_ALLOCATOR, btree_backend<> > >("btree", keys);
+    return 0;
+}
@@ -0,0 +1,45 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "bench.h"
+#include "concurrent_hash_cache.h"
+#include <thread>
+#include <vector>
+
+// hit throughput of a warm cache: clock_eviction takes the shard's read lock on a hit,
+// lru_eviction the write lock
+template<class Cache>
+static double hits_per_second(size_t keys, int threads, size_t gets) {
+    Cache c(keys, 64);
+    for (size_t k = 0; k < keys; ++k) c.put((long) k, (long) k);
+    double ms = time_ms([&] {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&c, t, keys, gets, threads] {
+                long v = 0, sum = 0;
+                uint64_t x = (uint64_t) t + 1;
+                for (size_t i = 0; i < gets / threads; ++i) {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+                    if (c.get((long) (x % keys), v)) sum += v;
+                }
+                consume(sum);
+            });
+        }
+        for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+    }, 1);
+    return gets / ms / 1000.0;
+}
+
+int main(int argc, char **argv) {
+    const size_t gets = bench_size(argc, argv, 8000000);
+    const size_t keys = 100000;
+    for (int threads = 1; threads <= 8; threads *= 8) {
+        std::printf("%d threads: clock %.1f M hits/s, lru %.1f M hits/s\n", threads,
+                    hits_per_second<concurrent_hash_cache<long, long> >(keys, threads, gets),
+                    hits_per_second<concurrent_hash_cache<long, long, lru_eviction> >(keys, threads, gets));
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "bench.h"
+#include "hashmap.h"
+#include <random>
+#include <vector>
+
+// random lookups, half of them misses, in a table far larger than the cache:
+// one find() at a time against find_batch() over groups of 256 keys
+int main(int argc, char **argv) {
+    const size_t n = bench_size(argc, argv, 4000000);
+    hash_map<long, long> m;
+    for (size_t i = 0; i < n; ++i) m[(long) i * 2] = (long) i;
+    std::vector<long> keys;
+    std::mt19937_64 rng(1);
+    for (size_t i = 0; i < n; ++i) keys.push_back((long) (rng() % (2 * n)));
+
+    double loop = time_ms([&] {
+        long sum = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            hash_map<long, long>::iterator it = m.find(keys[i]);
+            if (it != m.end()) sum += it->second;
+        }
+        consume(sum);
+    });
+
+    std::vector<hash_map<long, long>::iterator> found(256);
+    double batch = time_ms([&] {
+        long sum = 0;
+        for (size_t i = 0; i < keys.size(); i += 256) {
+            const size_t e = std::min(keys.size(), i + 256);
+            m.find_batch(keys.begin() + i, keys.begin() + e, found.begin());
+            for (size_t j = 0; j < e - i; ++j)
+                if (found[j] != m.end()) sum += found[j]->second;
+        }
+        consume(sum);
+    });
+
+    std::printf("%zu keys: find %.1f ms, find_batch %.1f ms\n", n, loop, batch);
+    return 0;
+}
@@ -0,0 +1,59 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "bench.h"
+#include "set.h"
+#include <vector>
+
+// the union of two sets of n longs, every third key shared: unite() splicing the second
+// tree into the first, against merging both through their iterators into a set built from
+// the sorted result. each run starts from fresh copies, built outside the timing.
+int main(int argc, char **argv) {
+    const size_t n = bench_size(argc, argv, 10000000);
+    std::vector<long> a, b;
+    for (size_t i = 0; i < n; ++i) {
+        a.push_back((long) i * 3);
+        b.push_back((long) i * 3 + (i % 3 == 0 ? 0 : 1));
+    }
+
+    double unite = 0;
+    for (int run = 0; run < 3; ++run) {
+        set<long> x, y;
+        x.insert(a.data(), a.data() + a.size());
+        y.insert(b.data(), b.data() + b.size());
+        double ms = time_ms([&] {
+            x.unite(y);
+            consume((long) x.size());
+        }, 1);
+        if (run == 0 || ms < unite) unite = ms;
+    }
+
+    double merge = 0;
+    for (int run = 0; run < 3; ++run) {
+        set<long> x, y, r;
+        x.insert(a.data(), a.data() + a.size());
+        y.insert(b.data(), b.data() + b.size());
+        double ms = time_ms([&] {
+            std::vector<long> out;
+            out.reserve(x.size() + y.size());
+            set<long>::iterator i = x.begin(), j = y.begin();
+            while (i != x.end() && j != y.end()) {
+                if (*i < *j) out.push_back(*i++);
+                else if (*j < *i) out.push_back(*j++);
+                else {
+                    out.push_back(*i++);
+                    ++j;
+                }
+            }
+            for (; i != x.end(); ++i) out.push_back(*i);
+            for (; j != y.end(); ++j) out.push_back(*j);
+            r.insert(out.data(), out.data() + out.size());
+            consume((long) r.size());
+        }, 1);
+        if (run == 0 || ms < merge) merge = ms;
+    }
+
+    std::printf("2 x %zu keys: unite %.1f ms, iterator merge %.1f ms\n", n, unite, merge);
+    return 0;
+}
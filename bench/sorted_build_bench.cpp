@@ -0,0 +1,30 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "bench.h"
+#include "set.h"
+#include <vector>
+
+// sorted longs into an empty set: one range insert, which builds the tree bottom-up, against
+// inserting them one at a time
+int main(int argc, char **argv) {
+    const size_t n = bench_size(argc, argv, 4000000);
+    std::vector<long> keys;
+    for (size_t i = 0; i < n; ++i) keys.push_back((long) i * 2);
+
+    double bulk = time_ms([&] {
+        set<long> s;
+        s.insert(keys.data(), keys.data() + keys.size());
+        consume((long) s.size());
+    });
+
+    double one = time_ms([&] {
+        set<long> s;
+        for (size_t i = 0; i < keys.size(); ++i) s.insert(keys[i]);
+        consume((long) s.size());
+    });
+
+    std::printf("%zu sorted keys: range insert %.1f ms, one at a time %.1f ms\n", n, bulk, one);
+    return 0;
+}
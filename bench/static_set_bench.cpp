@@ -0,0 +1,45 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "bench.h"
+#include "static_set.h"
+#include "algorithm_base.h"
+#include <random>
+#include <vector>
+
+// random int lookups, half of them misses: lower_bound from algorithm_base.h over the sorted
+// keys against static_set, for sizes from 64K up to the given count, in ns per lookup
+int main(int argc, char **argv) {
+    const size_t max_n = bench_size(argc, argv, 8 << 20);
+    const size_t lookups = 1 << 22;
+    for (size_t n = 1 << 16; n <= max_n; n *= 8) {
+        std::vector<int> sorted;
+        for (size_t i = 0; i < n; ++i) sorted.push_back((int) (i * 2));
+        static_set<int> s(sorted.begin(), sorted.end());
+        std::vector<int> probes;
+        std::mt19937 rng(1);
+        for (size_t i = 0; i < lookups; ++i) probes.push_back((int) (rng() % (2 * n)));
+
+        double binary = time_ms([&] {
+            long sum = 0;
+            for (size_t i = 0; i < lookups; ++i) {
+                const int *p = ::lower_bound(sorted.data(), sorted.data() + n, probes[i]);
+                if (p != sorted.data() + n) sum += *p;
+            }
+            consume(sum);
+        });
+        double eytzinger = time_ms([&] {
+            long sum = 0;
+            for (size_t i = 0; i < lookups; ++i) {
+                static_set<int>::iterator it = s.lower_bound(probes[i]);
+                if (it != s.end()) sum += *it;
+            }
+            consume(sum);
+        });
+
+        std::printf("n = %zu: lower_bound %.1f ns, static_set %.1f ns\n",
+                    n, binary * 1e6 / lookups, eytzinger * 1e6 / lookups);
+    }
+    return 0;
+}
@@ -0,0 +1,967 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_BTREE_H
+#define BETHSTL_BTREE_H
+
+#include "alloc.h"
+#include "construct.h"
+#include "iterator.h"
+#include "node_handle.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// btree is a B+-tree with the interface of _Rb_tree, so that map, multimap and set can sit
+// on it through btree_backend. the values live in arrays in the leaves, which are linked for
+// iteration; inner nodes hold copies of separator keys and child pointers only. a node takes
+// about NodeBytes bytes, four cache lines by default, so a lookup in ten million keys visits
+// five or six nodes instead of two dozen, and a scan reads values back to back.
+//
+// unlike _Rb_tree, every insert and erase invalidates all iterators into the tree, as values
+// move between slots and nodes.
+
+struct btree_node_base {
+    unsigned short count;
+    bool leaf;
+};
+
+template<class Value, size_t Slots>
+struct btree_leaf : public btree_node_base {
+    typedef Value value_type;
+
+    btree_leaf *prev;
+    btree_leaf *next;
+    typename std::aligned_storage<sizeof(Value), alignof(Value)>::type slots[Slots];
+
+    Value *values() { return reinterpret_cast<Value *>(slots); }
+
+    const Value *values() const { return reinterpret_cast<const Value *>(slots); }
+};
+
+template<class Key, size_t Slots>
+struct btree_inner : public btree_node_base {
+    typename std::aligned_storage<sizeof(Key), alignof(Key)>::type key_slots[Slots];
+    btree_node_base *children[Slots + 1];
+
+    Key *keys() { return reinterpret_cast<Key *>(key_slots); }
+
+    const Key *keys() const { return reinterpret_cast<const Key *>(key_slots); }
+};
+
+// slots of size each that fit a node of bytes after its header, never fewer than four
+constexpr size_t __btree_slots(size_t bytes, size_t header, size_t each) {
+    return bytes >= header + 4 * each ? ((bytes - header) / each < 0xffff ? (bytes - header) / each : 0xffff) : 4;
+}
+
+// moves n objects from src to dst, which may overlap; src is left destroyed
+template<class T>
+inline void __btree_relocate(T *dst, T *src, size_t n) {
+    if (n == 0 || dst == src) return;
+    if (std::is_trivially_copy_constructible<T>::value && std::is_trivially_destructible<T>::value) {
+        memmove((void *) dst, (const void *) src, n * sizeof(T));
+    } else if (dst < src) {
+        for (size_t i = 0; i < n; ++i) {
+            construct(dst + i, std::move(src[i]));
+            destroy(src + i);
+        }
+    } else {
+        for (size_t i = n; i-- > 0;) {
+            construct(dst + i, std::move(src[i]));
+            destroy(src + i);
+        }
+    }
+}
+
+// what a btree node handle owns: the values live in the leaves, so extract() moves the element
+// out into a box of its own and insert() moves it back into a slot
+template<class Value>
+struct btree_value_box {
+    Value val;
+};
+
+template<class Value, class Alloc>
+struct btree_box_ops {
+    typedef Value value_type;
+
+    static Value &value(btree_value_box<Value> *p) { return p->val; }
+
+    static void drop(btree_value_box<Value> *p) {
+        destroy(&p->val);
+        simpleAlloc<btree_value_box<Value>, Alloc>::deallocate(p, 1);
+    }
+};
+
+template<class Leaf, class Ref, class Ptr>
+struct btree_iterator {
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef typename Leaf::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Ptr pointer;
+    typedef Ref reference;
+    typedef btree_iterator<Leaf, value_type &, value_type *> iterator;
+    typedef btree_iterator<Leaf, const value_type &, const value_type *> const_iterator;
+    typedef btree_iterator<Leaf, Ref, Ptr> self;
+
+    // end() is one past the last value of the rightmost leaf, or a null node when empty
+    Leaf *node;
+    size_t pos;
+
+    btree_iterator() {}
+
+    btree_iterator(Leaf *n, size_t p) : node(n), pos(p) {}
+
+    // the copy constructor when Ref is value_type &, so the assignment is declared alongside it
+    btree_iterator(const iterator &it) : node(it.node), pos(it.pos) {}
+
+    btree_iterator &operator=(const btree_iterator &) = default;
+
+    reference operator*() const { return node->values()[pos]; }
+
+    pointer operator->() const { return &(operator*()); }
+
+    self &operator++() {
+        if (++pos == node->count && node->next) {
+            node = node->next;
+            pos = 0;
+        }
+        return *this;
+    }
+
+    self operator++(int) {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    self &operator--() {
+        if (pos == 0) {
+            node = node->prev;
+            pos = node->count;
+        }
+        --pos;
+        return *this;
+    }
+
+    self operator--(int) {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    bool operator==(const btree_iterator &x) const { return node == x.node && pos == x.pos; }
+
+    bool operator!=(const btree_iterator &x) const { return !(*this == x); }
+};
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc = STL_DEFAULT_ALLOCATOR,
+        size_t NodeBytes = 256>
+class btree {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+
+private:
+    enum {
+        LEAF_SLOTS = __btree_slots(NodeBytes, sizeof(btree_node_base) + 2 * sizeof(void *), sizeof(Value))
+    };
+    enum {
+        INNER_SLOTS = __btree_slots(NodeBytes, sizeof(btree_node_base) + sizeof(void *), sizeof(Key) + sizeof(void *))
+    };
+    // a node other than the root never holds fewer
+    enum {
+        MIN_LEAF = LEAF_SLOTS / 2
+    };
+    enum {
+        MIN_INNER = INNER_SLOTS / 2
+    };
+    // inner nodes keep at least three children, so 2^64 values stay well below this
+    enum {
+        MAX_HEIGHT = 48
+    };
+
+    typedef btree_node_base node_base;
+    typedef btree_leaf<Value, LEAF_SLOTS> leaf_node;
+    typedef btree_inner<Key, INNER_SLOTS> inner_node;
+    typedef simpleAlloc<leaf_node, Alloc> leaf_allocator;
+    typedef simpleAlloc<inner_node, Alloc> inner_allocator;
+
+public:
+    typedef btree_iterator<leaf_node, reference, pointer> iterator;
+    typedef btree_iterator<leaf_node, const_reference, const_pointer> const_iterator;
+
+    template<class K, class Result>
+    struct _If_transparent
+            : public std::enable_if<_Is_transparent<Compare>::value &&
+                                    !std::is_convertible<K, iterator>::value &&
+                                    !std::is_convertible<K, const_iterator>::value, Result> {
+    };
+
+private:
+    // the inner node at each level above a leaf and the child taken from it
+    struct path_entry {
+        inner_node *node;
+        size_type index;
+    };
+
+    Compare comp;
+    KeyOfValue get_key;
+    node_base *root;
+    leaf_node *leftmost;
+    leaf_node *rightmost;
+    size_type num_elements;
+    // levels of inner nodes above the leaves
+    size_type height;
+
+    const Key &key_at(const leaf_node *leaf, size_type i) const { return get_key(leaf->values()[i]); }
+
+    leaf_node *new_leaf() {
+        leaf_node *leaf = leaf_allocator::allocate();
+        leaf->count = 0;
+        leaf->leaf = true;
+        leaf->prev = leaf->next = nullptr;
+        return leaf;
+    }
+
+    void delete_leaf(leaf_node *leaf) {
+        for (size_type i = 0; i < leaf->count; ++i)
+            destroy(leaf->values() + i);
+        leaf_allocator::deallocate(leaf);
+    }
+
+    inner_node *new_inner() {
+        inner_node *inner = inner_allocator::allocate();
+        inner->count = 0;
+        inner->leaf = false;
+        return inner;
+    }
+
+    void delete_inner(inner_node *inner) {
+        for (size_type i = 0; i < inner->count; ++i)
+            destroy(inner->keys() + i);
+        inner_allocator::deallocate(inner);
+    }
+
+    void unlink_leaf(leaf_node *leaf) {
+        if (leaf->prev) leaf->prev->next = leaf->next;
+        else leftmost = leaf->next;
+        if (leaf->next) leaf->next->prev = leaf->prev;
+        else rightmost = leaf->prev;
+    }
+
+    // number of keys in the node less than k, or not greater than k when Upper
+    template<bool Upper, class K>
+    size_type inner_search(const inner_node *x, const K &k) const {
+        size_type first = 0, len = x->count;
+        while (len > 0) {
+            const size_type half = len >> 1;
+            if (Upper ? !comp(k, x->keys()[first + half]) : comp(x->keys()[first + half], k)) {
+                first += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return first;
+    }
+
+    template<bool Upper, class K>
+    size_type leaf_search(const leaf_node *x, const K &k) const {
+        size_type first = 0, len = x->count;
+        while (len > 0) {
+            const size_type half = len >> 1;
+            if (Upper ? !comp(k, key_at(x, first + half)) : comp(key_at(x, first + half), k)) {
+                first += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return first;
+    }
+
+    // the leaf that holds the lower (upper) bound of k or ends just before it; path, if
+    // given, receives the way down
+    template<bool Upper, class K>
+    leaf_node *descend(const K &k, path_entry *path) const {
+        node_base *x = root;
+        for (size_type d = 0; d < height; ++d) {
+            inner_node *inner = static_cast<inner_node *>(x);
+            const size_type i = inner_search<Upper>(inner, k);
+            if (path) {
+                path[d].node = inner;
+                path[d].index = i;
+            }
+            x = inner->children[i];
+        }
+        return static_cast<leaf_node *>(x);
+    }
+
+    // the way down to the rightmost leaf
+    void rightmost_path(path_entry *path) const {
+        node_base *x = root;
+        for (size_type d = 0; d < height; ++d) {
+            inner_node *inner = static_cast<inner_node *>(x);
+            path[d].node = inner;
+            path[d].index = inner->count;
+            x = inner->children[inner->count];
+        }
+    }
+
+    // moves path on to the next leaf, which must exist
+    leaf_node *next_leaf(path_entry *path) const {
+        size_type d = height;
+        while (path[d - 1].index == path[d - 1].node->count) --d;
+        node_base *x = path[d - 1].node->children[++path[d - 1].index];
+        for (; d < height; ++d) {
+            path[d].node = static_cast<inner_node *>(x);
+            path[d].index = 0;
+            x = path[d].node->children[0];
+        }
+        return static_cast<leaf_node *>(x);
+    }
+
+    // the leaf of pos and the way down to it; equal keys may span several leaves
+    leaf_node *path_to(const_iterator pos, path_entry *path) const {
+        leaf_node *leaf = descend<false>(get_key(*pos), path);
+        while (leaf != pos.node)
+            leaf = next_leaf(path);
+        return leaf;
+    }
+
+    iterator make_iterator(leaf_node *leaf, size_type i) const {
+        if (i == leaf->count && leaf->next) return iterator(leaf->next, 0);
+        return iterator(leaf, i);
+    }
+
+    template<class K>
+    iterator lower_bound_tr(const K &k) const {
+        if (!root) return iterator(nullptr, 0);
+        leaf_node *leaf = descend<false>(k, nullptr);
+        return make_iterator(leaf, leaf_search<false>(leaf, k));
+    }
+
+    template<class K>
+    iterator upper_bound_tr(const K &k) const {
+        if (!root) return iterator(nullptr, 0);
+        leaf_node *leaf = descend<true>(k, nullptr);
+        return make_iterator(leaf, leaf_search<true>(leaf, k));
+    }
+
+    template<class K>
+    iterator find_tr(const K &k) const {
+        iterator it = lower_bound_tr(k);
+        return (it == end_iterator() || comp(k, get_key(*it))) ? end_iterator() : it;
+    }
+
+    template<class K>
+    size_type count_tr(const K &k) const {
+        size_type n = 0;
+        for (iterator it = lower_bound_tr(k), last = end_iterator(); it != last && !comp(k, get_key(*it)); ++it)
+            ++n;
+        return n;
+    }
+
+    iterator end_iterator() const { return root ? iterator(rightmost, rightmost->count) : iterator(nullptr, 0); }
+
+    template<class... Args>
+    iterator insert_first(Args &&... args) {
+        leaf_node *leaf = new_leaf();
+        __STL_TRY {
+            construct(leaf->values(), std::forward<Args>(args)...);
+        }
+        __STL_UNWIND(leaf_allocator::deallocate(leaf));
+        leaf->count = 1;
+        root = leftmost = rightmost = leaf;
+        height = 0;
+        num_elements = 1;
+        return iterator(leaf, 0);
+    }
+
+    template<class... Args>
+    iterator insert_at(path_entry *path, leaf_node *leaf, size_type i, Args &&... args);
+
+    void insert_into_parent(path_entry *path, size_type depth, Key sep, node_base *right);
+
+    void inner_insert(inner_node *x, size_type i, Key &&k, node_base *child) {
+        __btree_relocate(x->keys() + i + 1, x->keys() + i, x->count - i);
+        construct(x->keys() + i, std::move(k));
+        std::memmove(x->children + i + 2, x->children + i + 1, (x->count - i) * sizeof(node_base *));
+        x->children[i + 1] = child;
+        ++x->count;
+    }
+
+    // drops key i and child i + 1
+    void inner_erase(inner_node *x, size_type i) {
+        destroy(x->keys() + i);
+        __btree_relocate(x->keys() + i, x->keys() + i + 1, x->count - i - 1);
+        std::memmove(x->children + i + 1, x->children + i + 2, (x->count - i - 1) * sizeof(node_base *));
+        --x->count;
+    }
+
+    iterator erase_at(path_entry *path, leaf_node *leaf, size_type i);
+
+    void rebalance_inner(path_entry *path, size_type d);
+
+    void erase_subtree(node_base *x, size_type depth) {
+        if (depth == height) {
+            delete_leaf(static_cast<leaf_node *>(x));
+            return;
+        }
+        inner_node *inner = static_cast<inner_node *>(x);
+        for (size_type i = 0; i <= inner->count; ++i)
+            erase_subtree(inner->children[i], depth + 1);
+        delete_inner(inner);
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> emplace_unique_key(const K &k, Args &&... args);
+
+    // moves each element of src over, with unique set only those whose key is not here yet
+    void merge(btree &src, bool unique) {
+        if (&src == this) return;
+        for (iterator it = src.begin(); it != src.end();) {
+            if (unique && find_tr(src.get_key(*it)) != end()) {
+                ++it;
+                continue;
+            }
+            path_entry path[MAX_HEIGHT];
+            leaf_node *leaf = src.path_to(it, path);
+            emplace_equal_key(src.get_key(*it), std::move(*it));
+            it = src.erase_at(path, leaf, it.pos);
+        }
+    }
+
+    template<class... Args>
+    iterator emplace_equal_key(const key_type &k, Args &&... args);
+
+public:
+    btree() : comp(), root(nullptr), leftmost(nullptr), rightmost(nullptr), num_elements(0), height(0) {}
+
+    explicit btree(const Compare &c, const allocator_type & = allocator_type())
+            : comp(c), root(nullptr), leftmost(nullptr), rightmost(nullptr), num_elements(0), height(0) {}
+
+    // rebuilt by appending in order, which fills every leaf but the last
+    btree(const btree &x)
+            : comp(x.comp), root(nullptr), leftmost(nullptr), rightmost(nullptr), num_elements(0), height(0) {
+        __STL_TRY {
+            for (const_iterator it = x.begin(); it != x.end(); ++it)
+                emplace_equal_key(x.get_key(*it), *it);
+        }
+        __STL_UNWIND(clear());
+    }
+
+    btree &operator=(const btree &x) {
+        if (this != &x) {
+            btree tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    ~btree() { clear(); }
+
+    Compare key_comp() const { return comp; }
+
+    allocator_type get_allocator() const { return allocator_type(); }
+
+    iterator begin() { return root ? iterator(leftmost, 0) : iterator(nullptr, 0); }
+
+    const_iterator begin() const { return root ? const_iterator(leftmost, 0) : const_iterator(nullptr, 0); }
+
+    iterator end() { return end_iterator(); }
+
+    const_iterator end() const { return end_iterator(); }
+
+    bool empty() const { return num_elements == 0; }
+
+    size_type size() const { return num_elements; }
+
+    size_type max_size() const { return size_type(-1); }
+
+    void swap(btree &x) {
+        std::swap(comp, x.comp);
+        std::swap(root, x.root);
+        std::swap(leftmost, x.leftmost);
+        std::swap(rightmost, x.rightmost);
+        std::swap(num_elements, x.num_elements);
+        std::swap(height, x.height);
+    }
+
+    std::pair<iterator, bool> insert_unique(const value_type &v) { return emplace_unique_key(get_key(v), v); }
+
+    iterator insert_equal(const value_type &v) { return emplace_equal_key(get_key(v), v); }
+
+    // the hint buys nothing here, a descent costs a handful of nodes
+    iterator insert_unique(iterator, const value_type &v) { return insert_unique(v).first; }
+
+    iterator insert_equal(iterator, const value_type &v) { return insert_equal(v); }
+
+    // the nodes keep no summaries of their values, nothing to recompute
+    void refresh(const_iterator) {}
+
+    // node handles with the interface of _Rb_tree's. the element is moved once on the way out
+    // and once on the way back, there is no node to relink.
+    typedef btree_value_box<Value> value_box;
+    typedef simpleAlloc<value_box, Alloc> box_allocator;
+    typedef node_handle<value_box, btree_box_ops<Value, Alloc> > node_type;
+    typedef node_insert_return<iterator, node_type> insert_return_type;
+
+    node_type extract(iterator pos) {
+        // the path is found while the key is still in place, moving it out may empty it
+        path_entry path[MAX_HEIGHT];
+        leaf_node *leaf = path_to(pos, path);
+        value_box *box = box_allocator::allocate(1);
+        __STL_TRY {
+            construct(&box->val, std::move(*pos));
+        }
+        __STL_UNWIND(box_allocator::deallocate(box, 1));
+        erase_at(path, leaf, pos.pos);
+        return node_type(box);
+    }
+
+    node_type extract(const key_type &k) {
+        iterator it = find_tr(k);
+        return it == end() ? node_type() : extract(it);
+    }
+
+    insert_return_type insert_unique(node_type &&nh) {
+        insert_return_type result = {end(), false, node_type()};
+        if (nh.empty()) return result;
+        std::pair<iterator, bool> p = emplace_unique_key(get_key(nh.value()), std::move(nh.value()));
+        result.position = p.first;
+        result.inserted = p.second;
+        if (p.second)
+            nh = node_type();
+        else
+            result.node = std::move(nh);
+        return result;
+    }
+
+    iterator insert_equal(node_type &&nh) {
+        if (nh.empty()) return end();
+        iterator it = emplace_equal_key(get_key(nh.value()), std::move(nh.value()));
+        nh = node_type();
+        return it;
+    }
+
+    void merge_unique(btree &src) { merge(src, true); }
+
+    void merge_equal(btree &src) { merge(src, false); }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace_unique(const key_type &k, Args &&... args) {
+        return emplace_unique_key(k, std::forward<Args>(args)...);
+    }
+
+    template<class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last) {
+        for (; first != last; ++first)
+            insert_unique(*first);
+    }
+
+    template<class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last) {
+        for (; first != last; ++first)
+            insert_equal(*first);
+    }
+
+    // returns the element after pos
+    iterator erase(iterator pos) {
+        path_entry path[MAX_HEIGHT];
+        leaf_node *leaf = path_to(pos, path);
+        return erase_at(path, leaf, pos.pos);
+    }
+
+    size_type erase(const key_type &k) {
+        const size_type n = count_tr(k);
+        iterator it = lower_bound_tr(k);
+        for (size_type i = 0; i < n; ++i)
+            it = erase(it);
+        return n;
+    }
+
+    void erase(iterator first, iterator last) {
+        if (first == begin() && last == end()) {
+            clear();
+            return;
+        }
+        size_type n = 0;
+        for (iterator it = first; it != last; ++it)
+            ++n;
+        for (; n > 0; --n)
+            first = erase(first);
+    }
+
+    void erase(const key_type *first, const key_type *last) {
+        for (; first != last; ++first)
+            erase(*first);
+    }
+
+    void clear() {
+        if (root) erase_subtree(root, 0);
+        root = nullptr;
+        leftmost = rightmost = nullptr;
+        num_elements = 0;
+        height = 0;
+    }
+
+    iterator find(const key_type &k) { return find_tr(k); }
+
+    const_iterator find(const key_type &k) const { return find_tr(k); }
+
+    size_type count(const key_type &k) const { return count_tr(k); }
+
+    iterator lower_bound(const key_type &k) { return lower_bound_tr(k); }
+
+    const_iterator lower_bound(const key_type &k) const { return lower_bound_tr(k); }
+
+    iterator upper_bound(const key_type &k) { return upper_bound_tr(k); }
+
+    const_iterator upper_bound(const key_type &k) const { return upper_bound_tr(k); }
+
+    std::pair<iterator, iterator> equal_range(const key_type &k) {
+        return std::pair<iterator, iterator>(lower_bound_tr(k), upper_bound_tr(k));
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &k) const {
+        return std::pair<const_iterator, const_iterator>(lower_bound_tr(k), upper_bound_tr(k));
+    }
+
+    template<class K>
+    typename _If_transparent<K, iterator>::type find(const K &k) { return find_tr(k); }
+
+    template<class K>
+    typename _If_transparent<K, const_iterator>::type find(const K &k) const { return find_tr(k); }
+
+    template<class K>
+    typename _If_transparent<K, size_type>::type count(const K &k) const { return count_tr(k); }
+
+    template<class K>
+    typename _If_transparent<K, iterator>::type lower_bound(const K &k) { return lower_bound_tr(k); }
+
+    template<class K>
+    typename _If_transparent<K, const_iterator>::type lower_bound(const K &k) const { return lower_bound_tr(k); }
+
+    template<class K>
+    typename _If_transparent<K, iterator>::type upper_bound(const K &k) { return upper_bound_tr(k); }
+
+    template<class K>
+    typename _If_transparent<K, const_iterator>::type upper_bound(const K &k) const { return upper_bound_tr(k); }
+
+    template<class K>
+    typename _If_transparent<K, std::pair<iterator, iterator> >::type equal_range(const K &k) {
+        return std::pair<iterator, iterator>(lower_bound_tr(k), upper_bound_tr(k));
+    }
+
+    template<class K>
+    typename _If_transparent<K, std::pair<const_iterator, const_iterator> >::type equal_range(const K &k) const {
+        return std::pair<const_iterator, const_iterator>(lower_bound_tr(k), upper_bound_tr(k));
+    }
+
+    template<class K>
+    typename _If_transparent<K, size_type>::type erase(const K &k) {
+        const size_type n = count_tr(k);
+        iterator it = lower_bound_tr(k);
+        for (size_type i = 0; i < n; ++i)
+            it = erase(it);
+        return n;
+    }
+};
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+template<class K, class... Args>
+std::pair<typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator, bool>
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::emplace_unique_key(const K &k, Args &&... args) {
+    if (!root) return std::pair<iterator, bool>(insert_first(std::forward<Args>(args)...), true);
+    path_entry path[MAX_HEIGHT];
+    // keys arriving in order go straight to the end
+    if (comp(key_at(rightmost, rightmost->count - 1), k)) {
+        rightmost_path(path);
+        return std::pair<iterator, bool>(insert_at(path, rightmost, rightmost->count, std::forward<Args>(args)...),
+                                         true);
+    }
+    leaf_node *leaf = descend<false>(k, path);
+    const size_type i = leaf_search<false>(leaf, k);
+    if (i < leaf->count) {
+        if (!comp(k, key_at(leaf, i))) return std::pair<iterator, bool>(iterator(leaf, i), false);
+    } else if (leaf->next && !comp(k, key_at(leaf->next, 0))) {
+        // k equals the separator above this leaf and sits first in the next one
+        return std::pair<iterator, bool>(iterator(leaf->next, 0), false);
+    }
+    return std::pair<iterator, bool>(insert_at(path, leaf, i, std::forward<Args>(args)...), true);
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+template<class... Args>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::emplace_equal_key(const key_type &k, Args &&... args) {
+    if (!root) return insert_first(std::forward<Args>(args)...);
+    path_entry path[MAX_HEIGHT];
+    if (!comp(k, key_at(rightmost, rightmost->count - 1))) {
+        rightmost_path(path);
+        return insert_at(path, rightmost, rightmost->count, std::forward<Args>(args)...);
+    }
+    leaf_node *leaf = descend<true>(k, path);
+    return insert_at(path, leaf, leaf_search<true>(leaf, k), std::forward<Args>(args)...);
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+template<class... Args>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::insert_at(path_entry *path, leaf_node *leaf, size_type i,
+                                                                    Args &&... args) {
+    if (leaf->count < LEAF_SLOTS) {
+        Value *v = leaf->values();
+        __btree_relocate(v + i + 1, v + i, leaf->count - i);
+        __STL_TRY {
+            construct(v + i, std::forward<Args>(args)...);
+        }
+        __STL_UNWIND(__btree_relocate(v + i, v + i + 1, leaf->count - i));
+        ++leaf->count;
+        ++num_elements;
+        return iterator(leaf, i);
+    }
+
+    leaf_node *right = new_leaf();
+    leaf_node *target;
+    size_type at;
+    if (leaf == rightmost && i == leaf->count) {
+        // appending in order leaves the full leaf as it is and starts a new one
+        __STL_TRY {
+            construct(right->values(), std::forward<Args>(args)...);
+        }
+        __STL_UNWIND(leaf_allocator::deallocate(right));
+        right->count = 1;
+        target = right;
+        at = 0;
+    } else {
+        const size_type split = LEAF_SLOTS / 2;
+        __btree_relocate(right->values(), leaf->values() + split, leaf->count - split);
+        right->count = leaf->count - split;
+        leaf->count = split;
+        target = i <= split ? leaf : right;
+        at = i <= split ? i : i - split;
+        Value *v = target->values();
+        __btree_relocate(v + at + 1, v + at, target->count - at);
+        __STL_TRY {
+            construct(v + at, std::forward<Args>(args)...);
+        }
+        __STL_UNWIND(__btree_relocate(v + at, v + at + 1, target->count - at);
+                             __btree_relocate(leaf->values() + split, right->values(), right->count);
+                             leaf->count = LEAF_SLOTS;
+                             leaf_allocator::deallocate(right));
+        ++target->count;
+    }
+    ++num_elements;
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next) leaf->next->prev = right;
+    else rightmost = right;
+    leaf->next = right;
+    insert_into_parent(path, height, key_at(right, 0), right);
+    return iterator(target, at);
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::insert_into_parent(path_entry *path, size_type depth,
+                                                                                  Key sep, node_base *right) {
+    for (;;) {
+        if (depth == 0) {
+            inner_node *r = new_inner();
+            construct(r->keys(), std::move(sep));
+            r->children[0] = root;
+            r->children[1] = right;
+            r->count = 1;
+            root = r;
+            ++height;
+            return;
+        }
+        inner_node *p = path[depth - 1].node;
+        const size_type i = path[depth - 1].index;
+        if (p->count < INNER_SLOTS) {
+            inner_insert(p, i, std::move(sep), right);
+            return;
+        }
+        // p keeps keys [0, m) and children [0, m], key m moves up, q takes the rest
+        const size_type m = INNER_SLOTS / 2;
+        inner_node *q = new_inner();
+        __btree_relocate(q->keys(), p->keys() + m + 1, p->count - m - 1);
+        std::memcpy(q->children, p->children + m + 1, (p->count - m) * sizeof(node_base *));
+        q->count = p->count - m - 1;
+        Key up(std::move(p->keys()[m]));
+        destroy(p->keys() + m);
+        p->count = m;
+        if (i <= m) inner_insert(p, i, std::move(sep), right);
+        else inner_insert(q, i - m - 1, std::move(sep), right);
+        sep = std::move(up);
+        right = q;
+        --depth;
+    }
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::erase_at(path_entry *path, leaf_node *leaf, size_type i) {
+    Value *v = leaf->values();
+    destroy(v + i);
+    __btree_relocate(v + i, v + i + 1, leaf->count - i - 1);
+    --leaf->count;
+    --num_elements;
+
+    if (height == 0) {
+        if (leaf->count == 0) {
+            leaf_allocator::deallocate(leaf);
+            root = leftmost = rightmost = nullptr;
+            return iterator(nullptr, 0);
+        }
+        return make_iterator(leaf, i);
+    }
+    if (leaf->count >= MIN_LEAF) return make_iterator(leaf, i);
+
+    // the element after the erased one, followed through the moves below
+    leaf_node *next = leaf;
+    size_type next_pos = i;
+    if (i == leaf->count) {
+        next = leaf->next;
+        next_pos = 0;
+    }
+
+    inner_node *p = path[height - 1].node;
+    const size_type idx = path[height - 1].index;
+    leaf_node *left = idx > 0 ? static_cast<leaf_node *>(p->children[idx - 1]) : nullptr;
+    leaf_node *right = idx < p->count ? static_cast<leaf_node *>(p->children[idx + 1]) : nullptr;
+    if (left && left->count > MIN_LEAF) {
+        __btree_relocate(leaf->values() + 1, leaf->values(), leaf->count);
+        __btree_relocate(leaf->values(), left->values() + left->count - 1, 1);
+        --left->count;
+        ++leaf->count;
+        p->keys()[idx - 1] = key_at(leaf, 0);
+        if (next == leaf) ++next_pos;
+    } else if (right && right->count > MIN_LEAF) {
+        __btree_relocate(leaf->values() + leaf->count, right->values(), 1);
+        ++leaf->count;
+        __btree_relocate(right->values(), right->values() + 1, right->count - 1);
+        --right->count;
+        p->keys()[idx] = key_at(right, 0);
+        if (next == right) {
+            next = leaf;
+            next_pos = leaf->count - 1;
+        }
+    } else if (left) {
+        const size_type base = left->count;
+        __btree_relocate(left->values() + base, leaf->values(), leaf->count);
+        left->count += leaf->count;
+        leaf->count = 0;
+        unlink_leaf(leaf);
+        leaf_allocator::deallocate(leaf);
+        if (next == leaf) {
+            next = left;
+            next_pos += base;
+        }
+        inner_erase(p, idx - 1);
+        rebalance_inner(path, height - 1);
+    } else {
+        const size_type base = leaf->count;
+        __btree_relocate(leaf->values() + base, right->values(), right->count);
+        leaf->count += right->count;
+        right->count = 0;
+        unlink_leaf(right);
+        leaf_allocator::deallocate(right);
+        if (next == right) {
+            next = leaf;
+            next_pos = base;
+        }
+        inner_erase(p, idx);
+        rebalance_inner(path, height - 1);
+    }
+    return next ? make_iterator(next, next_pos) : end_iterator();
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::rebalance_inner(path_entry *path, size_type d) {
+    for (;; --d) {
+        inner_node *x = path[d].node;
+        if (d == 0) {
+            if (x->count == 0) {
+                root = x->children[0];
+                inner_allocator::deallocate(x);
+                --height;
+            }
+            return;
+        }
+        if (x->count >= MIN_INNER) return;
+
+        inner_node *p = path[d - 1].node;
+        const size_type idx = path[d - 1].index;
+        inner_node *left = idx > 0 ? static_cast<inner_node *>(p->children[idx - 1]) : nullptr;
+        inner_node *right = idx < p->count ? static_cast<inner_node *>(p->children[idx + 1]) : nullptr;
+        if (left && left->count > MIN_INNER) {
+            // rotate through the parent: left's last child becomes x's first
+            __btree_relocate(x->keys() + 1, x->keys(), x->count);
+            construct(x->keys(), std::move(p->keys()[idx - 1]));
+            std::memmove(x->children + 1, x->children, (x->count + 1) * sizeof(node_base *));
+            x->children[0] = left->children[left->count];
+            ++x->count;
+            p->keys()[idx - 1] = std::move(left->keys()[left->count - 1]);
+            destroy(left->keys() + left->count - 1);
+            --left->count;
+            return;
+        }
+        if (right && right->count > MIN_INNER) {
+            construct(x->keys() + x->count, std::move(p->keys()[idx]));
+            x->children[x->count + 1] = right->children[0];
+            ++x->count;
+            p->keys()[idx] = std::move(right->keys()[0]);
+            destroy(right->keys());
+            __btree_relocate(right->keys(), right->keys() + 1, right->count - 1);
+            std::memmove(right->children, right->children + 1, right->count * sizeof(node_base *));
+            --right->count;
+            return;
+        }
+        // merge with a sibling around the parent's key between them
+        inner_node *into = left ? left : x;
+        inner_node *from = left ? x : right;
+        const size_type k = left ? idx - 1 : idx;
+        construct(into->keys() + into->count, std::move(p->keys()[k]));
+        __btree_relocate(into->keys() + into->count + 1, from->keys(), from->count);
+        std::memcpy(into->children + into->count + 1, from->children, (from->count + 1) * sizeof(node_base *));
+        into->count += from->count + 1;
+        from->count = 0;
+        inner_allocator::deallocate(from);
+        inner_erase(p, k);
+    }
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+inline bool operator==(const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes> &x,
+                       const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes> &y) {
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+inline bool operator<(const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes> &x,
+                      const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes> &y) {
+    return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+}
+
+// selects btree for map, multimap and set:  map<Key, T, Compare, Alloc, btree_backend<> >
+template<size_t NodeBytes = 256>
+struct btree_backend {
+    template<class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+    struct rebind {
+        typedef btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes> other;
+    };
+};
+
+#endif //BETHSTL_BTREE_H
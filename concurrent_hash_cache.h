@@ -0,0 +1,184 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_CONCURRENT_HASH_CACHE_H
+#define BETHSTL_CONCURRENT_HASH_CACHE_H
+
+#include "hash_cache.h"
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+
+// concurrent_hash_cache splits its capacity over a power of two number of shards, each an
+// ordinary hash_cache behind its own reader/writer lock, picked by the high bits of the
+// hash code as in concurrent_hash_map.
+//
+// with the default clock_eviction a hit only sets the entry's referenced flag, so get()
+// takes the shard's read lock and hits in one shard never wait for each other; misses,
+// put() and erase() take the write lock, and the clock hand only moves under it. with a
+// policy that reorders on a hit, such as lru_eviction, get() takes the write lock too.
+//
+// eviction is per shard: a put evicts from the key's shard, the least recently used entry
+// of the whole cache may survive a while longer. the eviction callback runs under the
+// shard's write lock and must not call back into the cache.
+template<class Key, class T, class Policy = clock_eviction, class HashFunc = hash<Key>,
+        class EqualKey = std::equal_to<Key>, class Alloc = malloc_alloc>
+class concurrent_hash_cache {
+private:
+    typedef hash_cache<Key, T, Policy, HashFunc, EqualKey, Alloc> cache;
+    typedef std::shared_lock<std::shared_mutex> read_lock;
+    typedef std::unique_lock<std::shared_mutex> write_lock;
+
+public:
+    typedef typename cache::key_type key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef typename cache::value_type value_type;
+    typedef typename cache::hasher hasher;
+    typedef typename cache::key_equal key_equal;
+    typedef typename cache::size_type size_type;
+    typedef typename cache::policy_type policy_type;
+    typedef typename cache::eviction_callback eviction_callback;
+
+private:
+    // one shard per cache line so that two locks never share a line
+    struct alignas(64) shard {
+        mutable std::shared_mutex lock;
+        cache entries;
+
+        shard(const hasher &hf, const key_equal &eql) : entries(0, hf, eql) {}
+    };
+
+    hasher hash;
+    key_equal equals;
+    shard *shards;
+    size_type shard_bits;
+    size_type max_entries;
+
+    shard &shard_for(const key_type &key) const {
+        if (shard_bits == 0) return shards[0];
+        const size_type mixed = hash(key) * (size_type) 0x9E3779B97F4A7C15ull;
+        return shards[mixed >> (sizeof(size_type) * 8 - shard_bits)];
+    }
+
+    // shards are built in place so that each cache, tinylfu's sketch included, hashes keys
+    // with the cache's own hasher
+    static shard *allocate_shards(size_type n) {
+        return static_cast<shard *>(::operator new(n * sizeof(shard), std::align_val_t(alignof(shard))));
+    }
+
+    static void deallocate_shards(shard *p) { ::operator delete(p, std::align_val_t(alignof(shard))); }
+
+    static bool copy_out(cache &c, const key_type &key, mapped_type &result) {
+        const mapped_type *v = c.get(key);
+        if (!v) return false;
+        result = *v;
+        return true;
+    }
+
+public:
+    // shard_count is rounded up to a power of two, every shard holds capacity / shard_count
+    // entries, rounded up
+    explicit concurrent_hash_cache(size_type capacity, size_type shard_count = 64, const hasher &hf = hasher(),
+                                   const key_equal &eql = key_equal())
+            : hash(hf), equals(eql), shards(nullptr), shard_bits(0), max_entries(0) {
+        while (((size_type) 1 << shard_bits) < shard_count) ++shard_bits;
+        const size_type n = (size_type) 1 << shard_bits;
+        shards = allocate_shards(n);
+        size_type i = 0;
+        try {
+            for (; i < n; ++i) construct(&shards[i], hash, equals);
+            set_capacity(capacity);
+        } catch (...) {
+            while (i > 0) destroy(&shards[--i]);
+            deallocate_shards(shards);
+            throw;
+        }
+    }
+
+    ~concurrent_hash_cache() {
+        for (size_type i = 0; i < shard_count(); ++i) destroy(&shards[i]);
+        deallocate_shards(shards);
+    }
+
+    concurrent_hash_cache(const concurrent_hash_cache &) = delete;
+
+    concurrent_hash_cache &operator=(const concurrent_hash_cache &) = delete;
+
+    size_type shard_count() const { return (size_type) 1 << shard_bits; }
+
+    size_type capacity() const { return max_entries; }
+
+    hasher hash_function() const { return hash; }
+
+    key_equal key_eq() const { return equals; }
+
+    // sum of the shard sizes, each one read under its lock
+    size_type size() const {
+        size_type result = 0;
+        for (size_type i = 0; i < shard_count(); ++i) {
+            read_lock guard(shards[i].lock);
+            result += shards[i].entries.size();
+        }
+        return result;
+    }
+
+    bool empty() const { return 0 == size(); }
+
+    // copy the value out and count the hit, a reference would outlive the shard lock
+    bool get(const key_type &key, mapped_type &result) {
+        shard &s = shard_for(key);
+        if (policy_type::SHARED_TOUCH) {
+            read_lock guard(s.lock);
+            return copy_out(s.entries, key, result);
+        }
+        write_lock guard(s.lock);
+        return copy_out(s.entries, key, result);
+    }
+
+    bool contains(const key_type &key) const {
+        const shard &s = shard_for(key);
+        read_lock guard(s.lock);
+        return s.entries.contains(key);
+    }
+
+    // inserts or assigns; false when the policy turned the key away
+    template<class M>
+    bool put(const key_type &key, M &&obj) {
+        shard &s = shard_for(key);
+        write_lock guard(s.lock);
+        return s.entries.put(key, std::forward<M>(obj));
+    }
+
+    size_type erase(const key_type &key) {
+        shard &s = shard_for(key);
+        write_lock guard(s.lock);
+        return s.entries.erase(key);
+    }
+
+    void set_eviction_callback(const eviction_callback &f) {
+        for (size_type i = 0; i < shard_count(); ++i) {
+            write_lock guard(shards[i].lock);
+            shards[i].entries.set_eviction_callback(f);
+        }
+    }
+
+    void set_capacity(size_type capacity) {
+        max_entries = capacity;
+        const size_type per_shard = (capacity + shard_count() - 1) / shard_count();
+        for (size_type i = 0; i < shard_count(); ++i) {
+            write_lock guard(shards[i].lock);
+            shards[i].entries.set_capacity(per_shard);
+        }
+    }
+
+    void clear() {
+        for (size_type i = 0; i < shard_count(); ++i) {
+            write_lock guard(shards[i].lock);
+            shards[i].entries.clear();
+        }
+    }
+};
+
+#endif //BETHSTL_CONCURRENT_HASH_CACHE_H
@@ -0,0 +1,171 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_CONCURRENT_HASHMAP_H
+#define BETHSTL_CONCURRENT_HASHMAP_H
+
+#include "function.h"
+#include "hashtable.h"
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <tuple>
+
+// concurrent_hash_map stripes the keyspace over a power of two number of shards.
+// Every shard is an ordinary hash_table guarded by its own reader/writer lock, so
+// readers of one shard never block each other and writers only block their shard.
+// The shard is picked from the high bits of the (mixed) hash code, the low bits are
+// left to the prime modulo inside the shard's hash_table.
+// The default freeList_alloc keeps unguarded static free lists, so shards allocate
+// through malloc_alloc unless a thread safe allocator is given.
+template<class Key, class T, class HashFunc = hash<Key>, class EqualKey = std::equal_to<Key>, class Alloc = malloc_alloc>
+class concurrent_hash_map {
+private:
+    typedef hash_table<std::pair<const Key, T>, Key, HashFunc, Select1st<std::pair<const Key, T> >, EqualKey, Alloc> ht;
+    typedef std::shared_lock<std::shared_mutex> read_lock;
+    typedef std::unique_lock<std::shared_mutex> write_lock;
+
+public:
+    typedef typename ht::key_type key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef typename ht::value_type value_type;
+    typedef typename ht::hasher hasher;
+    typedef typename ht::key_equal key_equal;
+    typedef typename ht::size_type size_type;
+
+private:
+    // one shard per cache line so that two locks never share a line
+    struct alignas(64) shard {
+        mutable std::shared_mutex lock;
+        ht table;
+
+        shard(const hasher &hf, const key_equal &eql) : table(100, hf, eql) {}
+    };
+
+    hasher hash;
+    key_equal equals;
+    shard *shards;
+    size_type shard_bits;
+
+    // shards are built in place so that each table gets the map's hasher and key_equal
+    static shard *allocate_shards(size_type n) {
+        return static_cast<shard *>(::operator new(n * sizeof(shard), std::align_val_t(alignof(shard))));
+    }
+
+    static void deallocate_shards(shard *p) { ::operator delete(p, std::align_val_t(alignof(shard))); }
+
+    shard &shard_for(const key_type &key) const {
+        if (shard_bits == 0) return shards[0];
+        // fibonacci hashing spreads identity-like hashes (std::hash<int>) into the high bits
+        const size_type mixed = hash(key) * (size_type) 0x9E3779B97F4A7C15ull;
+        return shards[mixed >> (sizeof(size_type) * 8 - shard_bits)];
+    }
+
+public:
+    // shard_count is rounded up to a power of two
+    explicit concurrent_hash_map(size_type shard_count = 64, const hasher &hf = hasher(),
+                                 const key_equal &eql = key_equal())
+            : hash(hf), equals(eql), shards(nullptr), shard_bits(0) {
+        while (((size_type) 1 << shard_bits) < shard_count) ++shard_bits;
+        const size_type n = (size_type) 1 << shard_bits;
+        shards = allocate_shards(n);
+        size_type i = 0;
+        try {
+            for (; i < n; ++i) construct(&shards[i], hash, equals);
+        } catch (...) {
+            while (i > 0) destroy(&shards[--i]);
+            deallocate_shards(shards);
+            throw;
+        }
+    }
+
+    ~concurrent_hash_map() {
+        for (size_type i = 0; i < shard_count(); ++i) destroy(&shards[i]);
+        deallocate_shards(shards);
+    }
+
+    concurrent_hash_map(const concurrent_hash_map &) = delete;
+
+    concurrent_hash_map &operator=(const concurrent_hash_map &) = delete;
+
+    size_type shard_count() const { return (size_type) 1 << shard_bits; }
+
+    hasher hash_function() const { return hash; }
+
+    key_equal key_eq() const { return equals; }
+
+    // sum of the shard sizes, each one read under its lock
+    size_type size() const {
+        size_type result = 0;
+        for (size_type i = 0; i < shard_count(); ++i) {
+            read_lock guard(shards[i].lock);
+            result += shards[i].table.size();
+        }
+        return result;
+    }
+
+    bool empty() const { return 0 == size(); }
+
+    // copy the mapped value out, a reference would outlive the shard lock
+    bool find(const key_type &key, mapped_type &result) const {
+        const shard &s = shard_for(key);
+        read_lock guard(s.lock);
+        typename ht::const_iterator it = s.table.find(key);
+        if (it == s.table.end()) return false;
+        result = it->second;
+        return true;
+    }
+
+    bool contains(const key_type &key) const {
+        const shard &s = shard_for(key);
+        read_lock guard(s.lock);
+        return s.table.count(key) != 0;
+    }
+
+    // returns false and leaves the map untouched if key is already present
+    bool insert(const value_type &value) {
+        shard &s = shard_for(value.first);
+        write_lock guard(s.lock);
+        return s.table.try_emplace_unique(value.first, value).second;
+    }
+
+    size_type erase(const key_type &key) {
+        shard &s = shard_for(key);
+        write_lock guard(s.lock);
+        return s.table.erase(key);
+    }
+
+    // inserts a default constructed T when key is missing, then calls fn(mapped_type &)
+    // while the shard is still locked. returns true if key was inserted.
+    template<class Fn>
+    bool upsert(const key_type &key, Fn fn) {
+        shard &s = shard_for(key);
+        write_lock guard(s.lock);
+        std::pair<typename ht::iterator, bool> result = s.table.try_emplace_unique(
+                key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+        fn(result.first->second);
+        return result.second;
+    }
+
+    // visits every element; each shard is seen as one consistent snapshot because its
+    // read lock is held while it is walked. fn must not call back into this map.
+    template<class Fn>
+    void for_each(Fn fn) const {
+        for (size_type i = 0; i < shard_count(); ++i) {
+            read_lock guard(shards[i].lock);
+            for (typename ht::const_iterator it = shards[i].table.begin(); it != shards[i].table.end(); ++it)
+                fn(*it);
+        }
+    }
+
+    void clear() {
+        for (size_type i = 0; i < shard_count(); ++i) {
+            write_lock guard(shards[i].lock);
+            shards[i].table.clear();
+        }
+    }
+};
+
+#endif //BETHSTL_CONCURRENT_HASHMAP_H
@@ -0,0 +1,524 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_CONCURRENT_SKIPLIST_H
+#define BETHSTL_CONCURRENT_SKIPLIST_H
+
+#include "alloc.h"
+#include "construct.h"
+#include "epoch.h"
+#include "iterator.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+
+// concurrent_skiplist is an ordered container shared between threads, the base of
+// concurrent_map and concurrent_set. it is the lazy skip list of Herlihy, Lev, Luchangco and
+// Shavit: a search takes no lock at all, and a writer locks only the few nodes in front of
+// the key it changes, so writers to different parts of the key range do not wait for each
+// other.
+//
+// every node carries two flags. linked is set once an insert has linked the node on all of
+// its levels, marked once an erase has claimed it; a node is in the set between the two.
+// an insert locks the predecessors on each level, checks they are still unmarked and still
+// point at the successors it found, and links the new node bottom up. an erase marks the node
+// under its own lock, then locks and checks the predecessors and unlinks it top down. next
+// links of an erased node are never changed, so a reader standing on it can still move on.
+//
+// readers traverse inside an epoch read section and unlinked nodes are retired through the
+// epoch_domain, so memory is reclaimed only once no reader can hold it. a node is retired
+// only after it is unlinked on every level, and a marked node fails every writer's check, so
+// nothing can link it again. values are never modified in place; replace by erase and insert.
+template<class Key, class Value, class KeyOfValue, class Compare>
+class concurrent_skiplist {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef Compare key_compare;
+    typedef size_t size_type;
+
+private:
+    enum {
+        MAX_HEIGHT = 16
+    };
+
+    struct node {
+        std::atomic<bool> locked;
+        std::atomic<bool> marked;
+        std::atomic<bool> linked;
+        int height;
+        Value val;
+        // height links, allocated past the end of the node
+        std::atomic<node *> next[1];
+    };
+
+    static size_type node_bytes(int height) { return sizeof(node) + (height - 1) * sizeof(std::atomic<node *>); }
+
+    key_compare comp;
+    KeyOfValue get_key;
+    node *head;
+    // levels in use, searches start here instead of at MAX_HEIGHT
+    std::atomic<int> levels;
+    std::atomic<size_type> num_elements;
+    mutable epoch_domain epochs;
+
+    // the flags and links start their lifetime here, in raw memory; val is left to the caller
+    static node *allocate_node(int height) {
+        node *n = (node *) malloc_alloc::allocate(node_bytes(height));
+        construct(&n->locked, false);
+        construct(&n->marked, false);
+        construct(&n->linked, false);
+        n->height = height;
+        for (int l = 0; l < height; ++l) construct(&n->next[l], (node *) nullptr);
+        return n;
+    }
+
+    static void deallocate_node(node *n) {
+        for (int l = 0; l < n->height; ++l) destroy(&n->next[l]);
+        destroy(&n->linked);
+        destroy(&n->marked);
+        destroy(&n->locked);
+        malloc_alloc::deallocate(n, node_bytes(n->height));
+    }
+
+    static node *new_node(int height, const value_type &v) {
+        node *n = allocate_node(height);
+        try {
+            construct(&n->val, v);
+        } catch (...) {
+            deallocate_node(n);
+            throw;
+        }
+        return n;
+    }
+
+    static void delete_node(void *p) {
+        node *n = (node *) p;
+        destroy(&n->val);
+        deallocate_node(n);
+    }
+
+    static void lock(node *n) {
+        while (n->locked.exchange(true, std::memory_order_acquire)) {
+            while (n->locked.load(std::memory_order_relaxed)) std::this_thread::yield();
+        }
+    }
+
+    static void unlock(node *n) { n->locked.store(false, std::memory_order_release); }
+
+    // unlocks preds[0 .. top], each node once; a node that precedes the key on several levels
+    // appears in consecutive entries
+    static void unlock_preds(node **preds, int top) {
+        node *prev = nullptr;
+        for (int l = 0; l <= top; ++l) {
+            if (preds[l] != prev) unlock(preds[l]);
+            prev = preds[l];
+        }
+    }
+
+    // a geometric height, one more level with probability 1/4
+    static int random_height() {
+        static thread_local uint64_t state =
+                std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        uint64_t r = state;
+        int h = 1;
+        while (h < MAX_HEIGHT && (r & 3) == 0) {
+            ++h;
+            r >>= 2;
+        }
+        return h;
+    }
+
+    const key_type &key(const node *n) const { return get_key(n->val); }
+
+    // fills preds and succs on every level around k and returns the highest level whose
+    // successor has key k, or -1
+    int find_preds(const key_type &k, node **preds, node **succs) const {
+        int found = -1;
+        node *pred = head;
+        for (int l = MAX_HEIGHT - 1; l >= 0; --l) {
+            node *cur = pred->next[l].load(std::memory_order_acquire);
+            while (cur && comp(key(cur), k)) {
+                pred = cur;
+                cur = pred->next[l].load(std::memory_order_acquire);
+            }
+            if (found == -1 && cur && !comp(k, key(cur))) found = l;
+            preds[l] = pred;
+            succs[l] = cur;
+        }
+        return found;
+    }
+
+    // the first node, live or not, whose key is not less than k (upper: greater than k)
+    node *search(const key_type &k, bool upper) const {
+        node *pred = head;
+        for (int l = levels.load(std::memory_order_acquire) - 1; l >= 0; --l) {
+            node *cur = pred->next[l].load(std::memory_order_acquire);
+            while (cur && (upper ? !comp(k, key(cur)) : comp(key(cur), k))) {
+                pred = cur;
+                cur = pred->next[l].load(std::memory_order_acquire);
+            }
+        }
+        return pred->next[0].load(std::memory_order_acquire);
+    }
+
+    static bool live(const node *n) {
+        return n->linked.load(std::memory_order_acquire) && !n->marked.load(std::memory_order_acquire);
+    }
+
+    static node *skip_dead(node *n) {
+        while (n && !live(n)) n = n->next[0].load(std::memory_order_acquire);
+        return n;
+    }
+
+    // claims and unlinks the node with key k and returns it, or null when there is none or
+    // another erase got it first. called inside a read section; the caller retires the node
+    // after leaving it.
+    node *unlink(const key_type &k);
+
+    void raise_levels(int height) {
+        int cur = levels.load(std::memory_order_relaxed);
+        while (cur < height && !levels.compare_exchange_weak(cur, height, std::memory_order_release)) {}
+    }
+
+public:
+    // forward iteration in key order over the nodes live when it passes them. only valid
+    // inside the reader that produced it.
+    class const_iterator {
+        friend class concurrent_skiplist;
+
+    private:
+        node *cur;
+
+        explicit const_iterator(node *n) : cur(n) {}
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef Value value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const Value *pointer;
+        typedef const Value &reference;
+
+        const_iterator() : cur(nullptr) {}
+
+        reference operator*() const { return cur->val; }
+
+        pointer operator->() const { return &cur->val; }
+
+        const_iterator &operator++() {
+            cur = skip_dead(cur->next[0].load(std::memory_order_acquire));
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const const_iterator &x) const { return cur == x.cur; }
+
+        bool operator!=(const const_iterator &x) const { return cur != x.cur; }
+    };
+
+    // an epoch read section over the list. iterators and references obtained through it stay
+    // valid until it is destroyed; they see inserts and erases made meanwhile or not, but
+    // always keys in order. the owning thread must not insert or erase while it holds one.
+    class reader {
+    private:
+        const concurrent_skiplist *list;
+        epoch_domain::read_guard guard;
+
+    public:
+        explicit reader(const concurrent_skiplist &l) : list(&l), guard(l.epochs) {}
+
+        const_iterator begin() const {
+            return const_iterator(skip_dead(list->head->next[0].load(std::memory_order_acquire)));
+        }
+
+        const_iterator end() const { return const_iterator(); }
+
+        const_iterator find(const key_type &k) const {
+            node *n = skip_dead(list->search(k, false));
+            return n && !list->comp(k, list->key(n)) ? const_iterator(n) : end();
+        }
+
+        const_iterator lower_bound(const key_type &k) const { return const_iterator(skip_dead(list->search(k, false))); }
+
+        const_iterator upper_bound(const key_type &k) const { return const_iterator(skip_dead(list->search(k, true))); }
+    };
+
+    explicit concurrent_skiplist(const Compare &c = Compare())
+            : comp(c), head(allocate_node(MAX_HEIGHT)), levels(1), num_elements(0) {
+        head->linked.store(true, std::memory_order_relaxed);
+    }
+
+    ~concurrent_skiplist() {
+        epochs.barrier();
+        node *n = head->next[0].load(std::memory_order_relaxed);
+        while (n) {
+            node *next = n->next[0].load(std::memory_order_relaxed);
+            delete_node(n);
+            n = next;
+        }
+        deallocate_node(head);
+    }
+
+    concurrent_skiplist(const concurrent_skiplist &) = delete;
+
+    concurrent_skiplist &operator=(const concurrent_skiplist &) = delete;
+
+    key_compare key_comp() const { return comp; }
+
+    // the count of completed inserts less completed erases, exact only when writers are quiet
+    size_type size() const { return num_elements.load(std::memory_order_relaxed); }
+
+    bool empty() const { return 0 == size(); }
+
+    bool contains(const key_type &k) const {
+        reader r(*this);
+        return r.find(k) != r.end();
+    }
+
+    // returns false and leaves the list untouched if the key is already present
+    bool insert(const value_type &v);
+
+    size_type erase(const key_type &k);
+
+    // erases the keys one by one, concurrent inserts may survive it
+    void clear();
+};
+
+template<class Key, class Value, class KeyOfValue, class Compare>
+bool concurrent_skiplist<Key, Value, KeyOfValue, Compare>::insert(const value_type &v) {
+    const key_type &k = get_key(v);
+    const int height = random_height();
+    node *preds[MAX_HEIGHT];
+    node *succs[MAX_HEIGHT];
+    epoch_domain::read_guard guard(epochs);
+    for (;;) {
+        const int found = find_preds(k, preds, succs);
+        if (found != -1) {
+            node *n = succs[found];
+            if (!n->marked.load(std::memory_order_acquire)) {
+                // present, or about to be: wait for its insert to finish so that a false
+                // return is never followed by a lookup that misses the key
+                while (!n->linked.load(std::memory_order_acquire)) std::this_thread::yield();
+                return false;
+            }
+            // being erased, look again once it is gone
+            continue;
+        }
+        int top = -1;
+        bool valid = true;
+        node *prev = nullptr;
+        for (int l = 0; valid && l < height; ++l) {
+            node *pred = preds[l];
+            node *succ = succs[l];
+            if (pred != prev) {
+                lock(pred);
+                prev = pred;
+            }
+            top = l;
+            valid = !pred->marked.load(std::memory_order_acquire) &&
+                    (!succ || !succ->marked.load(std::memory_order_acquire)) &&
+                    pred->next[l].load(std::memory_order_acquire) == succ;
+        }
+        if (!valid) {
+            unlock_preds(preds, top);
+            continue;
+        }
+        node *n;
+        try {
+            n = new_node(height, v);
+        } catch (...) {
+            unlock_preds(preds, top);
+            throw;
+        }
+        for (int l = 0; l < height; ++l) n->next[l].store(succs[l], std::memory_order_relaxed);
+        for (int l = 0; l < height; ++l) preds[l]->next[l].store(n, std::memory_order_release);
+        n->linked.store(true, std::memory_order_release);
+        unlock_preds(preds, top);
+        raise_levels(height);
+        num_elements.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare>
+typename concurrent_skiplist<Key, Value, KeyOfValue, Compare>::node *
+concurrent_skiplist<Key, Value, KeyOfValue, Compare>::unlink(const key_type &k) {
+    node *preds[MAX_HEIGHT];
+    node *succs[MAX_HEIGHT];
+    node *victim = nullptr;
+    for (;;) {
+        const int found = find_preds(k, preds, succs);
+        if (!victim) {
+            // only a node found on its top level is fully linked and may be claimed
+            if (found == -1) return nullptr;
+            node *n = succs[found];
+            if (!n->linked.load(std::memory_order_acquire) || n->height - 1 != found ||
+                n->marked.load(std::memory_order_acquire))
+                return nullptr;
+            lock(n);
+            if (n->marked.load(std::memory_order_relaxed)) {
+                unlock(n);
+                return nullptr;
+            }
+            n->marked.store(true, std::memory_order_release);
+            victim = n;
+        }
+        const int height = victim->height;
+        int top = -1;
+        bool valid = true;
+        node *prev = nullptr;
+        for (int l = 0; valid && l < height; ++l) {
+            node *pred = preds[l];
+            if (pred != prev) {
+                lock(pred);
+                prev = pred;
+            }
+            top = l;
+            valid = !pred->marked.load(std::memory_order_acquire) &&
+                    pred->next[l].load(std::memory_order_acquire) == victim;
+        }
+        if (!valid) {
+            unlock_preds(preds, top);
+            continue;
+        }
+        for (int l = height - 1; l >= 0; --l)
+            preds[l]->next[l].store(victim->next[l].load(std::memory_order_relaxed), std::memory_order_release);
+        unlock(victim);
+        unlock_preds(preds, top);
+        num_elements.fetch_sub(1, std::memory_order_relaxed);
+        return victim;
+    }
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare>
+typename concurrent_skiplist<Key, Value, KeyOfValue, Compare>::size_type
+concurrent_skiplist<Key, Value, KeyOfValue, Compare>::erase(const key_type &k) {
+    node *victim;
+    {
+        epoch_domain::read_guard guard(epochs);
+        victim = unlink(k);
+    }
+    if (!victim) return 0;
+    epochs.retire(victim, &delete_node);
+    return 1;
+}
+
+template<class Key, class Value, class KeyOfValue, class Compare>
+void concurrent_skiplist<Key, Value, KeyOfValue, Compare>::clear() {
+    for (;;) {
+        node *victim;
+        {
+            epoch_domain::read_guard guard(epochs);
+            node *n = skip_dead(head->next[0].load(std::memory_order_acquire));
+            if (!n) return;
+            // n stays readable while the guard is held, even if another thread erases it first
+            victim = unlink(key(n));
+        }
+        if (victim) epochs.retire(victim, &delete_node);
+    }
+}
+
+// a map shared between threads, ordered by Compare. find() copies the mapped value out;
+// lower_bound, upper_bound and range scans go through a reader.
+template<class Key, class T, class Compare = std::less<Key> >
+class concurrent_map {
+private:
+    struct key_of_value {
+        const Key &operator()(const std::pair<const Key, T> &x) const { return x.first; }
+    };
+
+    typedef concurrent_skiplist<Key, std::pair<const Key, T>, key_of_value, Compare> rep_type;
+    rep_type t;
+
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef Compare key_compare;
+    typedef size_t size_type;
+    typedef typename rep_type::const_iterator const_iterator;
+
+    class reader : public rep_type::reader {
+    public:
+        explicit reader(const concurrent_map &m) : rep_type::reader(m.t) {}
+    };
+
+    explicit concurrent_map(const Compare &comp = Compare()) : t(comp) {}
+
+    key_compare key_comp() const { return t.key_comp(); }
+
+    size_type size() const { return t.size(); }
+
+    bool empty() const { return t.empty(); }
+
+    bool contains(const key_type &k) const { return t.contains(k); }
+
+    bool find(const key_type &k, mapped_type &result) const {
+        reader r(*this);
+        const_iterator it = r.find(k);
+        if (it == r.end()) return false;
+        result = it->second;
+        return true;
+    }
+
+    bool insert(const value_type &x) { return t.insert(x); }
+
+    size_type erase(const key_type &k) { return t.erase(k); }
+
+    void clear() { t.clear(); }
+};
+
+// a set shared between threads, ordered by Compare
+template<class Key, class Compare = std::less<Key> >
+class concurrent_set {
+private:
+    struct key_of_value {
+        const Key &operator()(const Key &x) const { return x; }
+    };
+
+    typedef concurrent_skiplist<Key, Key, key_of_value, Compare> rep_type;
+    rep_type t;
+
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef size_t size_type;
+    typedef typename rep_type::const_iterator const_iterator;
+
+    class reader : public rep_type::reader {
+    public:
+        explicit reader(const concurrent_set &s) : rep_type::reader(s.t) {}
+    };
+
+    explicit concurrent_set(const Compare &comp = Compare()) : t(comp) {}
+
+    key_compare key_comp() const { return t.key_comp(); }
+
+    size_type size() const { return t.size(); }
+
+    bool empty() const { return t.empty(); }
+
+    bool contains(const key_type &k) const { return t.contains(k); }
+
+    bool insert(const value_type &x) { return t.insert(x); }
+
+    size_type erase(const key_type &k) { return t.erase(k); }
+
+    void clear() { t.clear(); }
+};
+
+#endif //BETHSTL_CONCURRENT_SKIPLIST_H
@@ -118,6 +118,10 @@
 // * exception-related macros (__STL_TRY, __STL_UNWIND, etc.)
 // * __stl_assert, either as a test or as a null macro, depending on
 //   whether or not __STL_ASSERTIONS is defined.
+// * __stl_prefetch, a cache prefetch hint where the compiler has one and
+//   a null macro elsewhere.
+// * __STL_CONSTEXPR, constexpr where the compiler has C++14 relaxed
+//   constexpr functions, and plain inline before that.
 
 # if defined(_PTHREADS) && !defined(_NOTHREADS)
 #     define __STL_PTHREADS
@@ -532,6 +536,18 @@ typedef int bool;
 # define __stl_assert(expr)
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+# define __stl_prefetch(addr) __builtin_prefetch(addr)
+#else
+# define __stl_prefetch(addr)
+#endif
+
+#if __cplusplus >= 201402L
+# define __STL_CONSTEXPR constexpr
+#else
+# define __STL_CONSTEXPR inline
+#endif
+
 #if defined(__STL_WIN32THREADS) || defined(__STL_SGI_THREADS) \
     || defined(__STL_PTHREADS)  || defined(__STL_UITHREADS)
 #   define __STL_THREADS
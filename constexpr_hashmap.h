@@ -0,0 +1,183 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_CONSTEXPR_HASHMAP_H
+#define BETHSTL_CONSTEXPR_HASHMAP_H
+
+#include "hash_fun.h"
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// constexpr_hash_map is a read only map over N keys known at compile time, keyword tables and
+// the like. the constructor is constexpr (C++17), so a constexpr or static instance carries its
+// perfect hash and its values in the binary and needs no initialization at run time.
+//
+// the hash is the same hash-and-displace scheme as static_hash_map, sized in powers of two:
+// the code picks one of BUCKETS seeds and the seed picks one of SLOTS slots with a mask. a
+// slot holds the index of its value, and an empty slot the index of a value that lives in
+// another slot, so a lookup is the hash, two masks, two small loads and one key compare.
+//
+// HashFunc and EqualKey are the hash_map ones, but must be usable in a constant expression:
+// hash<Key> is for integers and string_views. repeated keys and distinct keys with the same
+// code throw, which at compile time stops the build.
+template<class Key, class T, size_t N, class HashFunc = hash<Key>, class EqualKey = std::equal_to<Key> >
+class constexpr_hash_map {
+    static_assert(N > 0, "constexpr_hash_map needs at least one key");
+
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef HashFunc hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef const value_type *pointer;
+    typedef const value_type *const_pointer;
+    typedef const value_type &reference;
+    typedef const value_type &const_reference;
+    typedef const value_type *iterator;
+    typedef const value_type *const_iterator;
+
+private:
+    static constexpr size_type ceil2(size_type n) {
+        size_type r = 1;
+        while (r < n) r <<= 1;
+        return r;
+    }
+
+    // at least a fifth of the slots stay empty, two keys per seed on average
+    static constexpr size_type SLOTS = ceil2(N + N / 4 + 1);
+    static constexpr size_type BUCKETS = ceil2(N / 2 + 1);
+
+    // the narrowest type that indexes N values
+    typedef typename std::conditional<(N <= 0xff), uint8_t,
+            typename std::conditional<(N <= 0xffff), uint16_t, uint32_t>::type>::type index_type;
+
+    hasher hash;
+    key_equal equals;
+    value_type items[N];
+    uint32_t seeds[BUCKETS];
+    index_type slot_item[SLOTS];
+
+    static constexpr size_type bucket_of(uint64_t code) { return (size_type) (hash_int(code) & (BUCKETS - 1)); }
+
+    static constexpr size_type slot_of(uint64_t code, uint32_t seed) {
+        return (size_type) (hash_mix(code ^ __stl_hash_k2, (seed + 1ull) * __stl_hash_k3) & (SLOTS - 1));
+    }
+
+    template<size_t... I>
+    constexpr constexpr_hash_map(const value_type (&init)[N], std::index_sequence<I...>,
+                                 const hasher &hf, const key_equal &eql)
+            : hash(hf), equals(eql), items{init[I]...}, seeds{}, slot_item{} { build(); }
+
+    constexpr void build();
+
+public:
+    constexpr explicit constexpr_hash_map(const value_type (&init)[N], const hasher &hf = hasher(),
+                                          const key_equal &eql = key_equal())
+            : constexpr_hash_map(init, std::make_index_sequence<N>(), hf, eql) {}
+
+    constexpr hasher hash_function() const { return hash; }
+
+    constexpr key_equal key_eq() const { return equals; }
+
+    constexpr size_type size() const { return N; }
+
+    constexpr size_type max_size() const { return N; }
+
+    constexpr bool empty() const { return false; }
+
+    constexpr size_type bucket_count() const { return SLOTS; }
+
+    constexpr const_iterator begin() const { return items; }
+
+    constexpr const_iterator end() const { return items + N; }
+
+    constexpr const_iterator find(const key_type &key) const {
+        const uint64_t code = hash(key);
+        const value_type *v = items + slot_item[slot_of(code, seeds[bucket_of(code)])];
+        return equals(v->first, key) ? v : end();
+    }
+
+    constexpr size_type count(const key_type &key) const { return find(key) != end() ? 1 : 0; }
+
+    constexpr bool contains(const key_type &key) const { return find(key) != end(); }
+
+    constexpr const T &at(const key_type &key) const {
+        const_iterator it = find(key);
+        if (it == end()) throw std::out_of_range("constexpr_hash_map::at");
+        return it->second;
+    }
+};
+
+template<class Key, class T, size_t N, class HashFunc, class EqualKey>
+constexpr void constexpr_hash_map<Key, T, N, HashFunc, EqualKey>::build() {
+    uint64_t codes[N] = {};
+    size_type first[BUCKETS + 1] = {};
+    for (size_type i = 0; i < N; ++i) {
+        codes[i] = hash(items[i].first);
+        ++first[bucket_of(codes[i]) + 1];
+    }
+    size_type largest = 0;
+    for (size_type b = 0; b < BUCKETS; ++b) {
+        if (first[b + 1] > largest) largest = first[b + 1];
+        first[b + 1] += first[b];
+    }
+
+    // keys grouped by bucket, in input order within a bucket
+    size_type members[N] = {};
+    size_type fill[BUCKETS] = {};
+    for (size_type i = 0; i < N; ++i) {
+        const size_type b = bucket_of(codes[i]);
+        members[first[b] + fill[b]++] = i;
+    }
+    for (size_type b = 0; b < BUCKETS; ++b)
+        for (size_type j = first[b]; j < first[b + 1]; ++j)
+            for (size_type k = first[b]; k < j; ++k)
+                if (codes[members[j]] == codes[members[k]]) {
+                    if (equals(items[members[j]].first, items[members[k]].first))
+                        throw std::invalid_argument("constexpr_hash_map: repeated key");
+                    throw std::invalid_argument("constexpr_hash_map: two keys with the same hash code");
+                }
+
+    // largest bucket first, each takes the first seed that puts all of its keys in free slots
+    bool taken[SLOTS] = {};
+    size_type item_slot[N] = {};
+    for (size_type n = largest; n > 0; --n)
+        for (size_type b = 0; b < BUCKETS; ++b) {
+            if (first[b + 1] - first[b] != n) continue;
+            for (uint32_t seed = 0;; ++seed) {
+                size_type j = first[b];
+                for (; j < first[b + 1]; ++j) {
+                    const size_type s = slot_of(codes[members[j]], seed);
+                    if (taken[s]) break;
+                    taken[s] = true;
+                    item_slot[members[j]] = s;
+                }
+                if (j == first[b + 1]) {
+                    seeds[b] = seed;
+                    break;
+                }
+                while (j-- > first[b])
+                    taken[item_slot[members[j]]] = false;
+            }
+        }
+
+    // empty slots keep index 0, whose key lives elsewhere and so never matches there
+    for (size_type i = 0; i < N; ++i)
+        slot_item[item_slot[i]] = (index_type) i;
+}
+
+template<class Key, class T, class HashFunc = hash<Key>, class EqualKey = std::equal_to<Key>, size_t N>
+constexpr constexpr_hash_map<Key, T, N, HashFunc, EqualKey>
+make_constexpr_hash_map(const std::pair<const Key, T> (&items)[N]) {
+    return constexpr_hash_map<Key, T, N, HashFunc, EqualKey>(items);
+}
+
+#endif //BETHSTL_CONSTEXPR_HASHMAP_H
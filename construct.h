@@ -6,6 +6,8 @@
 #define BETHSTL_CONSTRUCT_H
 
 #include "type_traits.h"
+#include "iterator.h"
+#include <utility>
 
 template<class T>
 inline void construct(T *pointer) {
@@ -17,16 +19,27 @@ inline void construct(T1 *pointer, T2 &value) {
     new((void *) pointer)T1(value);
 }
 
+// construct in place from any constructor arguments, used by the emplace family
+template<class T, class... Args>
+inline void construct(T *pointer, Args &&... args) {
+    new((void *) pointer)T(std::forward<Args>(args)...);
+}
+
 template<class T>
 inline void destroy(T *pointer) {
     pointer->~T();
 }
 
-template<class ForwardIterator, class T>
-inline void destroy(ForwardIterator first, ForwardIterator last) {
-    destroyHelper(first, last, value_type(first));
+template<class ForwardIterator>
+inline void destroyAux(ForwardIterator first,ForwardIterator last,__false_type){
+    for(;first< last;++first){
+        destroy(&(*first));
+    }
 }
 
+template<class ForwardIterator>
+inline void destroyAux(ForwardIterator first,ForwardIterator last,__true_type){}    //base type don't need operation
+
 template<class ForwardIterator, class T>
 inline void destroyHelper(ForwardIterator first, ForwardIterator last, T *) {
     typedef typename __type_traits<T>::has_trivial_destructor trivial_destructor;
@@ -34,14 +47,9 @@ inline void destroyHelper(ForwardIterator first, ForwardIterator last, T *) {
 }
 
 template<class ForwardIterator>
-inline void destroyAux(ForwardIterator first,ForwardIterator last,__false_type){
-    for(;first< last;++first){
-        destroy(&(*first));
-    }
+inline void destroy(ForwardIterator first, ForwardIterator last) {
+    destroyHelper(first, last, value_type(first));
 }
 
-template<class ForwardIterator>
-inline void destroyAux(ForwardIterator first,ForwardIterator last,__true_type){}    //base type don't need operation
-
 
 #endif //BETHSTL_CONSTRUCT_H
@@ -0,0 +1,158 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_EPOCH_H
+#define BETHSTL_EPOCH_H
+
+#include "alloc.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+
+// epoch_domain is a small epoch based reclamation scheme for containers whose readers
+// take no locks. A reader brackets its traversal with a read_guard; a writer unlinks a
+// node and hands it to retire(). Retired nodes are only reclaimed after synchronize()
+// has seen every read section that could still reach them finish.
+//
+// Readers announce themselves in one of two per-slot counters selected by the parity of
+// the global epoch. synchronize() advances the epoch and waits for the old parity to
+// drain. Slots are picked by thread id and padded to a cache line, so readers on
+// different cores do not write to a shared line.
+//
+// A thread must not call retire() or synchronize() while it holds a read_guard of the
+// same domain, it would wait for itself.
+class epoch_domain {
+private:
+    enum {
+        SLOTS = 64
+    };
+    enum {
+        RETIRE_BATCH = 256
+    };
+
+    struct alignas(64) slot {
+        std::atomic<size_t> readers[2];
+
+        slot() {
+            readers[0].store(0, std::memory_order_relaxed);
+            readers[1].store(0, std::memory_order_relaxed);
+        }
+    };
+
+    struct retired {
+        void *pointer;
+
+        void (*reclaim)(void *);
+
+        retired *next;
+    };
+
+    typedef simpleAlloc<retired, malloc_alloc> retired_allocator;
+
+    std::atomic<size_t> epoch;
+    slot slots[SLOTS];
+    std::mutex sync_lock;
+    std::mutex retire_lock;
+    retired *pending;
+    size_t num_pending;
+
+    static size_t slot_index() {
+        static thread_local size_t index = std::hash<std::thread::id>()(std::this_thread::get_id()) % SLOTS;
+        return index;
+    }
+
+    std::atomic<size_t> *enter() {
+        slot &s = slots[slot_index()];
+        for (;;) {
+            const size_t e = epoch.load();
+            std::atomic<size_t> *counter = &s.readers[e & 1];
+            counter->fetch_add(1);
+            // the epoch moved between the load and the announce, the writer may already
+            // have checked this counter, so announce again under the new epoch.
+            if (epoch.load() == e) return counter;
+            counter->fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    static void reclaim_all(retired *list) {
+        while (list) {
+            retired *next = list->next;
+            list->reclaim(list->pointer);
+            retired_allocator::deallocate(list);
+            list = next;
+        }
+    }
+
+    retired *take_pending() {
+        retired *list = pending;
+        pending = nullptr;
+        num_pending = 0;
+        return list;
+    }
+
+public:
+    class read_guard {
+    private:
+        std::atomic<size_t> *counter;
+
+    public:
+        explicit read_guard(epoch_domain &domain) : counter(domain.enter()) {}
+
+        ~read_guard() { counter->fetch_sub(1, std::memory_order_release); }
+
+        read_guard(const read_guard &) = delete;
+
+        read_guard &operator=(const read_guard &) = delete;
+    };
+
+    epoch_domain() : epoch(0), pending(nullptr), num_pending(0) {}
+
+    ~epoch_domain() { reclaim_all(pending); }
+
+    epoch_domain(const epoch_domain &) = delete;
+
+    epoch_domain &operator=(const epoch_domain &) = delete;
+
+    // waits until every read section that was active when it was called has ended
+    void synchronize() {
+        std::lock_guard<std::mutex> guard(sync_lock);
+        const size_t old = epoch.fetch_add(1);
+        for (size_t i = 0; i < SLOTS; ++i) {
+            while (slots[i].readers[old & 1].load(std::memory_order_acquire) != 0)
+                std::this_thread::yield();
+        }
+    }
+
+    // p must already be unreachable for new readers. reclaim(p) runs once no reader can hold it,
+    // batched so that synchronize() is paid once per RETIRE_BATCH retirements.
+    void retire(void *p, void (*reclaim)(void *)) {
+        retired *r = retired_allocator::allocate();
+        r->pointer = p;
+        r->reclaim = reclaim;
+        retired *batch;
+        {
+            std::lock_guard<std::mutex> guard(retire_lock);
+            r->next = pending;
+            pending = r;
+            if (++num_pending < (size_t) RETIRE_BATCH) return;
+            batch = take_pending();
+        }
+        synchronize();
+        reclaim_all(batch);
+    }
+
+    // reclaims everything retired so far
+    void barrier() {
+        retired *batch;
+        {
+            std::lock_guard<std::mutex> guard(retire_lock);
+            batch = take_pending();
+        }
+        synchronize();
+        reclaim_all(batch);
+    }
+};
+
+#endif //BETHSTL_EPOCH_H
@@ -0,0 +1,379 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_FLAT_MAP_H
+#define BETHSTL_FLAT_MAP_H
+
+#include "alloc.h"
+#include "algorithm_base.h"
+#include "iterator.h"
+#include "vector.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+// flat_map keeps its keys and its values in two vectors sorted by key, the value of the
+// i-th key at index i of the other. a lookup is a binary search over the keys alone, so
+// every probe reads dense memory holding nothing but keys, and a walk in order reads both
+// arrays front to back. there are no nodes: the map costs what its two arrays cost.
+//
+// insert(first, last) sorts the new elements and merges them with the old ones in one pass,
+// O(m log m + size()) for m new elements. a single insert or erase moves everything behind
+// its position, so this is a table to build in bulk and then mostly read. as in map, an
+// element whose key is already present is dropped, and of repeated keys in a range the
+// first wins. every insert and erase invalidates all iterators.
+
+// walks the keys and the values in step. no pair is stored, so dereferencing yields a pair
+// of references; it->first and it->second work as they do for map.
+template<class Key, class T, class Ref, class Ptr>
+struct flat_map_iterator {
+    typedef flat_map_iterator<Key, T, T &, T *> iterator;
+    typedef flat_map_iterator<Key, T, const T &, const T *> const_iterator;
+
+    typedef std::pair<const Key, T> value_type;
+    typedef random_access_iterator_tag iterator_category;
+    typedef std::pair<const Key &, Ref> reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    // what operator-> returns: holds the pair of references for the length of the expression
+    struct pointer {
+        reference ref;
+
+        const reference *operator->() const { return &ref; }
+    };
+
+    typedef flat_map_iterator _self;
+
+    const Key *key;
+    Ptr val;
+
+    flat_map_iterator() : key(nullptr), val(nullptr) {}
+
+    flat_map_iterator(const Key *k, Ptr v) : key(k), val(v) {}
+
+    flat_map_iterator(const iterator &x) : key(x.key), val(x.val) {}
+
+    reference operator*() const { return reference(*key, *val); }
+
+    pointer operator->() const {
+        pointer p = {**this};
+        return p;
+    }
+
+    reference operator[](difference_type n) const { return reference(key[n], val[n]); }
+
+    _self &operator++() {
+        ++key;
+        ++val;
+        return *this;
+    }
+
+    _self operator++(int) {
+        _self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    _self &operator--() {
+        --key;
+        --val;
+        return *this;
+    }
+
+    _self operator--(int) {
+        _self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    _self &operator+=(difference_type n) {
+        key += n;
+        val += n;
+        return *this;
+    }
+
+    _self &operator-=(difference_type n) { return *this += -n; }
+
+    _self operator+(difference_type n) const { return _self(key + n, val + n); }
+
+    _self operator-(difference_type n) const { return _self(key - n, val - n); }
+};
+
+template<class Key, class T, class R1, class P1, class R2, class P2>
+inline ptrdiff_t operator-(const flat_map_iterator<Key, T, R1, P1> &x, const flat_map_iterator<Key, T, R2, P2> &y) {
+    return x.key - y.key;
+}
+
+template<class Key, class T, class R1, class P1, class R2, class P2>
+inline bool operator==(const flat_map_iterator<Key, T, R1, P1> &x, const flat_map_iterator<Key, T, R2, P2> &y) {
+    return x.key == y.key;
+}
+
+template<class Key, class T, class R1, class P1, class R2, class P2>
+inline bool operator!=(const flat_map_iterator<Key, T, R1, P1> &x, const flat_map_iterator<Key, T, R2, P2> &y) {
+    return x.key != y.key;
+}
+
+template<class Key, class T, class R1, class P1, class R2, class P2>
+inline bool operator<(const flat_map_iterator<Key, T, R1, P1> &x, const flat_map_iterator<Key, T, R2, P2> &y) {
+    return x.key < y.key;
+}
+
+template<class Key, class T, class R1, class P1, class R2, class P2>
+inline bool operator>(const flat_map_iterator<Key, T, R1, P1> &x, const flat_map_iterator<Key, T, R2, P2> &y) {
+    return x.key > y.key;
+}
+
+template<class Key, class T, class R1, class P1, class R2, class P2>
+inline bool operator<=(const flat_map_iterator<Key, T, R1, P1> &x, const flat_map_iterator<Key, T, R2, P2> &y) {
+    return x.key <= y.key;
+}
+
+template<class Key, class T, class R1, class P1, class R2, class P2>
+inline bool operator>=(const flat_map_iterator<Key, T, R1, P1> &x, const flat_map_iterator<Key, T, R2, P2> &y) {
+    return x.key >= y.key;
+}
+
+template<class Key, class T, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+class flat_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef Compare key_compare;
+    typedef vector<Key, Alloc> key_container_type;
+    typedef vector<T, Alloc> mapped_container_type;
+    typedef flat_map_iterator<Key, T, T &, T *> iterator;
+    typedef flat_map_iterator<Key, T, const T &, const T *> const_iterator;
+    typedef typename iterator::reference reference;
+    typedef typename const_iterator::reference const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+
+    class value_compare {
+        friend class flat_map;
+
+    protected:
+        Compare comp;
+
+        value_compare(Compare c) : comp(c) {}
+
+    public:
+        bool operator()(const value_type &x, const value_type &y) const { return comp(x.first, y.first); }
+    };
+
+private:
+    key_compare comp;
+    key_container_type key_vec;
+    mapped_container_type value_vec;
+
+    size_type lower_index(const key_type &k) const {
+        return (size_type) (::lower_bound(key_vec.begin(), key_vec.end(), k, comp) - key_vec.begin());
+    }
+
+    size_type upper_index(const key_type &k) const {
+        return (size_type) (::upper_bound(key_vec.begin(), key_vec.end(), k, comp) - key_vec.begin());
+    }
+
+    // lower_index() when the key at it is k, size() otherwise
+    size_type find_index(const key_type &k) const {
+        size_type i = lower_index(k);
+        return i == size() || comp(k, key_vec[i]) ? size() : i;
+    }
+
+    iterator at_index(size_type i) { return iterator(key_vec.begin() + i, value_vec.begin() + i); }
+
+    const_iterator at_index(size_type i) const { return const_iterator(key_vec.begin() + i, value_vec.begin() + i); }
+
+    size_type index_of(const_iterator it) const { return (size_type) (it.key - key_vec.begin()); }
+
+    // puts k and v at index i of both arrays, neither changes when either insert throws
+    void insert_at(size_type i, const key_type &k, const T &v) {
+        key_vec.insert(key_vec.begin() + i, k);
+        try {
+            value_vec.insert(value_vec.begin() + i, v);
+        } catch (...) {
+            key_vec.erase(key_vec.begin() + i);
+            throw;
+        }
+    }
+
+    void erase_at(size_type i, size_type j) {
+        key_vec.erase(key_vec.begin() + i, key_vec.begin() + j);
+        value_vec.erase(value_vec.begin() + i, value_vec.begin() + j);
+    }
+
+public:
+    flat_map() : comp() {}
+
+    explicit flat_map(const Compare &c) : comp(c) {}
+
+    template<class InputIterator>
+    flat_map(InputIterator first, InputIterator last, const Compare &c = Compare()) : comp(c) {
+        insert(first, last);
+    }
+
+    key_compare key_comp() const { return comp; }
+
+    value_compare value_comp() const { return value_compare(comp); }
+
+    iterator begin() { return at_index(0); }
+
+    const_iterator begin() const { return at_index(0); }
+
+    iterator end() { return at_index(size()); }
+
+    const_iterator end() const { return at_index(size()); }
+
+    bool empty() const { return key_vec.empty(); }
+
+    size_type size() const { return key_vec.size(); }
+
+    size_type max_size() const { return size_type(-1) / (sizeof(Key) + sizeof(T)); }
+
+    void reserve(size_type n) {
+        key_vec.reserve(n);
+        value_vec.reserve(n);
+    }
+
+    // the sorted keys and the values in the same order, to scan one without the other
+    const key_container_type &keys() const { return key_vec; }
+
+    const mapped_container_type &values() const { return value_vec; }
+
+    T &operator[](const key_type &k) {
+        size_type i = lower_index(k);
+        if (i == size() || comp(k, key_vec[i]))
+            insert_at(i, k, T());
+        return value_vec[i];
+    }
+
+    void swap(flat_map &x) {
+        std::swap(comp, x.comp);
+        key_vec.swap(x.key_vec);
+        value_vec.swap(x.value_vec);
+    }
+
+    std::pair<iterator, bool> insert(const value_type &x) {
+        size_type i = lower_index(x.first);
+        if (i != size() && !comp(x.first, key_vec[i]))
+            return std::pair<iterator, bool>(at_index(i), false);
+        insert_at(i, x.first, x.second);
+        return std::pair<iterator, bool>(at_index(i), true);
+    }
+
+    // pos is where x goes when it falls between pos - 1 and pos, which skips the search
+    iterator insert(const_iterator pos, const value_type &x) {
+        size_type i = index_of(pos);
+        if ((i == 0 || comp(key_vec[i - 1], x.first)) && (i == size() || comp(x.first, key_vec[i]))) {
+            insert_at(i, x.first, x.second);
+            return at_index(i);
+        }
+        return insert(x).first;
+    }
+
+    template<class InputIterator>
+    void insert(InputIterator first, InputIterator last);
+
+    void erase(const_iterator pos) {
+        size_type i = index_of(pos);
+        erase_at(i, i + 1);
+    }
+
+    size_type erase(const key_type &k) {
+        size_type i = find_index(k);
+        if (i == size()) return 0;
+        erase_at(i, i + 1);
+        return 1;
+    }
+
+    void erase(const_iterator first, const_iterator last) { erase_at(index_of(first), index_of(last)); }
+
+    void clear() {
+        key_vec.clear();
+        value_vec.clear();
+    }
+
+    iterator find(const key_type &k) { return at_index(find_index(k)); }
+
+    const_iterator find(const key_type &k) const { return at_index(find_index(k)); }
+
+    size_type count(const key_type &k) const { return find_index(k) != size(); }
+
+    iterator lower_bound(const key_type &k) { return at_index(lower_index(k)); }
+
+    const_iterator lower_bound(const key_type &k) const { return at_index(lower_index(k)); }
+
+    iterator upper_bound(const key_type &k) { return at_index(upper_index(k)); }
+
+    const_iterator upper_bound(const key_type &k) const { return at_index(upper_index(k)); }
+
+    std::pair<iterator, iterator> equal_range(const key_type &k) {
+        size_type i = find_index(k);
+        return i == size() ? std::pair<iterator, iterator>(end(), end())
+                           : std::pair<iterator, iterator>(at_index(i), at_index(i + 1));
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &k) const {
+        size_type i = find_index(k);
+        return i == size() ? std::pair<const_iterator, const_iterator>(end(), end())
+                           : std::pair<const_iterator, const_iterator>(at_index(i), at_index(i + 1));
+    }
+
+    friend bool operator==(const flat_map &x, const flat_map &y) {
+        return x.size() == y.size() &&
+               std::equal(x.key_vec.begin(), x.key_vec.end(), y.key_vec.begin()) &&
+               std::equal(x.value_vec.begin(), x.value_vec.end(), y.value_vec.begin());
+    }
+
+    friend bool operator!=(const flat_map &x, const flat_map &y) { return !(x == y); }
+};
+
+template<class Key, class T, class Compare, class Alloc>
+template<class InputIterator>
+void flat_map<Key, T, Compare, Alloc>::insert(InputIterator first, InputIterator last) {
+    typedef std::pair<Key, T> entry;
+    vector<entry, Alloc> batch;
+    for (; first != last; ++first)
+        batch.push_back(entry((*first).first, (*first).second));
+    if (batch.empty()) return;
+    // stable, so that of repeated keys the first in the range comes first
+    key_compare c = comp;
+    std::stable_sort(batch.begin(), batch.end(),
+                     [&c](const entry &x, const entry &y) { return c(x.first, y.first); });
+
+    // merge into new arrays and swap them in, so a throw leaves the map as it was
+    const size_type n = size();
+    key_container_type keys_out;
+    mapped_container_type values_out;
+    keys_out.reserve(n + batch.size());
+    values_out.reserve(n + batch.size());
+    size_type i = 0;
+    entry *p = batch.begin();
+    entry *const end = batch.end();
+    while (p != end) {
+        for (; i < n && comp(key_vec[i], p->first); ++i) {
+            keys_out.push_back(key_vec[i]);
+            values_out.push_back(value_vec[i]);
+        }
+        if (i == n || comp(p->first, key_vec[i])) {
+            keys_out.push_back(p->first);
+            values_out.push_back(p->second);
+        }
+        entry *q = p + 1;
+        while (q != end && !comp(p->first, q->first)) ++q;
+        p = q;
+    }
+    for (; i < n; ++i) {
+        keys_out.push_back(key_vec[i]);
+        values_out.push_back(value_vec[i]);
+    }
+    key_vec.swap(keys_out);
+    value_vec.swap(values_out);
+}
+
+#endif //BETHSTL_FLAT_MAP_H
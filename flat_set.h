@@ -0,0 +1,175 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_FLAT_SET_H
+#define BETHSTL_FLAT_SET_H
+
+#include "alloc.h"
+#include "algorithm_base.h"
+#include "vector.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+// flat_set is the key half of flat_map: one sorted vector of keys, searched by binary search,
+// with insert(first, last) sorting the new keys and merging them in one pass. see flat_map.h
+// for the costs. every insert and erase invalidates all iterators.
+template<class Key, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+class flat_set {
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef vector<Key, Alloc> container_type;
+    typedef const Key *iterator;
+    typedef const Key *const_iterator;
+    typedef const Key &reference;
+    typedef const Key &const_reference;
+    typedef const Key *pointer;
+    typedef const Key *const_pointer;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+
+private:
+    key_compare comp;
+    container_type key_vec;
+
+    size_type lower_index(const key_type &k) const {
+        return (size_type) (::lower_bound(key_vec.begin(), key_vec.end(), k, comp) - key_vec.begin());
+    }
+
+    size_type upper_index(const key_type &k) const {
+        return (size_type) (::upper_bound(key_vec.begin(), key_vec.end(), k, comp) - key_vec.begin());
+    }
+
+    // lower_index() when the key at it is k, size() otherwise
+    size_type find_index(const key_type &k) const {
+        size_type i = lower_index(k);
+        return i == size() || comp(k, key_vec[i]) ? size() : i;
+    }
+
+    size_type index_of(const_iterator it) const { return (size_type) (it - begin()); }
+
+public:
+    flat_set() : comp() {}
+
+    explicit flat_set(const Compare &c) : comp(c) {}
+
+    template<class InputIterator>
+    flat_set(InputIterator first, InputIterator last, const Compare &c = Compare()) : comp(c) {
+        insert(first, last);
+    }
+
+    key_compare key_comp() const { return comp; }
+
+    value_compare value_comp() const { return comp; }
+
+    iterator begin() const { return key_vec.begin(); }
+
+    iterator end() const { return key_vec.end(); }
+
+    bool empty() const { return key_vec.empty(); }
+
+    size_type size() const { return key_vec.size(); }
+
+    size_type max_size() const { return size_type(-1) / sizeof(Key); }
+
+    void reserve(size_type n) { key_vec.reserve(n); }
+
+    const container_type &keys() const { return key_vec; }
+
+    void swap(flat_set &x) {
+        std::swap(comp, x.comp);
+        key_vec.swap(x.key_vec);
+    }
+
+    std::pair<iterator, bool> insert(const value_type &x) {
+        size_type i = lower_index(x);
+        if (i != size() && !comp(x, key_vec[i]))
+            return std::pair<iterator, bool>(begin() + i, false);
+        key_vec.insert(key_vec.begin() + i, x);
+        return std::pair<iterator, bool>(begin() + i, true);
+    }
+
+    // pos is where x goes when it falls between pos - 1 and pos, which skips the search
+    iterator insert(const_iterator pos, const value_type &x) {
+        size_type i = index_of(pos);
+        if ((i == 0 || comp(key_vec[i - 1], x)) && (i == size() || comp(x, key_vec[i]))) {
+            key_vec.insert(key_vec.begin() + i, x);
+            return begin() + i;
+        }
+        return insert(x).first;
+    }
+
+    template<class InputIterator>
+    void insert(InputIterator first, InputIterator last);
+
+    void erase(const_iterator pos) { key_vec.erase(key_vec.begin() + index_of(pos)); }
+
+    size_type erase(const key_type &k) {
+        size_type i = find_index(k);
+        if (i == size()) return 0;
+        key_vec.erase(key_vec.begin() + i);
+        return 1;
+    }
+
+    void erase(const_iterator first, const_iterator last) {
+        key_vec.erase(key_vec.begin() + index_of(first), key_vec.begin() + index_of(last));
+    }
+
+    void clear() { key_vec.clear(); }
+
+    iterator find(const key_type &k) const { return begin() + find_index(k); }
+
+    size_type count(const key_type &k) const { return find_index(k) != size(); }
+
+    iterator lower_bound(const key_type &k) const { return begin() + lower_index(k); }
+
+    iterator upper_bound(const key_type &k) const { return begin() + upper_index(k); }
+
+    std::pair<iterator, iterator> equal_range(const key_type &k) const {
+        size_type i = find_index(k);
+        return std::pair<iterator, iterator>(begin() + i, begin() + (i == size() ? i : i + 1));
+    }
+
+    friend bool operator==(const flat_set &x, const flat_set &y) {
+        return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+    }
+
+    friend bool operator!=(const flat_set &x, const flat_set &y) { return !(x == y); }
+};
+
+template<class Key, class Compare, class Alloc>
+template<class InputIterator>
+void flat_set<Key, Compare, Alloc>::insert(InputIterator first, InputIterator last) {
+    container_type batch;
+    for (; first != last; ++first)
+        batch.push_back(*first);
+    if (batch.empty()) return;
+    std::sort(batch.begin(), batch.end(), comp);
+
+    // merge into a new array and swap it in, so a throw leaves the set as it was
+    const size_type n = size();
+    container_type out;
+    out.reserve(n + batch.size());
+    size_type i = 0;
+    Key *p = batch.begin();
+    Key *const end = batch.end();
+    while (p != end) {
+        for (; i < n && comp(key_vec[i], *p); ++i)
+            out.push_back(key_vec[i]);
+        if (i == n || comp(*p, key_vec[i]))
+            out.push_back(*p);
+        Key *q = p + 1;
+        while (q != end && !comp(*p, *q)) ++q;
+        p = q;
+    }
+    for (; i < n; ++i)
+        out.push_back(key_vec[i]);
+    key_vec.swap(out);
+}
+
+#endif //BETHSTL_FLAT_SET_H
@@ -0,0 +1,22 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_FUNCTION_H
+#define BETHSTL_FUNCTION_H
+
+// key extractors shared by the tree and hash containers: a set's value is its own key,
+// a map's key is the first half of its pair
+template<class T>
+struct Identity {
+    const T &operator()(const T &x) const { return x; }
+};
+
+template<class Pair>
+struct Select1st {
+    const typename Pair::first_type &operator()(const Pair &__x) const {
+        return __x.first;
+    }
+};
+
+#endif //BETHSTL_FUNCTION_H
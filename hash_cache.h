@@ -0,0 +1,359 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_HASH_CACHE_H
+#define BETHSTL_HASH_CACHE_H
+
+#include "alloc.h"
+#include "hashtable.h"
+#include "list.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+// hash_cache is a hash map bounded to capacity() entries. the entry is the hash_table value
+// and starts with its own list links, so each entry is one node of the table's node pool and
+// the eviction order costs no allocation. Policy decides which entry goes:
+//
+//     lru_eviction        least recently used
+//     clock_eviction      second chance; a hit sets a bit instead of moving the entry
+//     tinylfu_eviction    LRU order, but a new key only displaces the LRU entry when a
+//                         count-min sketch has seen it more often
+//
+// a Policy keeps the hooks of the live entries and provides attach(), touch(), detach(),
+// victim(), admit(), record(), reserve() and clear(); record() gets the hash code of every
+// key looked up when the policy has USES_FREQUENCY set. a policy with SHARED_TOUCH set only
+// stores the atomic referenced flag on a hit, so get() may run in several threads at once
+// as long as nothing else does, which is what concurrent_hash_cache relies on.
+
+// intrusive hook every cache entry starts with; the policy links it and may use the flag
+struct cache_hook : public list_node_base {
+    std::atomic<bool> referenced;
+};
+
+inline void __cache_link_after(list_node_base *x, list_node_base *pos) {
+    x->prev = pos;
+    x->next = pos->next;
+    pos->next->prev = x;
+    pos->next = x;
+}
+
+inline void __cache_unlink(list_node_base *x) {
+    x->prev->next = x->next;
+    x->next->prev = x->prev;
+}
+
+class lru_eviction {
+protected:
+    // head.next is the most recently used entry, head.prev the least
+    list_node_base head;
+
+public:
+    enum {
+        USES_FREQUENCY = 0
+    };
+    enum {
+        SHARED_TOUCH = 0
+    };
+
+    lru_eviction() { head.next = head.prev = &head; }
+
+    lru_eviction(const lru_eviction &) = delete;
+
+    lru_eviction &operator=(const lru_eviction &) = delete;
+
+    void reserve(size_t) {}
+
+    void attach(cache_hook *x) { __cache_link_after(x, &head); }
+
+    void touch(cache_hook *x) {
+        if (head.next == x) return;
+        __cache_unlink(x);
+        __cache_link_after(x, &head);
+    }
+
+    void detach(cache_hook *x) { __cache_unlink(x); }
+
+    cache_hook *victim() { return static_cast<cache_hook *>(head.prev); }
+
+    void record(uint64_t) {}
+
+    bool admit(uint64_t, uint64_t) { return true; }
+
+    void clear() { head.next = head.prev = &head; }
+};
+
+class clock_eviction {
+private:
+    // the entries form a ring through head; hand is the next entry the clock looks at
+    list_node_base head;
+    list_node_base *hand;
+
+public:
+    enum {
+        USES_FREQUENCY = 0
+    };
+    enum {
+        SHARED_TOUCH = 1
+    };
+
+    clock_eviction() : hand(&head) { head.next = head.prev = &head; }
+
+    clock_eviction(const clock_eviction &) = delete;
+
+    clock_eviction &operator=(const clock_eviction &) = delete;
+
+    void reserve(size_t) {}
+
+    // a new entry goes just behind the hand, the last place the clock reaches
+    void attach(cache_hook *x) {
+        x->referenced.store(false, std::memory_order_relaxed);
+        __cache_link_after(x, hand->prev);
+    }
+
+    void touch(cache_hook *x) {
+        if (!x->referenced.load(std::memory_order_relaxed)) x->referenced.store(true, std::memory_order_relaxed);
+    }
+
+    void detach(cache_hook *x) {
+        if (hand == x) hand = x->next;
+        __cache_unlink(x);
+    }
+
+    cache_hook *victim() {
+        for (;;) {
+            if (hand == &head) hand = head.next;
+            cache_hook *x = static_cast<cache_hook *>(hand);
+            if (!x->referenced.load(std::memory_order_relaxed)) return x;
+            x->referenced.store(false, std::memory_order_relaxed);
+            hand = hand->next;
+        }
+    }
+
+    void record(uint64_t) {}
+
+    bool admit(uint64_t, uint64_t) { return true; }
+
+    void clear() {
+        head.next = head.prev = &head;
+        hand = &head;
+    }
+};
+
+// W-TinyLFU without the window: four 4 bit counters per key in a count-min sketch of one 64
+// bit word of sixteen counters per entry, all halved after 10 * capacity records so old hits fade.
+class tinylfu_eviction : public lru_eviction {
+private:
+    typedef simpleAlloc<uint64_t, STL_DEFAULT_ALLOCATOR> word_allocator;
+
+    uint64_t *table;
+    size_t words;
+    size_t records;
+    size_t sample;
+
+    static size_t index_of(uint64_t code, int row) {
+        return (size_t) hash_mix(code ^ __stl_hash_secret[row], __stl_hash_k1);
+    }
+
+    unsigned counter(size_t i) const { return (unsigned) (table[(i >> 4) & (words - 1)] >> ((i & 15) << 2)) & 15; }
+
+public:
+    enum {
+        USES_FREQUENCY = 1
+    };
+    enum {
+        SHARED_TOUCH = 0
+    };
+
+    tinylfu_eviction() : table(nullptr), words(0), records(0), sample(0) {}
+
+    ~tinylfu_eviction() {
+        if (table) word_allocator::deallocate(table, words);
+    }
+
+    void reserve(size_t capacity) {
+        if (table) word_allocator::deallocate(table, words);
+        words = 1;
+        while (words < capacity) words <<= 1;
+        table = word_allocator::allocate(words);
+        memset(table, 0, words * sizeof(uint64_t));
+        records = 0;
+        sample = 10 * (capacity ? capacity : 1);
+    }
+
+    void record(uint64_t code) {
+        for (int row = 0; row < 4; ++row) {
+            const size_t i = index_of(code, row);
+            if (counter(i) < 15) table[(i >> 4) & (words - 1)] += (uint64_t) 1 << ((i & 15) << 2);
+        }
+        if (++records == sample) {
+            for (size_t w = 0; w < words; ++w)
+                table[w] = (table[w] >> 1) & 0x7777777777777777ull;
+            records /= 2;
+        }
+    }
+
+    unsigned frequency(uint64_t code) const {
+        unsigned result = 15;
+        for (int row = 0; row < 4; ++row) {
+            const unsigned c = counter(index_of(code, row));
+            if (c < result) result = c;
+        }
+        return result;
+    }
+
+    bool admit(uint64_t candidate, uint64_t victim) { return frequency(candidate) > frequency(victim); }
+
+    void clear() {
+        lru_eviction::clear();
+        memset(table, 0, words * sizeof(uint64_t));
+        records = 0;
+    }
+};
+
+template<class Key, class T>
+struct cache_entry : public cache_hook {
+    std::pair<const Key, T> value;
+
+    template<class... Args>
+    explicit cache_entry(Args &&... args) : value(std::forward<Args>(args)...) {}
+};
+
+template<class Key, class T>
+struct cache_entry_key {
+    const Key &operator()(const cache_entry<Key, T> &e) const { return e.value.first; }
+};
+
+template<class Key, class T, class Policy = lru_eviction, class HashFunc = hash<Key>,
+        class EqualKey = std::equal_to<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+class hash_cache {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef HashFunc hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+    typedef Policy policy_type;
+    // called with each entry the policy evicts, before it is destroyed; must not throw
+    typedef std::function<void(value_type &)> eviction_callback;
+
+private:
+    typedef cache_entry<Key, T> entry;
+    typedef hash_table<entry, Key, HashFunc, cache_entry_key<Key, T>, EqualKey, Alloc> table_type;
+
+    table_type table;
+    policy_type policy;
+    size_type max_entries;
+    eviction_callback on_evict;
+
+    void note(const key_type &key) {
+        if (policy_type::USES_FREQUENCY) policy.record(table.hash_funct()(key));
+    }
+
+    // erased through an iterator: erase(key) would go on comparing against the key of the
+    // entry it has just destroyed
+    void evict(entry *e) {
+        typename table_type::iterator it = table.find(e->value.first);
+        policy.detach(e);
+        if (on_evict) on_evict(e->value);
+        table.erase(it);
+    }
+
+    // room for one more entry, false when the policy would rather keep its victim
+    bool make_room(const key_type &key) {
+        if (table.size() < max_entries) return true;
+        if (max_entries == 0) return false;
+        entry *victim = static_cast<entry *>(policy.victim());
+        if (policy_type::USES_FREQUENCY
+            && !policy.admit(table.hash_funct()(key), table.hash_funct()(victim->value.first)))
+            return false;
+        evict(victim);
+        return true;
+    }
+
+public:
+    explicit hash_cache(size_type capacity, const hasher &hf = hasher(), const key_equal &eql = key_equal())
+            : table(capacity, hf, eql), max_entries(capacity) { policy.reserve(capacity); }
+
+    hash_cache(const hash_cache &) = delete;
+
+    hash_cache &operator=(const hash_cache &) = delete;
+
+    hasher hash_function() const { return table.hash_funct(); }
+
+    key_equal key_eq() const { return table.key_eq(); }
+
+    size_type size() const { return table.size(); }
+
+    size_type capacity() const { return max_entries; }
+
+    bool empty() const { return table.empty(); }
+
+    policy_type &eviction_policy() { return policy; }
+
+    void set_eviction_callback(const eviction_callback &f) { on_evict = f; }
+
+    // the value of key or nullptr, counting as a use of the entry
+    T *get(const key_type &key) {
+        note(key);
+        typename table_type::iterator it = table.find(key);
+        if (it == table.end()) return nullptr;
+        policy.touch(&*it);
+        return &it->value.second;
+    }
+
+    // the value of key or nullptr, leaving the eviction order alone
+    const T *peek(const key_type &key) const {
+        typename table_type::const_iterator it = table.find(key);
+        return it == table.end() ? nullptr : &it->value.second;
+    }
+
+    bool contains(const key_type &key) const { return table.count(key) != 0; }
+
+    // inserts or assigns. a new key may evict the policy's victim; false when the policy
+    // turned the new key away instead and nothing was stored.
+    template<class M>
+    bool put(const key_type &key, M &&obj) {
+        note(key);
+        typename table_type::iterator it = table.find(key);
+        if (it != table.end()) {
+            it->value.second = std::forward<M>(obj);
+            policy.touch(&*it);
+            return true;
+        }
+        if (!make_room(key)) return false;
+        it = table.try_emplace_unique(key, key, std::forward<M>(obj)).first;
+        policy.attach(&*it);
+        return true;
+    }
+
+    size_type erase(const key_type &key) {
+        typename table_type::iterator it = table.find(key);
+        if (it == table.end()) return 0;
+        policy.detach(&*it);
+        table.erase(it);
+        return 1;
+    }
+
+    // shrinking evicts through the policy, with the callback, until size() fits.
+    // the policy is sized anew, a tinylfu sketch starts over.
+    void set_capacity(size_type n) {
+        max_entries = n;
+        while (table.size() > max_entries)
+            evict(static_cast<entry *>(policy.victim()));
+        policy.reserve(n);
+    }
+
+    // drops every entry without the eviction callback
+    void clear() {
+        table.clear();
+        policy.clear();
+    }
+};
+
+#endif //BETHSTL_HASH_CACHE_H
@@ -0,0 +1,359 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_HASH_FUN_H
+#define BETHSTL_HASH_FUN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "config.h"
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// hash<Key> is the default hasher of the hash containers. unlike std::hash, integers
+// are mixed rather than returned as is, so every bit of the code depends on every bit
+// of the key and the table may bucket on low or high bits alike.
+//
+// bytes are hashed with a wyhash style multiply-fold. inputs of __stl_hash_long bytes and more
+// go through eight 64 bit lanes in 64 byte stripes instead; with __AVX2__ a stripe takes
+// two vector registers, and the scalar loop computes the same values, so the code of a key
+// never depends on how the library was compiled.
+//
+// the mixers and the short byte path are __STL_CONSTEXPR, so integers and string_views
+// of fewer than __stl_hash_long bytes hash to the same code at compile time as at run time.
+
+static const uint64_t __stl_hash_secret[24] =
+        {
+                0x2cb0f69f4abea221ull, 0x9417034723148989ull, 0xdd555950609dfe03ull, 0xdbafb150deb12800ull,
+                0x7e789b2e6c442cb6ull, 0xf41e5636c7e4f8c4ull, 0x0959d150f8fba7e4ull, 0xa97316f13cdb9eeaull,
+                0x74cd8258f9520068ull, 0x55c74a62e116868bull, 0xd2f4c799a2023cbdull, 0xdf98cb79a37b51b9ull,
+                0x396f5885524f3905ull, 0xaf1d56386ca3b276ull, 0xa9ffbe6b5104e85aull, 0x6bd0c51b9fd533b3ull,
+                0x980ce91c50ab4b56ull, 0x28ac395780fe62c5ull, 0x768912e3a6bcedc7ull, 0x50b3e8c9332c7c88ull,
+                0xce3bbfe520bd47daull, 0xcba6c8e8e0bb7c4full, 0xbf194db8434a346dull, 0x7d8f2a7b60416d7full,
+        };
+
+static const size_t __stl_hash_long = 512;
+static const size_t __stl_hash_stripe = 64;
+static const size_t __stl_hash_stripes_per_block = 16;
+
+static const uint64_t __stl_hash_k0 = 0xa0761d6478bd642full;
+static const uint64_t __stl_hash_k1 = 0xe7037ed1a0b428dbull;
+static const uint64_t __stl_hash_k2 = 0x8ebc6af09c88c6e3ull;
+static const uint64_t __stl_hash_k3 = 0x589965cc75374cc3ull;
+
+// full 64x64 -> 128 bit product, high half folded onto the low half
+__STL_CONSTEXPR uint64_t hash_mix(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128) a * b;
+    return (uint64_t) r ^ (uint64_t) (r >> 64);
+#else
+    const uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t) a, lb = (uint32_t) b;
+    const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const uint64_t t = rl + (rm0 << 32);
+    uint64_t lo = t + (rm1 << 32);
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    return lo ^ hi;
+#endif
+}
+
+__STL_CONSTEXPR uint64_t hash_int(uint64_t x) { return hash_mix(x ^ __stl_hash_k0, __stl_hash_k1); }
+
+// order dependent, combine(combine(s, a), b) != combine(combine(s, b), a)
+__STL_CONSTEXPR size_t hash_combine(uint64_t seed, uint64_t value) {
+    return (size_t) hash_mix(seed ^ __stl_hash_k2, value ^ __stl_hash_k3);
+}
+
+inline uint64_t __hash_read8(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t __hash_read4(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// little endian loads assembled a byte at a time, which is what a constant expression can
+// read. they match __hash_read8/4 on little endian targets, where compilers fold them into
+// a single load.
+template<class Byte>
+__STL_CONSTEXPR uint64_t __hash_load4(const Byte *p) {
+    return (uint64_t) (unsigned char) p[0] | (uint64_t) (unsigned char) p[1] << 8
+           | (uint64_t) (unsigned char) p[2] << 16 | (uint64_t) (unsigned char) p[3] << 24;
+}
+
+template<class Byte>
+__STL_CONSTEXPR uint64_t __hash_load8(const Byte *p) {
+    return __hash_load4(p) | __hash_load4(p + 4) << 32;
+}
+
+inline void __hash_accumulate_scalar(uint64_t *acc, const unsigned char *p, const uint64_t *key) {
+    for (int i = 0; i < 8; ++i) {
+        const uint64_t data = __hash_read8(p + 8 * i);
+        const uint64_t keyed = data ^ key[i];
+        acc[i ^ 1] += data;
+        acc[i] += (keyed & 0xffffffffull) * (keyed >> 32);
+    }
+}
+
+inline void __hash_scramble_scalar(uint64_t *acc, const uint64_t *key) {
+    for (int i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= key[i];
+        acc[i] = a * 0x9E3779B1ull;
+    }
+}
+
+#ifdef __AVX2__
+
+// same arithmetic as the scalar versions, four lanes per register
+inline void __hash_accumulate_avx2(__m256i *acc, const unsigned char *p, const uint64_t *key) {
+    for (int i = 0; i < 2; ++i) {
+        const __m256i data = _mm256_loadu_si256((const __m256i *) (p + 32 * i));
+        const __m256i keyed = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i *) (key + 4 * i)));
+        const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+        const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, swapped));
+    }
+}
+
+inline void __hash_scramble_avx2(__m256i *acc, const uint64_t *key) {
+    const __m256i prime = _mm256_set1_epi32((int) 0x9E3779B1u);
+    for (int i = 0; i < 2; ++i) {
+        __m256i a = _mm256_xor_si256(acc[i], _mm256_srli_epi64(acc[i], 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *) (key + 4 * i)));
+        const __m256i lo = _mm256_mul_epu32(a, prime);
+        const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        acc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+    }
+}
+
+#endif
+
+// len >= __stl_hash_long
+inline uint64_t __hash_long(const unsigned char *p, size_t len, uint64_t seed) {
+    uint64_t acc[8] = {__stl_hash_k0, __stl_hash_k1, __stl_hash_k2, __stl_hash_k3,
+                       __stl_hash_secret[20], __stl_hash_secret[21], __stl_hash_secret[22], __stl_hash_secret[23]};
+    const size_t block = __stl_hash_stripe * __stl_hash_stripes_per_block;
+    const size_t blocks = (len - 1) / block;
+    const size_t tail_stripes = ((len - 1) - blocks * block) / __stl_hash_stripe;
+#ifdef __AVX2__
+    __m256i v[2] = {_mm256_loadu_si256((const __m256i *) acc), _mm256_loadu_si256((const __m256i *) (acc + 4))};
+    for (size_t b = 0; b < blocks; ++b, p += block) {
+        for (size_t s = 0; s < __stl_hash_stripes_per_block; ++s)
+            __hash_accumulate_avx2(v, p + s * __stl_hash_stripe, __stl_hash_secret + s);
+        __hash_scramble_avx2(v, __stl_hash_secret + 16);
+    }
+    for (size_t s = 0; s < tail_stripes; ++s)
+        __hash_accumulate_avx2(v, p + s * __stl_hash_stripe, __stl_hash_secret + s);
+    // the last stripe ends at the last byte and may overlap stripes already taken
+    __hash_accumulate_avx2(v, p + (len - blocks * block) - __stl_hash_stripe, __stl_hash_secret + 9);
+    _mm256_storeu_si256((__m256i *) acc, v[0]);
+    _mm256_storeu_si256((__m256i *) (acc + 4), v[1]);
+#else
+    for (size_t b = 0; b < blocks; ++b, p += block) {
+        for (size_t s = 0; s < __stl_hash_stripes_per_block; ++s)
+            __hash_accumulate_scalar(acc, p + s * __stl_hash_stripe, __stl_hash_secret + s);
+        __hash_scramble_scalar(acc, __stl_hash_secret + 16);
+    }
+    for (size_t s = 0; s < tail_stripes; ++s)
+        __hash_accumulate_scalar(acc, p + s * __stl_hash_stripe, __stl_hash_secret + s);
+    // the last stripe ends at the last byte and may overlap stripes already taken
+    __hash_accumulate_scalar(acc, p + (len - blocks * block) - __stl_hash_stripe, __stl_hash_secret + 9);
+#endif
+    uint64_t result = len * __stl_hash_k1;
+    for (int i = 0; i < 4; ++i)
+        result += hash_mix(acc[2 * i] ^ __stl_hash_secret[2 * i + 3], acc[2 * i + 1] ^ __stl_hash_secret[2 * i + 4]);
+    return hash_mix(result ^ seed ^ __stl_hash_k0, __stl_hash_k1);
+}
+
+// len < __stl_hash_long. Byte is any one byte character type
+template<class Byte>
+__STL_CONSTEXPR uint64_t __hash_short(const Byte *p, size_t len, uint64_t seed) {
+    seed ^= hash_mix(seed ^ __stl_hash_k0, __stl_hash_k1);
+    uint64_t a = 0, b = 0;
+    if (len <= 16) {
+        if (len >= 4) {
+            // two overlapping pairs of 4 byte reads cover 4..16 bytes without a loop
+            const size_t shift = (len >> 3) << 2;
+            a = (__hash_load4(p) << 32) | __hash_load4(p + shift);
+            b = (__hash_load4(p + len - 4) << 32) | __hash_load4(p + len - 4 - shift);
+        } else if (len > 0) {
+            a = ((uint64_t) (unsigned char) p[0] << 16) | ((uint64_t) (unsigned char) p[len >> 1] << 8)
+                | (unsigned char) p[len - 1];
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = hash_mix(__hash_load8(p) ^ __stl_hash_k1, __hash_load8(p + 8) ^ seed);
+                see1 = hash_mix(__hash_load8(p + 16) ^ __stl_hash_k2, __hash_load8(p + 24) ^ see1);
+                see2 = hash_mix(__hash_load8(p + 32) ^ __stl_hash_k3, __hash_load8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = hash_mix(__hash_load8(p) ^ __stl_hash_k1, __hash_load8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = __hash_load8(p + i - 16);
+        b = __hash_load8(p + i - 8);
+    }
+    return hash_mix(hash_mix(a ^ __stl_hash_k1, b ^ seed) ^ __stl_hash_k0 ^ len, __stl_hash_k1);
+}
+
+inline size_t hash_bytes(const void *key, size_t len, uint64_t seed = 0) {
+    const unsigned char *p = (const unsigned char *) key;
+    if (len >= __stl_hash_long) return (size_t) __hash_long(p, len, seed);
+    return (size_t) __hash_short(p, len, seed);
+}
+
+// anything without a specialization below still works through std::hash, with the
+// result mixed so that identity-like user hashes spread as well.
+template<class Key>
+struct hash {
+    size_t operator()(const Key &key) const { return (size_t) hash_int(std::hash<Key>()(key)); }
+};
+
+template<class T>
+struct hash_integral {
+    constexpr size_t operator()(T x) const { return (size_t) hash_int((uint64_t) x); }
+};
+
+template<> struct hash<bool> : public hash_integral<bool> {};
+template<> struct hash<char> : public hash_integral<char> {};
+template<> struct hash<signed char> : public hash_integral<signed char> {};
+template<> struct hash<unsigned char> : public hash_integral<unsigned char> {};
+template<> struct hash<wchar_t> : public hash_integral<wchar_t> {};
+template<> struct hash<char16_t> : public hash_integral<char16_t> {};
+template<> struct hash<char32_t> : public hash_integral<char32_t> {};
+template<> struct hash<short> : public hash_integral<short> {};
+template<> struct hash<unsigned short> : public hash_integral<unsigned short> {};
+template<> struct hash<int> : public hash_integral<int> {};
+template<> struct hash<unsigned int> : public hash_integral<unsigned int> {};
+template<> struct hash<long> : public hash_integral<long> {};
+template<> struct hash<unsigned long> : public hash_integral<unsigned long> {};
+template<> struct hash<long long> : public hash_integral<long long> {};
+template<> struct hash<unsigned long long> : public hash_integral<unsigned long long> {};
+
+template<class T>
+struct hash<T *> {
+    size_t operator()(T *p) const { return (size_t) hash_int((uint64_t) (uintptr_t) p); }
+};
+
+template<>
+struct hash<float> {
+    // +0.0 and -0.0 compare equal and must hash equal
+    size_t operator()(float x) const {
+        if (x == 0.0f) return (size_t) hash_int(0);
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        return (size_t) hash_int(bits);
+    }
+};
+
+template<>
+struct hash<double> {
+    size_t operator()(double x) const {
+        if (x == 0.0) return (size_t) hash_int(0);
+        uint64_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        return (size_t) hash_int(bits);
+    }
+};
+
+// strings hash their characters. the string hasher is transparent, so a table keyed by
+// std::string can be probed with a const char * (or string_view) without a temporary.
+template<class CharT, class Traits, class A>
+struct hash<std::basic_string<CharT, Traits, A> > {
+    typedef void is_transparent;
+
+    size_t operator()(const std::basic_string<CharT, Traits, A> &s) const {
+        return hash_bytes(s.data(), s.size() * sizeof(CharT));
+    }
+
+    size_t operator()(const CharT *s) const { return hash_bytes(s, Traits::length(s) * sizeof(CharT)); }
+
+#if __cplusplus >= 201703L
+
+    size_t operator()(std::basic_string_view<CharT, Traits> s) const {
+        return hash_bytes(s.data(), s.size() * sizeof(CharT));
+    }
+
+#endif
+};
+
+#if __cplusplus >= 201703L
+
+template<class CharT, class Traits>
+struct hash<std::basic_string_view<CharT, Traits> > {
+    constexpr size_t operator()(std::basic_string_view<CharT, Traits> s) const {
+        if constexpr (sizeof(CharT) == 1)
+            if (s.size() < __stl_hash_long) return (size_t) __hash_short(s.data(), s.size(), 0);
+        return hash_bytes(s.data(), s.size() * sizeof(CharT));
+    }
+};
+
+#endif
+
+// as in SGI STL, char pointers are hashed as C strings
+template<>
+struct hash<char *> {
+    size_t operator()(const char *s) const { return hash_bytes(s, strlen(s)); }
+};
+
+template<>
+struct hash<const char *> {
+    size_t operator()(const char *s) const { return hash_bytes(s, strlen(s)); }
+};
+
+template<class T1, class T2>
+struct hash<std::pair<T1, T2> > {
+    size_t operator()(const std::pair<T1, T2> &p) const {
+        return hash_combine(hash<typename std::remove_cv<T1>::type>()(p.first),
+                            hash<typename std::remove_cv<T2>::type>()(p.second));
+    }
+};
+
+template<class Tuple, size_t I, size_t N>
+struct __hash_tuple_element {
+    static size_t apply(const Tuple &t, uint64_t seed) {
+        typedef typename std::remove_cv<typename std::tuple_element<I, Tuple>::type>::type T;
+        return __hash_tuple_element<Tuple, I + 1, N>::apply(t, hash_combine(seed, hash<T>()(std::get<I>(t))));
+    }
+};
+
+template<class Tuple, size_t N>
+struct __hash_tuple_element<Tuple, N, N> {
+    static size_t apply(const Tuple &, uint64_t seed) { return (size_t) seed; }
+};
+
+template<class... Ts>
+struct hash<std::tuple<Ts...> > {
+    size_t operator()(const std::tuple<Ts...> &t) const {
+        return __hash_tuple_element<std::tuple<Ts...>, 0, sizeof...(Ts)>::apply(t, sizeof...(Ts));
+    }
+};
+
+#endif //BETHSTL_HASH_FUN_H
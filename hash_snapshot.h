@@ -0,0 +1,416 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_HASH_SNAPSHOT_H
+#define BETHSTL_HASH_SNAPSHOT_H
+
+#include "alloc.h"
+#include "function.h"
+#include "hashset.h"
+#include "hashtable.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define __STL_HAS_MMAP
+#endif
+
+// A hash image is a pointer free, read only copy of a hash table laid out for mmap:
+//
+//   header | uint64_t bucket_begin[bucket_count + 1] | padding | Value values[element_count]
+//
+// values are stored bucket after bucket, bucket n owns values[bucket_begin[n], bucket_begin[n + 1]),
+// so a lookup is one hash, one offset pair and a scan of adjacent values. opening an image maps
+// the file and checks the header, nothing is parsed or allocated per element, so start up costs
+// the page faults of the lookups that touch it.
+//
+// The image is only portable between builds with the same Value layout and byte order, and
+// keys must hash the same when written and read; the header records enough to refuse a file
+// that breaks either. the bucket offsets are trusted, open() does not walk them.
+struct hashtable_image_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t value_size;
+    uint32_t value_align;
+    uint64_t bucket_count;
+    uint64_t element_count;
+    // hash code of the first stored key, a different hasher shows up here
+    uint64_t first_code;
+    uint64_t values_offset;
+};
+
+static const char __stl_image_magic[8] = {'B', 'S', 'T', 'L', 'H', 'I', 'M', 'G'};
+static const uint32_t __stl_image_version = 1;
+static const uint32_t __stl_image_byte_order = 0x01020304;
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey>
+class hashtable_image {
+public:
+    typedef HashFunc hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef const Value *const_iterator;
+    typedef const Value *iterator;
+
+private:
+    enum {
+        NONE, MAPPED, HEAP, ATTACHED
+    };
+    enum {
+        VALUES_ALIGN = 64
+    };
+
+    hasher hash;
+    key_equal equals;
+    ExtractKey get_key;
+
+    const char *base;
+    size_t length;
+    int owner;
+    const uint64_t *bucket_begin;
+    const Value *values;
+    size_type buckets;
+    size_type num_elements;
+
+    static size_t roundUp(size_t n, size_t align) { return (n + align - 1) / align * align; }
+
+    static size_t offsets_offset() { return roundUp(sizeof(hashtable_image_header), sizeof(uint64_t)); }
+
+    static size_t values_offset(size_t bucket_count) {
+        const size_t align = alignof(Value) > (size_t) VALUES_ALIGN ? alignof(Value) : (size_t) VALUES_ALIGN;
+        return roundUp(offsets_offset() + (bucket_count + 1) * sizeof(uint64_t), align);
+    }
+
+    // checks data as an image and points the table at it
+    bool bind(const char *data, size_t bytes);
+
+    static bool write_padding(FILE *f, size_t bytes) {
+        static const char zeros[VALUES_ALIGN] = {};
+        return bytes == 0 || fwrite(zeros, 1, bytes, f) == bytes;
+    }
+
+public:
+    explicit hashtable_image(const hasher &hf = hasher(), const key_equal &eql = key_equal())
+            : hash(hf), equals(eql), base(nullptr), length(0), owner(NONE), bucket_begin(nullptr),
+              values(nullptr), buckets(0), num_elements(0) {}
+
+    ~hashtable_image() { close(); }
+
+    hashtable_image(const hashtable_image &) = delete;
+
+    hashtable_image &operator=(const hashtable_image &) = delete;
+
+    // maps the file read only. false if it cannot be read or is not an image of this table type
+    bool open(const char *path);
+
+    // uses an image already in memory, data must stay valid and aligned for Value until close()
+    bool attach(const void *data, size_t bytes) {
+        close();
+        if (!bind((const char *) data, bytes)) return false;
+        owner = ATTACHED;
+        return true;
+    }
+
+    void close();
+
+    bool is_open() const { return owner != NONE; }
+
+    size_type size() const { return num_elements; }
+
+    bool empty() const { return num_elements == 0; }
+
+    size_type bucket_count() const { return buckets; }
+
+    // the values in bucket order
+    const_iterator begin() const { return values; }
+
+    const_iterator end() const { return values + num_elements; }
+
+    const_iterator find(const key_type &key) const {
+        if (buckets == 0) return end();
+        const size_type n = hash(key) % buckets;
+        for (const Value *cur = values + bucket_begin[n], *last = values + bucket_begin[n + 1]; cur != last; ++cur) {
+            if (equals(get_key(*cur), key)) return cur;
+        }
+        return end();
+    }
+
+    size_type count(const key_type &key) const {
+        if (buckets == 0) return 0;
+        const size_type n = hash(key) % buckets;
+        size_type result = 0;
+        for (const Value *cur = values + bucket_begin[n], *last = values + bucket_begin[n + 1]; cur != last; ++cur) {
+            if (equals(get_key(*cur), key)) ++result;
+        }
+        return result;
+    }
+
+    // writes the n values of [first, last) to path as an image. the values are bucketed by
+    // hf in two passes over the range, holding one pointer per value meanwhile, so first
+    // must be a forward iterator over values that stay put.
+    template<class ForwardIterator>
+    static bool write(const char *path, ForwardIterator first, ForwardIterator last, size_type n,
+                      const hasher &hf = hasher());
+};
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey>
+bool hashtable_image<Value, Key, HashFunc, ExtractKey, EqualKey>::bind(const char *data, size_t bytes) {
+    hashtable_image_header header;
+    if (bytes < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, __stl_image_magic, sizeof(header.magic)) != 0 ||
+        header.version != __stl_image_version || header.byte_order != __stl_image_byte_order ||
+        header.value_size != sizeof(Value) || header.value_align != alignof(Value))
+        return false;
+    // sizes are checked against the file before any offset is computed from them
+    if (header.bucket_count == 0 || header.bucket_count > bytes / sizeof(uint64_t) ||
+        header.element_count > bytes / sizeof(Value) ||
+        header.values_offset != values_offset(header.bucket_count) ||
+        header.values_offset + header.element_count * sizeof(Value) > bytes)
+        return false;
+    if ((uintptr_t) (data + header.values_offset) % alignof(Value) != 0 ||
+        (uintptr_t) (data + offsets_offset()) % alignof(uint64_t) != 0)
+        return false;
+
+    const uint64_t *offsets = (const uint64_t *) (data + offsets_offset());
+    if (offsets[0] != 0 || offsets[header.bucket_count] != header.element_count) return false;
+    const Value *first = (const Value *) (data + header.values_offset);
+    if (header.element_count && hash(get_key(*first)) != header.first_code) return false;
+
+    base = data;
+    length = bytes;
+    bucket_begin = offsets;
+    values = first;
+    buckets = header.bucket_count;
+    num_elements = header.element_count;
+    return true;
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey>
+bool hashtable_image<Value, Key, HashFunc, ExtractKey, EqualKey>::open(const char *path) {
+    close();
+#ifdef __STL_HAS_MMAP
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const size_t bytes = (size_t) st.st_size;
+    void *data = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+    if (!bind((const char *) data, bytes)) {
+        munmap(data, bytes);
+        return false;
+    }
+    owner = MAPPED;
+    return true;
+#else
+    // no mmap, the file is read in one piece instead
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    long bytes = -1;
+    if (fseek(f, 0, SEEK_END) == 0) bytes = ftell(f);
+    if (bytes <= 0 || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return false;
+    }
+    char *data = (char *) malloc_alloc::allocate((size_t) bytes);
+    const bool ok = fread(data, 1, (size_t) bytes, f) == (size_t) bytes;
+    fclose(f);
+    if (!ok || !bind(data, (size_t) bytes)) {
+        malloc_alloc::deallocate(data, (size_t) bytes);
+        return false;
+    }
+    owner = HEAP;
+    return true;
+#endif
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey>
+void hashtable_image<Value, Key, HashFunc, ExtractKey, EqualKey>::close() {
+#ifdef __STL_HAS_MMAP
+    if (owner == MAPPED) munmap((void *) base, length);
+#endif
+    if (owner == HEAP) malloc_alloc::deallocate((void *) base, length);
+    base = nullptr;
+    length = 0;
+    owner = NONE;
+    bucket_begin = nullptr;
+    values = nullptr;
+    buckets = 0;
+    num_elements = 0;
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey>
+template<class ForwardIterator>
+bool hashtable_image<Value, Key, HashFunc, ExtractKey, EqualKey>::write(const char *path, ForwardIterator first,
+                                                                        ForwardIterator last, size_type n,
+                                                                        const hasher &hf) {
+    typedef simpleAlloc<uint64_t, malloc_alloc> offset_allocator;
+    typedef simpleAlloc<const Value *, malloc_alloc> order_allocator;
+    ExtractKey get_key;
+    const size_type bucket_count = __stl_next_prime(n);
+    uint64_t *offsets = offset_allocator::allocate(bucket_count + 1);
+    const Value **order = nullptr;
+    hashtable_image_header header;
+    bool ok = false;
+    try {
+        order = order_allocator::allocate(n ? n : 1);
+        // counting sort by bucket: count, turn the counts into starts, place,
+        // after which offsets[b] is the end of bucket b and is shifted back by one
+        for (size_type b = 0; b <= bucket_count; ++b) offsets[b] = 0;
+        for (ForwardIterator cur = first; cur != last; ++cur) ++offsets[hf(get_key(*cur)) % bucket_count];
+        uint64_t sum = 0;
+        for (size_type b = 0; b < bucket_count; ++b) {
+            const uint64_t count = offsets[b];
+            offsets[b] = sum;
+            sum += count;
+        }
+        for (ForwardIterator cur = first; cur != last; ++cur) order[offsets[hf(get_key(*cur)) % bucket_count]++] = &*cur;
+        for (size_type b = bucket_count; b > 0; --b) offsets[b] = offsets[b - 1];
+        offsets[0] = 0;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, __stl_image_magic, sizeof(header.magic));
+        header.version = __stl_image_version;
+        header.byte_order = __stl_image_byte_order;
+        header.value_size = sizeof(Value);
+        header.value_align = alignof(Value);
+        header.bucket_count = bucket_count;
+        header.element_count = n;
+        header.first_code = n ? hf(get_key(*order[0])) : 0;
+        header.values_offset = values_offset(bucket_count);
+    } catch (...) {
+        offset_allocator::deallocate(offsets, bucket_count + 1);
+        if (order) order_allocator::deallocate(order, n ? n : 1);
+        throw;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+             write_padding(f, offsets_offset() - sizeof(header)) &&
+             fwrite(offsets, sizeof(uint64_t), bucket_count + 1, f) == bucket_count + 1 &&
+             write_padding(f, header.values_offset - offsets_offset() - (bucket_count + 1) * sizeof(uint64_t));
+        for (size_type i = 0; ok && i < n; ++i)
+            ok = fwrite(order[i], sizeof(Value), 1, f) == 1;
+        ok = fclose(f) == 0 && ok;
+    }
+    offset_allocator::deallocate(offsets, bucket_count + 1);
+    order_allocator::deallocate(order, n ? n : 1);
+    return ok;
+}
+
+// read only hash_map opened from an image written by write(path, map)
+template<class Key, class T, class HashFunc = hash<Key>, class EqualKey = std::equal_to<Key> >
+class hash_map_image {
+private:
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+                  "hash_map_image stores keys and values as raw bytes");
+    typedef hashtable_image<std::pair<const Key, T>, Key, HashFunc, Select1st<std::pair<const Key, T> >, EqualKey> image;
+    image rep;
+
+public:
+    typedef typename image::key_type key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef typename image::value_type value_type;
+    typedef typename image::hasher hasher;
+    typedef typename image::key_equal key_equal;
+    typedef typename image::size_type size_type;
+    typedef typename image::const_iterator iterator;
+    typedef typename image::const_iterator const_iterator;
+
+    explicit hash_map_image(const hasher &hf = hasher(), const key_equal &eql = key_equal()) : rep(hf, eql) {}
+
+    // m is any hash_map<Key, T, HashFunc, ...>
+    template<class HashMap>
+    static bool write(const char *path, const HashMap &m) {
+        return image::write(path, m.begin(), m.end(), m.size(), m.hash_function());
+    }
+
+    bool open(const char *path) { return rep.open(path); }
+
+    bool attach(const void *data, size_t bytes) { return rep.attach(data, bytes); }
+
+    void close() { rep.close(); }
+
+    bool is_open() const { return rep.is_open(); }
+
+    size_type size() const { return rep.size(); }
+
+    bool empty() const { return rep.empty(); }
+
+    size_type bucket_count() const { return rep.bucket_count(); }
+
+    const_iterator begin() const { return rep.begin(); }
+
+    const_iterator end() const { return rep.end(); }
+
+    const_iterator find(const key_type &key) const { return rep.find(key); }
+
+    size_type count(const key_type &key) const { return rep.count(key); }
+};
+
+// read only hash_set opened from an image written by write(path, set)
+template<class Value, class HashFunc = hash<Value>, class EqualKey = std::equal_to<Value> >
+class hash_set_image {
+private:
+    static_assert(std::is_trivially_copyable<Value>::value, "hash_set_image stores values as raw bytes");
+    typedef hashtable_image<Value, Value, HashFunc, Identity<Value>, EqualKey> image;
+    image rep;
+
+public:
+    typedef typename image::key_type key_type;
+    typedef typename image::value_type value_type;
+    typedef typename image::hasher hasher;
+    typedef typename image::key_equal key_equal;
+    typedef typename image::size_type size_type;
+    typedef typename image::const_iterator iterator;
+    typedef typename image::const_iterator const_iterator;
+
+    explicit hash_set_image(const hasher &hf = hasher(), const key_equal &eql = key_equal()) : rep(hf, eql) {}
+
+    // s is any hash_set<Value, HashFunc, ...>
+    template<class HashSet>
+    static bool write(const char *path, const HashSet &s) {
+        return image::write(path, s.begin(), s.end(), s.size(), s.hash_function());
+    }
+
+    bool open(const char *path) { return rep.open(path); }
+
+    bool attach(const void *data, size_t bytes) { return rep.attach(data, bytes); }
+
+    void close() { rep.close(); }
+
+    bool is_open() const { return rep.is_open(); }
+
+    size_type size() const { return rep.size(); }
+
+    bool empty() const { return rep.empty(); }
+
+    size_type bucket_count() const { return rep.bucket_count(); }
+
+    const_iterator begin() const { return rep.begin(); }
+
+    const_iterator end() const { return rep.end(); }
+
+    const_iterator find(const key_type &key) const { return rep.find(key); }
+
+    size_type count(const key_type &key) const { return rep.count(key); }
+};
+
+#endif //BETHSTL_HASH_SNAPSHOT_H
@@ -6,16 +6,13 @@
 #define BETHSTL_HASHMAP_H
 
 #include "hashtable.h"
+#include "function.h"
+#include <tuple>
 
-template<class T>
-struct Identity : public std::unary_function<T, T> {
-    const T &operator()(const T &x) const { return x; }
-};
-
-template<class Key, class T, class HashFunc = std::hash<Key>, class EqualKey = std::equal_to<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+template<class Key, class T, class HashFunc = hash<Key>, class EqualKey = std::equal_to<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
 class hash_map {
 private:
-    typedef hash_table<std::pair<const Key, T>, Key, HashFunc, EqualKey, Alloc> ht;
+    typedef hash_table<std::pair<const Key, T>, Key, HashFunc, Select1st<std::pair<const Key, T> >, EqualKey, Alloc> ht;
     ht rep;
 
 public:
@@ -38,21 +35,24 @@ public:
 
     typedef typename ht::allocator_type allocator_type;
 
-    hasher hash_function() const { return rep.hash(); }
+    typedef typename ht::node_type node_type;
+    typedef typename ht::insert_return_type insert_return_type;
+
+    hasher hash_function() const { return rep.hash_funct(); }
 
-    key_equal key_eq() const { return rep.key_equal(); }
+    key_equal key_eq() const { return rep.key_eq(); }
 
-    hash_map() : rep(100, hasher(), key_equal(), allocator_type()) {}
+    hash_map() : rep(100, hasher(), key_equal()) {}
 
     explicit hash_map(size_type n)
-            : rep(n, hasher(), key_equal(), allocator_type()) {}
+            : rep(n, hasher(), key_equal()) {}
 
     hash_map(size_type n, const hasher &hf)
-            : rep(n, hf, key_equal(), allocator_type()) {}
+            : rep(n, hf, key_equal()) {}
 
     hash_map(size_type n, const hasher &hf, const key_equal &eql,
              const allocator_type &a = allocator_type())
-            : rep(n, hf, eql, a) {}
+            : rep(n, hf, eql) {}
 
     size_type size() const { return rep.size(); }
 
@@ -60,6 +60,10 @@ public:
 
     bool empty() const { return rep.empty(); }
 
+    hashtable_stats stats() const { return rep.stats(); }
+
+    void reset_lookup_stats() { rep.reset_lookup_stats(); }
+
     void swap(hash_map &x) { rep.swap(x.rep); }
 
     iterator begin() { return rep.begin(); }
@@ -87,11 +91,66 @@ public:
 
     const_iterator find(const key_type &key) const { return rep.find(key); }
 
+    // out receives one iterator per key, end() for a missing key
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) {
+        return rep.find_batch(first, last, out);
+    }
+
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        return rep.find_batch(first, last, out);
+    }
+
+    // heterogeneous lookup, available when HashFunc and EqualKey are transparent
+    template<class K>
+    typename ht::template if_transparent<K, iterator>::type find(const K &key) { return rep.find(key); }
+
+    template<class K>
+    typename ht::template if_transparent<K, const_iterator>::type find(const K &key) const { return rep.find(key); }
+
     T &operator[](const key_type &key) {
-        return rep.find_or_insert(value_type(key, T())).second;
+        return try_emplace(key).first->second;
+    }
+
+    T &operator[](key_type &&key) {
+        return try_emplace(std::move(key)).first->second;
     }
 
-    size_type count(const key_type &key) const { return rep.find(key); }
+    // mapped value is only constructed from args when key is not present
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args) {
+        return rep.try_emplace_unique(key, std::piecewise_construct, std::forward_as_tuple(key),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args) {
+        return rep.try_emplace_unique(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&obj) {
+        std::pair<iterator, bool> result = rep.try_emplace_unique(key, key, std::forward<M>(obj));
+        if (!result.second)
+            result.first->second = std::forward<M>(obj);
+        return result;
+    }
+
+    // key is moved from only when it is inserted
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&obj) {
+        std::pair<iterator, bool> result = rep.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+        if (!result.second)
+            result.first->second = std::forward<M>(obj);
+        return result;
+    }
+
+    size_type count(const key_type &key) const { return rep.count(key); }
+
+    template<class K>
+    typename ht::template if_transparent<K, size_type>::type count(const K &key) const { return rep.count(key); }
 
     std::pair<iterator, iterator> equal_range(const key_type &key) {
         return rep.equal_range(key);
@@ -101,8 +160,32 @@ public:
         return rep.equal_range(key);
     }
 
+    template<class K>
+    typename ht::template if_transparent<K, std::pair<iterator, iterator> >::type equal_range(const K &key) {
+        return rep.equal_range(key);
+    }
+
+    template<class K>
+    typename ht::template if_transparent<K, std::pair<const_iterator, const_iterator> >::type
+    equal_range(const K &key) const {
+        return rep.equal_range(key);
+    }
+
     size_type erase(const key_type &key) { return rep.erase(key); }
 
+    template<class K>
+    typename ht::template if_transparent<K, size_type>::type erase(const K &key) { return rep.erase(key); }
+
+    // node handles, see hash_table::extract. merge relinks every node of source and leaves there
+    // only the elements whose key is here already.
+    node_type extract(iterator it) { return rep.extract(it); }
+
+    node_type extract(const key_type &key) { return rep.extract(key); }
+
+    insert_return_type insert(node_type &&nh) { return rep.insert_unique(std::move(nh)); }
+
+    void merge(hash_map &source) { rep.merge_unique(source.rep); }
+
     void erase(iterator it) { rep.erase(it); }
 
     void erase(iterator first, iterator last) { rep.erase(first, last); }
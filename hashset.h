@@ -6,13 +6,9 @@
 #define BETHSTL_HASHSET_H
 
 #include "hashtable.h"
+#include "function.h"
 
-template<class T>
-struct Identity : public std::unary_function<T, T> {
-    const T &operator()(const T &x) const { return x; }
-};
-
-template<class Value, class HashFunc = std::hash<Value>, class EqualKey = std::equal_to<Value>, class Alloc = STL_DEFAULT_ALLOCATOR>
+template<class Value, class HashFunc = hash<Value>, class EqualKey = std::equal_to<Value>, class Alloc = STL_DEFAULT_ALLOCATOR>
 class hash_set {
 private:
     typedef hash_table<Value, Value, HashFunc, Identity<Value>, EqualKey, Alloc> ht;
@@ -35,9 +31,12 @@ public:
 
     typedef typename ht::allocator_type allocator_type;
 
-    hasher hash_function() const { return rep.hash(); }
+    typedef typename ht::node_type node_type;
+    typedef node_insert_return<iterator, node_type> insert_return_type;
+
+    hasher hash_function() const { return rep.hash_funct(); }
 
-    key_equal key_eq() const { return rep.key_equal(); }
+    key_equal key_eq() const { return rep.key_eq(); }
 
     //default set to 100 size
     hash_set() : rep(100, hasher(), key_equal()) {}
@@ -60,6 +59,10 @@ public:
 
     bool empty() const { return rep.empty(); }
 
+    hashtable_stats stats() const { return rep.stats(); }
+
+    void reset_lookup_stats() { rep.reset_lookup_stats(); }
+
     void swap(hash_set &x) { rep.swap(x.rep); }
 
     iterator begin() const { return rep.begin(); }
@@ -83,14 +86,49 @@ public:
 
     iterator find(const key_type &key) const { return rep.find(key); }
 
+    // out receives one iterator per key, end() for a missing key
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        return rep.find_batch(first, last, out);
+    }
+
+    // heterogeneous lookup, available when HashFunc and EqualKey are transparent
+    template<class K>
+    typename ht::template if_transparent<K, iterator>::type find(const K &key) const { return rep.find(key); }
+
     size_type count(const key_type &key) const { return rep.count(key); }
 
+    template<class K>
+    typename ht::template if_transparent<K, size_type>::type count(const K &key) const { return rep.count(key); }
+
     std::pair<iterator, iterator> equal_range(const key_type &key) const {
         return rep.equal_range(key);
     }
 
+    template<class K>
+    typename ht::template if_transparent<K, std::pair<iterator, iterator> >::type equal_range(const K &key) const {
+        return rep.equal_range(key);
+    }
+
     size_type erase(const key_type &key) { return rep.erase(key); }
 
+    template<class K>
+    typename ht::template if_transparent<K, size_type>::type erase(const K &key) { return rep.erase(key); }
+
+    // node handles, see hash_table::extract. merge relinks every node of source and leaves there
+    // only the elements that are here already.
+    node_type extract(iterator it) { return rep.extract(it); }
+
+    node_type extract(const key_type &key) { return rep.extract(key); }
+
+    insert_return_type insert(node_type &&nh) {
+        typename ht::insert_return_type r = rep.insert_unique(std::move(nh));
+        insert_return_type result = {r.position, r.inserted, std::move(r.node)};
+        return result;
+    }
+
+    void merge(hash_set &source) { rep.merge_unique(source.rep); }
+
     void erase(iterator it) { rep.erase(it); }
 
     void erase(iterator first, iterator last) {
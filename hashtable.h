@@ -11,7 +11,15 @@
 #include "alloc.h"
 #include "iterator.h"
 #include "vector.h"
+#include "type_traits.h"
+#include "hash_fun.h"
+#include "node_handle.h"
 #include <algorithm>
+#include <type_traits>
+
+#ifdef __STL_HASHTABLE_STATS
+#include <atomic>
+#endif
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc = STL_DEFAULT_ALLOCATOR>
 class hash_table;
@@ -29,6 +37,20 @@ struct hashtable_node {
     Value val;
 };
 
+// node_handle operations for hash_table nodes. a handle holds a loose node of node_pool, one
+// outside every table's slabs, so dropping it destroys the element and frees the node.
+template<class Value, class Alloc>
+struct hashtable_node_ops {
+    typedef Value value_type;
+
+    static Value &value(hashtable_node<Value> *p) { return p->val; }
+
+    static void drop(hashtable_node<Value> *p) {
+        destroy(&p->val);
+        node_pool<hashtable_node<Value>, Alloc>::deallocate_loose(p);
+    }
+};
+
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
 struct hashtable_iterator {
     typedef hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc> HashTable;
@@ -57,6 +79,46 @@ struct hashtable_iterator {
     iterator &operator++();
 
     iterator operator++(int);
+
+    bool operator==(const iterator &it) const { return cur == it.cur; }
+
+    bool operator!=(const iterator &it) const { return cur != it.cur; }
+};
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+struct hashtable_const_iterator {
+    typedef hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc> HashTable;
+    typedef hashtable_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc> iterator;
+    typedef hashtable_const_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc> const_iterator;
+    typedef hashtable_node<Value> Node;
+
+    typedef forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef size_t size_type;
+    typedef const Value &reference;
+    typedef const Value *pointer;
+
+    const Node *cur;
+    const HashTable *ht;
+
+    hashtable_const_iterator(const Node *n, const HashTable *table) : cur(n), ht(table) {}
+
+    hashtable_const_iterator() {}
+
+    hashtable_const_iterator(const iterator &it) : cur(it.cur), ht(it.ht) {}
+
+    reference operator*() const { return cur->val; }
+
+    pointer operator->() const { return &(operator*()); }
+
+    const_iterator &operator++();
+
+    const_iterator operator++(int);
+
+    bool operator==(const const_iterator &it) const { return cur == it.cur; }
+
+    bool operator!=(const const_iterator &it) const { return cur != it.cur; }
 };
 
 
@@ -66,7 +128,7 @@ hashtable_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::operator+
     const Node *old = cur;
     cur = cur->next;
     if (!cur) {
-        size_type bucket = ht->bucket_num(old->val);
+        size_type bucket = ht->bkt_num_val(old->val);
         while (!cur && ++bucket < ht->buckets.size())
             cur = ht->buckets[bucket];
     }
@@ -81,6 +143,27 @@ hashtable_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::operator+
     return temp;
 }
 
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+typename hashtable_const_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::const_iterator &
+hashtable_const_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::operator++() {
+    const Node *old = cur;
+    cur = cur->next;
+    if (!cur) {
+        size_type bucket = ht->bkt_num_val(old->val);
+        while (!cur && ++bucket < ht->buckets.size())
+            cur = ht->buckets[bucket];
+    }
+    return *this;
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+typename hashtable_const_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::const_iterator
+hashtable_const_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::operator++(int) {
+    const_iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
 
 static const int _stl_num_primes = 28;
 static const unsigned long _stl_prime_list[_stl_num_primes] =
@@ -100,12 +183,43 @@ inline unsigned long __stl_next_prime(unsigned long __n) {
     return pos == __last ? *(__last - 1) : *pos;
 }
 
+// snapshot of a hash_table's shape, filled by hash_table::stats().
+// lookups and probes stay zero unless __STL_HASHTABLE_STATS is defined.
+struct hashtable_stats {
+    enum {
+        HISTOGRAM_SIZE = 8
+    };
+
+    size_t elements;
+    size_t buckets;
+    size_t empty_buckets;
+    size_t max_chain;
+    // chain_lengths[i] buckets hold i nodes, the last entry also counts every longer chain
+    size_t chain_lengths[HISTOGRAM_SIZE];
+    // bucket array plus node slabs
+    size_t bytes;
+    // nodes visited by an average successful lookup, computed from the chain lengths
+    double expected_probes;
+    size_t lookups;
+    size_t probes;
+
+    double load_factor() const { return buckets ? (double) elements / buckets : 0.0; }
+
+    double empty_ratio() const { return buckets ? (double) empty_buckets / buckets : 0.0; }
+
+    double bytes_per_element() const { return elements ? (double) bytes / elements : 0.0; }
+
+    // nodes visited per find/count/equal_range since the counters were last reset
+    double average_probes() const { return lookups ? (double) probes / lookups : 0.0; }
+};
+
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
 class hash_table {
 public:
     typedef HashFunc hasher;
     typedef EqualKey key_equal;
     typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
     typedef Key key_type;
     typedef Value value_type;
     typedef value_type *pointer;
@@ -120,16 +234,36 @@ private:
     ExtractKey get_key;
 
     typedef hashtable_node<Value> Node;
-    typedef simpleAlloc<Node, Alloc> node_allocator;
 
     vector<Node *, Alloc> buckets;
     size_type num_elements;
+    // nodes come from slabs owned by this table, clear() gives them back all at once
+    node_pool<Node, Alloc> pool;
+
+    Node *get_node() { return pool.allocate(); }
+
+    void put_node(Node *p) { pool.deallocate(p); }
+
+#ifdef __STL_HASHTABLE_STATS
+    // relaxed atomics, const lookups may run concurrently under a shared lock
+    mutable std::atomic<size_type> lookup_count{0};
+    mutable std::atomic<size_type> probe_count{0};
 
-    Node *get_node() { return node_allocator::allocate(1); }
+    void note_lookup(size_type probes) const {
+        lookup_count.fetch_add(1, std::memory_order_relaxed);
+        probe_count.fetch_add(probes, std::memory_order_relaxed);
+    }
+#else
+
+    void note_lookup(size_type) const {}
 
-    void put_node(Node *p) { node_allocator::deallocate(p, 1); }
+#endif
 
 public:
+    hasher hash_funct() const { return hash; }
+
+    key_equal key_eq() const { return equals; }
+
     size_type bucket_count() const { return buckets.size(); }
 
     size_type max_bucket_count() const { return _stl_prime_list[_stl_num_primes - 1]; }
@@ -142,6 +276,16 @@ public:
         return result;
     }
 
+    // one pass over the bucket array and the chains, O(buckets + size())
+    hashtable_stats stats() const;
+
+    void reset_lookup_stats() {
+#ifdef __STL_HASHTABLE_STATS
+        lookup_count.store(0, std::memory_order_relaxed);
+        probe_count.store(0, std::memory_order_relaxed);
+#endif
+    }
+
     typedef hashtable_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc> iterator;
     typedef hashtable_const_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc> const_iterator;
 
@@ -149,6 +293,15 @@ public:
 
     allocator_type get_allocator() const { return allocator_type(); }
 
+    // heterogeneous lookup is only offered when both hasher and key_equal declare is_transparent,
+    // and never for iterators so that erase(iterator) keeps its meaning.
+    template<class K, class Result>
+    struct if_transparent
+            : public std::enable_if<_Is_transparent<HashFunc>::value && _Is_transparent<EqualKey>::value &&
+                                    !std::is_convertible<K, iterator>::value &&
+                                    !std::is_convertible<K, const_iterator>::value, Result> {
+    };
+
     friend struct
             hashtable_iterator<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>;
     friend struct
@@ -156,16 +309,16 @@ public:
 
     hash_table(size_type n, const HashFunc &hf, const EqualKey &eqk, const ExtractKey &exk)
             : hash(hf), equals(eqk), get_key(exk), buckets(), num_elements(0) {
-        initialize_buckets(num_elements);
+        initialize_buckets(n);
     }
 
     hash_table(size_type n, const HashFunc &hf, const EqualKey &eqk)
             : hash(hf), equals(eqk), buckets(), num_elements(0) {
-        initialize_buckets(num_elements);
+        initialize_buckets(n);
     }
 
     hash_table(const hash_table &x)
-            : hash(x.hash), equals(x.equals), get_key(x.get_key), buckets(x.buckets), num_elements(0) {
+            : hash(x.hash), equals(x.equals), get_key(x.get_key), buckets(x.buckets), num_elements(0), pool() {
         copy_from(x);
     }
 
@@ -190,12 +343,13 @@ public:
 
     bool empty() const { return 0 == size(); }
 
-    void swap(const hash_table &x) {
+    void swap(hash_table &x) {
         std::swap(hash, x.hash);
         std::swap(equals, x.equals);
         std::swap(get_key, x.get_key);
         buckets.swap(x.buckets);
         std::swap(num_elements, x.num_elements);
+        pool.swap(x.pool);
     }
 
     iterator begin() {
@@ -203,17 +357,17 @@ public:
             if (buckets[i]) {
                 return iterator(buckets[i], this);
             }
-            return end();
         }
+        return end();
     }
 
     const_iterator begin() const {
         for (size_type i = 0; i < buckets.size(); ++i) {
             if (buckets[i]) {
-                return iterator(buckets[i], this);
+                return const_iterator(buckets[i], this);
             }
-            return end();
         }
+        return end();
     }
 
     iterator end() {
@@ -221,7 +375,7 @@ public:
     }
 
     const_iterator end() const {
-        return iterator(nullptr, this);
+        return const_iterator(nullptr, this);
     }
 
     iterator insert_equal(const value_type &value) {
@@ -238,9 +392,11 @@ public:
 
     std::pair<iterator, bool> insert_unique_noresize(const value_type &value);
 
+    // bulk inserts grow the buckets once and carve all their nodes out of a single slab
     void insert_unique(const value_type *x, const value_type *y) {
         size_type n = y - x;
         resize(num_elements + n);
+        pool.reserve(n);
         for (; n > 0; --n, ++x)
             insert_unique_noresize(*x);
     }
@@ -248,23 +404,24 @@ public:
     void insert_equal(const value_type *x, const value_type *y) {
         size_type n = y - x;
         resize(num_elements + n);
+        pool.reserve(n);
         for (; n > 0; --n, ++x)
             insert_equal_noresize(*x);
     }
 
     void insert_unique(const_iterator x, const_iterator y) {
-        size_type n = 0;
-        distance(x, y, n);
+        size_type n = ::distance(x, y);
         resize(num_elements + n);
+        pool.reserve(n);
         for (; n > 0; --n, ++x) {
             insert_unique_noresize(*x);
         }
     }
 
     void insert_equal(const_iterator x, const_iterator y) {
-        size_type n = 0;
-        distance(x, y, n);
+        size_type n = ::distance(x, y);
         resize(num_elements + n);
+        pool.reserve(n);
         for (; n > 0; --n, ++x) {
             insert_equal_noresize(*x);
         }
@@ -272,35 +429,62 @@ public:
 
     reference find_or_insert(const value_type &value);
 
-    iterator find(const key_type &key) {
-        size_type n = bkt_num_key(key);
-        Node *first;
-        for (first = buckets[n]; first && !equals(get_key(first->val), key); first = first->next) {}
-        return iterator(first, this);
+    // probe for key first and only build a node from args on a miss
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace_unique(const key_type &key, Args &&... args);
+
+    // writes find(key) for every key in [first, last) to out, in order. keys are hashed a group
+    // at a time and their buckets and chain heads prefetched before any chain is walked, so the
+    // cache misses of independent lookups overlap instead of following one another.
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) {
+        find_batch_nodes(first, last, [&](Node *n) { *out++ = iterator(n, this); });
+        return out;
     }
 
-    const_iterator find(const key_type &key) const {
-        size_type n = bkt_num_key(key);
-        Node *first;
-        for (first = buckets[n]; first && !equals(get_key(first->val), key); first = first->next) {}
-        return iterator(first, this);
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+        find_batch_nodes(first, last, [&](Node *n) { *out++ = const_iterator(n, this); });
+        return out;
     }
 
-    size_type count(const key_type &key) const {
-        const size_type n = bkt_num_key(key);
-        size_type result = 0;
-        for (const Node *cur = buckets[n]; cur; cur = cur->next) {
-            if (equals(get_key(cur->val), key))
-                ++result;
-        }
-        return result;
+    iterator find(const key_type &key) { return iterator(find_node(key), this); }
+
+    const_iterator find(const key_type &key) const { return const_iterator(find_node(key), this); }
+
+    template<class K>
+    typename if_transparent<K, iterator>::type find(const K &key) { return iterator(find_node(key), this); }
+
+    template<class K>
+    typename if_transparent<K, const_iterator>::type find(const K &key) const {
+        return const_iterator(find_node(key), this);
     }
 
-    std::pair<iterator, iterator> equal_range(const key_type &key);
+    size_type count(const key_type &key) const { return count_key(key); }
+
+    template<class K>
+    typename if_transparent<K, size_type>::type count(const K &key) const { return count_key(key); }
 
-    std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const;
+    std::pair<iterator, iterator> equal_range(const key_type &key) { return equal_range_key(key); }
 
-    size_type erase(const key_type &pos);
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+        return equal_range_key(key);
+    }
+
+    template<class K>
+    typename if_transparent<K, std::pair<iterator, iterator> >::type equal_range(const K &key) {
+        return equal_range_key(key);
+    }
+
+    template<class K>
+    typename if_transparent<K, std::pair<const_iterator, const_iterator> >::type equal_range(const K &key) const {
+        return equal_range_key(key);
+    }
+
+    size_type erase(const key_type &key) { return erase_key(key); }
+
+    template<class K>
+    typename if_transparent<K, size_type>::type erase(const K &key) { return erase_key(key); }
 
     void erase(const iterator &pos);
 
@@ -310,6 +494,44 @@ public:
 
     void erase(const_iterator first, const_iterator last);
 
+    // node handles. a table's nodes live in its slabs, which go away with the table, so
+    // extract() moves the element once into a loose node that the handle owns. from there on
+    // the node is relinked, not copied: insert() hands it to this table's pool, whichever table
+    // it was taken from, and the element keeps its address.
+    //
+    // merge takes over the slabs of source together with all of its nodes and relinks them, with
+    // no allocation or copy. where keys are unique, the elements whose key is here already stay
+    // in source, moved into fresh nodes since source no longer has slabs of its own.
+    typedef node_handle<Node, hashtable_node_ops<Value, Alloc> > node_type;
+    typedef node_insert_return<iterator, node_type> insert_return_type;
+
+    node_type extract(const iterator &pos) {
+        if (!pos.cur) return node_type();
+        Node *n = node_pool<Node, Alloc>::allocate_loose();
+        try {
+            construct(&n->val, std::move(pos.cur->val));
+        } catch (...) {
+            node_pool<Node, Alloc>::deallocate_loose(n);
+            throw;
+        }
+        n->next = nullptr;
+        unlink_node(pos.cur);
+        delete_node(pos.cur);
+        return node_type(n);
+    }
+
+    node_type extract(const const_iterator &pos) { return extract(iterator(const_cast<Node *>(pos.cur), this)); }
+
+    node_type extract(const key_type &key) { return extract(find(key)); }
+
+    insert_return_type insert_unique(node_type &&nh);
+
+    iterator insert_equal(node_type &&nh);
+
+    void merge_unique(hash_table &source) { merge(source, true); }
+
+    void merge_equal(hash_table &source) { merge(source, false); }
+
     void resize(size_type num_elements_need);
 
     void clear();
@@ -327,7 +549,8 @@ private:
         num_elements = 0;
     }
 
-    size_type bkt_num_key(const key_type &key) const {
+    template<class K>
+    size_type bkt_num_key(const K &key) const {
         return bkt_num_key(key, buckets.size());
     }
 
@@ -335,7 +558,8 @@ private:
         return bkt_num_key(get_key(value));
     }
 
-    size_type bkt_num_key(const key_type &key, size_t n) const {
+    template<class K>
+    size_type bkt_num_key(const K &key, size_t n) const {
         return hash(key) % n;
     }
 
@@ -351,7 +575,21 @@ private:
             return node;
         } catch (...) {
             put_node(node);
+            throw;
+        }
+    }
+
+    template<class... Args>
+    Node *new_node(Args &&... args) {
+        Node *node = get_node();
+        node->next = 0;
+        try {
+            construct(&node->val, std::forward<Args>(args)...);
+        } catch (...) {
+            put_node(node);
+            throw;
         }
+        return node;
     }
 
     void delete_node(Node *node) {
@@ -359,12 +597,90 @@ private:
         put_node(node);
     }
 
+    // lookup helpers shared by the key_type and the heterogeneous overloads.
+    template<class K>
+    Node *find_node(const K &key) const {
+        size_type n = bkt_num_key(key);
+        Node *first;
+        size_type probes = 0;
+        for (first = buckets[n]; first; first = first->next) {
+            ++probes;
+            if (equals(get_key(first->val), key)) break;
+        }
+        note_lookup(probes);
+        return first;
+    }
+
+    template<class K>
+    size_type count_key(const K &key) const {
+        const size_type n = bkt_num_key(key);
+        size_type result = 0;
+        size_type probes = 0;
+        for (const Node *cur = buckets[n]; cur; cur = cur->next) {
+            ++probes;
+            if (equals(get_key(cur->val), key))
+                ++result;
+        }
+        note_lookup(probes);
+        return result;
+    }
+
+    // calls visit(node or nullptr) once per key, in order
+    template<class ForwardIterator, class Visit>
+    void find_batch_nodes(ForwardIterator first, ForwardIterator last, Visit visit) const;
+
+    template<class K>
+    std::pair<iterator, iterator> equal_range_key(const K &key);
+
+    template<class K>
+    std::pair<const_iterator, const_iterator> equal_range_key(const K &key) const;
+
+    template<class K>
+    size_type erase_key(const K &key);
+
     void erase_bucket(const size_type n, Node *first, Node *last);
 
     void erase_bucket(const size_type n, Node *last);
 
     void copy_from(const hash_table &x);
 
+    // takes n out of its chain without destroying it
+    void unlink_node(Node *n) {
+        Node **link = &buckets[bkt_num_val(n->val)];
+        while (*link != n) link = &(*link)->next;
+        *link = n->next;
+        n->next = nullptr;
+        --num_elements;
+    }
+
+    // links n into its bucket right after an equal key, as insert_equal does. with unique set
+    // an equal key leaves n out and is returned instead.
+    std::pair<Node *, bool> link_node(Node *n, bool unique) {
+        const size_type bucket_index = bkt_num_val(n->val);
+        for (Node *cur = buckets[bucket_index]; cur; cur = cur->next) {
+            if (equals(get_key(cur->val), get_key(n->val))) {
+                if (unique) return std::pair<Node *, bool>(cur, false);
+                n->next = cur->next;
+                cur->next = n;
+                ++num_elements;
+                return std::pair<Node *, bool>(n, true);
+            }
+        }
+        n->next = buckets[bucket_index];
+        buckets[bucket_index] = n;
+        ++num_elements;
+        return std::pair<Node *, bool>(n, true);
+    }
+
+    // the loose node of nh as one of this table's, in place
+    Node *claim_node(node_type &nh) {
+        Node *n = nh.release();
+        pool.adopt_loose(n);
+        return n;
+    }
+
+    void merge(hash_table &source, bool unique);
+
 };
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
@@ -373,7 +689,7 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::insert_unique_nor
     size_type bucket_index = bkt_num_val(value);
     Node *first = buckets[bucket_index];
     for (Node *cur = first; cur; cur = cur->next) {
-        if (EqualKey(ExtractKey(value), ExtractKey(cur->val)))
+        if (equals(get_key(value), get_key(cur->val)))
             return std::pair<iterator, bool>(iterator(cur, this), false);
     }
     Node *newNode = new_node(value);
@@ -389,7 +705,7 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::insert_equal_nore
     size_type bucket_index = bkt_num_val(value);
     Node *first = buckets[bucket_index];
     for (Node *cur = first; cur; cur = cur->next) {
-        if (EqualKey(ExtractKey(value), ExtractKey(cur->val))) {
+        if (equals(get_key(value), get_key(cur->val))) {
             Node *newNode = new_node(value);
             newNode->next = cur->next;
             cur->next = newNode;
@@ -413,7 +729,7 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::find_or_insert(co
     Node *first = buckets[bucket_index];
 
     for (Node *cur = first; cur; cur = cur->next) {
-        if (EqualKey(ExtractKey(value), ExtractKey(cur->val)))
+        if (equals(get_key(value), get_key(cur->val)))
             return cur->val;
     }
 
@@ -425,16 +741,78 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::find_or_insert(co
 }
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+template<class... Args>
+std::pair<typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::iterator, bool>
+hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::try_emplace_unique(const key_type &key,
+                                                                                  Args &&... args) {
+    // hash once, the code is reused if the insert has to grow the table.
+    const size_type code = hash(key);
+    size_type bucket_index = code % buckets.size();
+    for (Node *cur = buckets[bucket_index]; cur; cur = cur->next) {
+        if (equals(get_key(cur->val), key))
+            return std::pair<iterator, bool>(iterator(cur, this), false);
+    }
+
+    resize(num_elements + 1);
+    bucket_index = code % buckets.size();
+    Node *newNode = new_node(std::forward<Args>(args)...);
+    newNode->next = buckets[bucket_index];
+    buckets[bucket_index] = newNode;
+    num_elements++;
+    return std::pair<iterator, bool>(iterator(newNode, this), true);
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+template<class ForwardIterator, class Visit>
+void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::find_batch_nodes(ForwardIterator first,
+                                                                                     ForwardIterator last,
+                                                                                     Visit visit) const {
+    // enough lookups in flight to cover a DRAM miss, few enough to keep the group in L1
+    enum {
+        BATCH = 16
+    };
+    ForwardIterator keys[BATCH];
+    size_type bucket_index[BATCH];
+    Node *head[BATCH];
+    while (first != last) {
+        size_type n = 0;
+        for (; n < (size_type) BATCH && first != last; ++n, ++first) {
+            keys[n] = first;
+            bucket_index[n] = bkt_num_key(*first);
+            __stl_prefetch(&buckets[bucket_index[n]]);
+        }
+        for (size_type i = 0; i < n; ++i) {
+            head[i] = buckets[bucket_index[i]];
+            if (head[i]) __stl_prefetch(head[i]);
+        }
+        for (size_type i = 0; i < n; ++i) {
+            Node *cur;
+            size_type probes = 0;
+            for (cur = head[i]; cur; cur = cur->next) {
+                ++probes;
+                if (equals(get_key(cur->val), *keys[i])) break;
+            }
+            note_lookup(probes);
+            visit(cur);
+        }
+    }
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+template<class K>
 std::pair<typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::iterator,
         typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::iterator>
-hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::equal_range(const key_type &key) {
+hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::equal_range_key(const K &key) {
     typedef std::pair<iterator, iterator> _Pii;
     const size_type bucket_index = bkt_num_key(key);
 
+    size_type probes = 0;
     for (Node *first = buckets[bucket_index]; first; first = first->next) {
-        if (EqualKey(ExtractKey(first->val), key)) {
+        ++probes;
+        if (equals(get_key(first->val), key)) {
+            note_lookup(probes);
             for (Node *cur = first->next; cur; cur = cur->next) {
-                if (!EqualKey(ExtractKey(cur->val), key))
+                if (!equals(get_key(cur->val), key))
                     return _Pii(iterator(first, this), iterator(cur, this));
             }
             for (size_type n = bucket_index + 1; n < buckets.size(); ++n) {
@@ -444,20 +822,25 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::equal_range(const
             return _Pii(iterator(first, this), end());
         }
     }
+    note_lookup(probes);
     return _Pii(end(), end());
 }
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+template<class K>
 std::pair<typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::const_iterator,
         typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::const_iterator>
-hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::equal_range(const key_type &key) const {
+hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::equal_range_key(const K &key) const {
     typedef std::pair<const_iterator, const_iterator> _Pii;
     const size_type bucket_index = bkt_num_key(key);
 
+    size_type probes = 0;
     for (Node *first = buckets[bucket_index]; first; first = first->next) {
-        if (EqualKey(ExtractKey(first->val), key)) {
+        ++probes;
+        if (equals(get_key(first->val), key)) {
+            note_lookup(probes);
             for (Node *cur = first->next; cur; cur = cur->next) {
-                if (!EqualKey(ExtractKey(cur->val), key))
+                if (!equals(get_key(cur->val), key))
                     return _Pii(const_iterator(first, this), const_iterator(cur, this));
             }
             for (size_type n = bucket_index + 1; n < buckets.size(); ++n) {
@@ -467,13 +850,15 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::equal_range(const
             return _Pii(const_iterator(first, this), end());
         }
     }
+    note_lookup(probes);
     return _Pii(end(), end());
 }
 
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+template<class K>
 typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::size_type
-hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase(const key_type &key) {
+hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase_key(const K &key) {
     const size_type bucket_index = bkt_num_key(key);
     Node *first = buckets[bucket_index];
     size_type eraseNum = 0;
@@ -482,7 +867,7 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase(const key_t
         Node *cur = first;
         Node *next = cur->next;
         while (next) {
-            if (EqualKey(key, ExtractKey(next->val))) {
+            if (equals(get_key(next->val), key)) {
                 cur->next = next->next;
                 delete_node(next);
                 next = cur->next;
@@ -494,7 +879,7 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase(const key_t
             }
         }
 
-        if (EqualKey(key, ExtractKey(first->val))) {
+        if (equals(get_key(first->val), key)) {
             buckets[bucket_index] = first->next;
             delete_node(first);
             ++eraseNum;
@@ -516,16 +901,17 @@ void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase(const
             delete_node(cur);
             --num_elements;
         } else {
+            Node *prev = first;
             Node *next = first->next;
             while (next) {
                 if (next == cur) {
-                    first->next = next->next;
+                    prev->next = next->next;
                     delete_node(next);
                     --num_elements;
                     break;
                 } else {
-                    cur = next;
-                    next = cur->next;
+                    prev = next;
+                    next = prev->next;
                 }
             }
         }
@@ -539,7 +925,7 @@ void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase(iterat
     size_type l_bucket_index = last.cur ? bkt_num_val(last.cur->val) : buckets.size();
 
     if (first.cur == last.cur) return;
-    else if (f_bucket_index = l_bucket_index) {
+    else if (f_bucket_index == l_bucket_index) {
         erase_bucket(f_bucket_index, first.cur, last.cur);
     } else {
         erase_bucket(f_bucket_index, first.cur, nullptr);
@@ -560,7 +946,65 @@ hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase(const_itera
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
 void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase(const const_iterator &pos) {
-    erase(iterator(const_cast<Node *>(pos.cur), const_cast<hash_table *>(pos.ht));
+    erase(iterator(const_cast<Node *>(pos.cur), const_cast<hash_table *>(pos.ht)));
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::insert_return_type
+hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::insert_unique(node_type &&nh) {
+    insert_return_type result = {end(), false, node_type()};
+    if (nh.empty()) return result;
+    Node *found = find_node(get_key(nh.value()));
+    if (found) {
+        result.position = iterator(found, this);
+        result.node = std::move(nh);
+        return result;
+    }
+    resize(num_elements + 1);
+    result.position = iterator(link_node(claim_node(nh), false).first, this);
+    result.inserted = true;
+    return result;
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+typename hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::iterator
+hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::insert_equal(node_type &&nh) {
+    if (nh.empty()) return end();
+    resize(num_elements + 1);
+    return iterator(link_node(claim_node(nh), false).first, this);
+}
+
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::merge(hash_table &source, bool unique) {
+    if (&source == this || source.num_elements == 0) return;
+    pool.adopt(source.pool);
+    resize(num_elements + source.num_elements);
+    Node *kept = nullptr;
+    for (size_type i = 0; i < source.buckets.size(); ++i) {
+        Node *cur = source.buckets[i];
+        source.buckets[i] = nullptr;
+        while (cur) {
+            Node *next = cur->next;
+            if (!link_node(cur, unique).second) {
+                cur->next = kept;
+                kept = cur;
+            }
+            cur = next;
+        }
+    }
+    source.num_elements = 0;
+    try {
+        while (kept) {
+            Node *next = kept->next;
+            source.link_node(source.new_node(std::move(kept->val)), false);
+            delete_node(kept);
+            kept = next;
+        }
+    } catch (...) {
+        for (; kept; kept = kept->next)
+            destroy(&kept->val);
+        throw;
+    }
 }
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
@@ -626,18 +1070,52 @@ void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::erase_bucket
     }
 }
 
+template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
+hashtable_stats hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::stats() const {
+    hashtable_stats result;
+    result.elements = num_elements;
+    result.buckets = buckets.size();
+    result.empty_buckets = 0;
+    result.max_chain = 0;
+    for (size_type i = 0; i < (size_type) hashtable_stats::HISTOGRAM_SIZE; ++i)
+        result.chain_lengths[i] = 0;
+
+    // a hit on the k-th node of a chain visits k nodes, so a chain of length l costs l(l+1)/2 in total
+    double total_probes = 0;
+    for (size_type i = 0; i < buckets.size(); ++i) {
+        size_type length = 0;
+        for (const Node *cur = buckets[i]; cur; cur = cur->next)
+            ++length;
+        if (length == 0) ++result.empty_buckets;
+        if (length > result.max_chain) result.max_chain = length;
+        ++result.chain_lengths[std::min(length, (size_type) hashtable_stats::HISTOGRAM_SIZE - 1)];
+        total_probes += (double) length * (length + 1) / 2;
+    }
+    result.expected_probes = num_elements ? total_probes / num_elements : 0.0;
+    result.bytes = buckets.capacity() * sizeof(Node *) + pool.bytes();
+
+#ifdef __STL_HASHTABLE_STATS
+    result.lookups = lookup_count.load(std::memory_order_relaxed);
+    result.probes = probe_count.load(std::memory_order_relaxed);
+#else
+    result.lookups = 0;
+    result.probes = 0;
+#endif
+    return result;
+}
+
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
 void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::clear() {
+    // values still need their destructors, the nodes themselves are dropped with the slabs.
     for (size_type i = 0; i < buckets.size(); ++i) {
-        Node *cur = buckets[i];
-        while (cur) {
-            Node *next = cur->next;
-            delete_node(cur);
-            cur = next;
+        if (!std::is_trivially_destructible<Value>::value) {
+            for (Node *cur = buckets[i]; cur; cur = cur->next)
+                destroy(&cur->val);
         }
         buckets[i] = nullptr;
     }
     num_elements = 0;
+    pool.release();
 }
 
 template<class Value, class Key, class HashFunc, class ExtractKey, class EqualKey, class Alloc>
@@ -646,6 +1124,7 @@ void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::copy_from(
     buckets.clear();
     buckets.reserve(x.buckets.size());
     buckets.insert(buckets.end(), x.buckets.size(), (Node *) nullptr);
+    pool.reserve(x.num_elements);
     try {
         for (size_type i = 0; i < x.buckets.size(); ++i) {
             const Node *cur = x.buckets[i];
@@ -663,6 +1142,7 @@ void hash_table<Value, Key, HashFunc, ExtractKey, EqualKey, Alloc>::copy_from(
         num_elements = x.num_elements;
     } catch (...) {
         clear();
+        throw;
     }
 }
 
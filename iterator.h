@@ -57,6 +57,12 @@ struct iterator_traits<const T *> {
     typedef T &reference;
 };
 
+template<class Iterator>
+inline typename iterator_traits<Iterator>::iterator_category iterator_category(const Iterator &) {
+    typedef typename iterator_traits<Iterator>::iterator_category category;
+    return category();
+}
+
 template<class Iterator>
 inline typename iterator_traits<Iterator>::difference_type *distance_type(const Iterator &) {
     return static_cast<typename iterator_traits<Iterator>::difference_type *>(0);
@@ -108,7 +114,7 @@ inline void __advance(RandomIterator &i, Distance n, random_access_iterator_tag)
 
 template<class InputIterator, class Distance>
 inline void advance(InputIterator &i, Distance n) {
-    __distance(i, n, iterator_category(i));
+    __advance(i, n, iterator_category(i));
 }
 
 
@@ -0,0 +1,317 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_LOCKFREE_HASHMAP_H
+#define BETHSTL_LOCKFREE_HASHMAP_H
+
+#include "alloc.h"
+#include "construct.h"
+#include "hashtable.h"
+#include "epoch.h"
+#include <atomic>
+#include <mutex>
+
+// lockfree_hash_map is a chained hash map for read-mostly sharing between threads.
+// find() takes no lock: bucket heads and next links are atomics, and a reader walks them
+// inside an epoch read section. Writers serialize on a lock stripe chosen by bucket,
+// publish new nodes with a release store and never modify a node a reader may see:
+// erase() unlinks and retires the node, insert_or_assign() links a replacement.
+// Retired nodes are freed through the epoch_domain once no reader can still hold them.
+//
+// Growing copies the nodes into a new bucket array under all stripe locks, publishes it
+// and retires the old array, so readers never see a chain that is being rewired.
+template<class Key, class T, class HashFunc = hash<Key>, class EqualKey = std::equal_to<Key> >
+class lockfree_hash_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef HashFunc hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+
+private:
+    enum {
+        STRIPES = 64
+    };
+
+    struct node {
+        std::atomic<node *> next;
+        value_type val;
+    };
+
+    struct table {
+        size_type bucket_count;
+        std::atomic<node *> *buckets;
+    };
+
+    typedef simpleAlloc<node, malloc_alloc> node_allocator;
+    typedef simpleAlloc<table, malloc_alloc> table_allocator;
+    typedef simpleAlloc<std::atomic<node *>, malloc_alloc> bucket_allocator;
+
+    hasher hash;
+    key_equal equals;
+    std::atomic<table *> current;
+    std::atomic<size_type> num_elements;
+    std::mutex stripes[STRIPES];
+    mutable epoch_domain epochs;
+
+    // the storage comes from malloc_alloc, so the atomics are constructed in it like the value
+    template<class... Args>
+    static node *new_node(node *next, Args &&... args) {
+        node *n = node_allocator::allocate();
+        try {
+            construct(&n->val, std::forward<Args>(args)...);
+        } catch (...) {
+            node_allocator::deallocate(n);
+            throw;
+        }
+        construct(&n->next, next);
+        return n;
+    }
+
+    static void delete_node(void *p) {
+        node *n = (node *) p;
+        destroy(&n->next);
+        destroy(&n->val);
+        node_allocator::deallocate(n);
+    }
+
+    static table *new_table(size_type n) {
+        table *t = table_allocator::allocate();
+        t->bucket_count = __stl_next_prime(n);
+        try {
+            t->buckets = bucket_allocator::allocate(t->bucket_count);
+        } catch (...) {
+            table_allocator::deallocate(t);
+            throw;
+        }
+        for (size_type i = 0; i < t->bucket_count; ++i)
+            construct(&t->buckets[i], (node *) nullptr);
+        return t;
+    }
+
+    // frees the bucket array and every node still chained in it
+    static void delete_table(void *p) {
+        table *t = (table *) p;
+        for (size_type i = 0; i < t->bucket_count; ++i) {
+            node *cur = t->buckets[i].load(std::memory_order_relaxed);
+            while (cur) {
+                node *next = cur->next.load(std::memory_order_relaxed);
+                delete_node(cur);
+                cur = next;
+            }
+        }
+        for (size_type i = 0; i < t->bucket_count; ++i)
+            destroy(&t->buckets[i]);
+        bucket_allocator::deallocate(t->buckets, t->bucket_count);
+        table_allocator::deallocate(t);
+    }
+
+    // locks the stripe owning key's bucket in the current table. the table is read again
+    // after locking because a resize holds every stripe while it swaps tables.
+    table *lock_bucket(size_type code, std::unique_lock<std::mutex> &guard) {
+        for (;;) {
+            table *t = current.load(std::memory_order_acquire);
+            guard = std::unique_lock<std::mutex>(stripes[(code % t->bucket_count) % STRIPES]);
+            if (current.load(std::memory_order_acquire) == t) return t;
+            guard.unlock();
+        }
+    }
+
+    void lock_all() {
+        for (size_type i = 0; i < STRIPES; ++i) stripes[i].lock();
+    }
+
+    void unlock_all() {
+        for (size_type i = STRIPES; i > 0; --i) stripes[i - 1].unlock();
+    }
+
+    void grow(table *seen);
+
+public:
+    explicit lockfree_hash_map(size_type n = 100, const hasher &hf = hasher(), const key_equal &eql = key_equal())
+            : hash(hf), equals(eql), current(new_table(n)), num_elements(0) {}
+
+    ~lockfree_hash_map() {
+        epochs.barrier();
+        delete_table(current.load(std::memory_order_relaxed));
+    }
+
+    lockfree_hash_map(const lockfree_hash_map &) = delete;
+
+    lockfree_hash_map &operator=(const lockfree_hash_map &) = delete;
+
+    size_type size() const { return num_elements.load(std::memory_order_relaxed); }
+
+    bool empty() const { return 0 == size(); }
+
+    size_type bucket_count() const { return current.load(std::memory_order_acquire)->bucket_count; }
+
+    // lock free. the mapped value is copied out while the node is protected.
+    bool find(const key_type &key, mapped_type &result) const {
+        const size_type code = hash(key);
+        epoch_domain::read_guard guard(epochs);
+        const table *t = current.load(std::memory_order_acquire);
+        for (node *cur = t->buckets[code % t->bucket_count].load(std::memory_order_acquire); cur;
+             cur = cur->next.load(std::memory_order_acquire)) {
+            if (equals(cur->val.first, key)) {
+                result = cur->val.second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool contains(const key_type &key) const {
+        const size_type code = hash(key);
+        epoch_domain::read_guard guard(epochs);
+        const table *t = current.load(std::memory_order_acquire);
+        for (node *cur = t->buckets[code % t->bucket_count].load(std::memory_order_acquire); cur;
+             cur = cur->next.load(std::memory_order_acquire)) {
+            if (equals(cur->val.first, key)) return true;
+        }
+        return false;
+    }
+
+    // returns false and leaves the map untouched if key is already present
+    bool insert(const value_type &value);
+
+    // replaces the node of an existing key, so readers see either the old or the new value
+    template<class M>
+    bool insert_or_assign(const key_type &key, M &&obj);
+
+    size_type erase(const key_type &key);
+
+    void clear();
+};
+
+template<class Key, class T, class HashFunc, class EqualKey>
+bool lockfree_hash_map<Key, T, HashFunc, EqualKey>::insert(const value_type &value) {
+    const size_type code = hash(value.first);
+    table *t;
+    bool overloaded;
+    {
+        std::unique_lock<std::mutex> guard;
+        t = lock_bucket(code, guard);
+        std::atomic<node *> &head = t->buckets[code % t->bucket_count];
+        node *first = head.load(std::memory_order_relaxed);
+        for (node *cur = first; cur; cur = cur->next.load(std::memory_order_relaxed)) {
+            if (equals(cur->val.first, value.first)) return false;
+        }
+        head.store(new_node(first, value), std::memory_order_release);
+        overloaded = num_elements.fetch_add(1, std::memory_order_relaxed) + 1 > t->bucket_count;
+    }
+    if (overloaded) grow(t);
+    return true;
+}
+
+template<class Key, class T, class HashFunc, class EqualKey>
+template<class M>
+bool lockfree_hash_map<Key, T, HashFunc, EqualKey>::insert_or_assign(const key_type &key, M &&obj) {
+    const size_type code = hash(key);
+    table *t;
+    node *old = nullptr;
+    bool overloaded = false;
+    {
+        std::unique_lock<std::mutex> guard;
+        t = lock_bucket(code, guard);
+        std::atomic<node *> *link = &t->buckets[code % t->bucket_count];
+        for (node *cur = link->load(std::memory_order_relaxed); cur; cur = cur->next.load(std::memory_order_relaxed)) {
+            if (equals(cur->val.first, key)) {
+                node *replacement = new_node(cur->next.load(std::memory_order_relaxed), key, std::forward<M>(obj));
+                link->store(replacement, std::memory_order_release);
+                old = cur;
+                break;
+            }
+            link = &cur->next;
+        }
+        if (!old) {
+            std::atomic<node *> &head = t->buckets[code % t->bucket_count];
+            head.store(new_node(head.load(std::memory_order_relaxed), key, std::forward<M>(obj)),
+                       std::memory_order_release);
+            overloaded = num_elements.fetch_add(1, std::memory_order_relaxed) + 1 > t->bucket_count;
+        }
+    }
+    if (old) {
+        epochs.retire(old, &delete_node);
+        return false;
+    }
+    if (overloaded) grow(t);
+    return true;
+}
+
+template<class Key, class T, class HashFunc, class EqualKey>
+typename lockfree_hash_map<Key, T, HashFunc, EqualKey>::size_type
+lockfree_hash_map<Key, T, HashFunc, EqualKey>::erase(const key_type &key) {
+    const size_type code = hash(key);
+    node *victim = nullptr;
+    {
+        std::unique_lock<std::mutex> guard;
+        table *t = lock_bucket(code, guard);
+        std::atomic<node *> *link = &t->buckets[code % t->bucket_count];
+        for (node *cur = link->load(std::memory_order_relaxed); cur; cur = cur->next.load(std::memory_order_relaxed)) {
+            if (equals(cur->val.first, key)) {
+                // cur->next is left intact, a reader standing on cur can still move on
+                link->store(cur->next.load(std::memory_order_relaxed), std::memory_order_release);
+                num_elements.fetch_sub(1, std::memory_order_relaxed);
+                victim = cur;
+                break;
+            }
+            link = &cur->next;
+        }
+    }
+    if (!victim) return 0;
+    epochs.retire(victim, &delete_node);
+    return 1;
+}
+
+template<class Key, class T, class HashFunc, class EqualKey>
+void lockfree_hash_map<Key, T, HashFunc, EqualKey>::grow(table *seen) {
+    lock_all();
+    table *old = current.load(std::memory_order_relaxed);
+    // another writer may have grown the table while we waited for the stripes
+    if (old != seen || num_elements.load(std::memory_order_relaxed) <= old->bucket_count) {
+        unlock_all();
+        return;
+    }
+    table *t = nullptr;
+    try {
+        t = new_table(num_elements.load(std::memory_order_relaxed) + 1);
+        for (size_type i = 0; i < old->bucket_count; ++i) {
+            for (node *cur = old->buckets[i].load(std::memory_order_relaxed); cur;
+                 cur = cur->next.load(std::memory_order_relaxed)) {
+                std::atomic<node *> &head = t->buckets[hash(cur->val.first) % t->bucket_count];
+                head.store(new_node(head.load(std::memory_order_relaxed), cur->val), std::memory_order_relaxed);
+            }
+        }
+    } catch (...) {
+        if (t) delete_table(t);
+        unlock_all();
+        throw;
+    }
+    current.store(t, std::memory_order_release);
+    unlock_all();
+    epochs.retire(old, &delete_table);
+}
+
+template<class Key, class T, class HashFunc, class EqualKey>
+void lockfree_hash_map<Key, T, HashFunc, EqualKey>::clear() {
+    lock_all();
+    table *old = current.load(std::memory_order_relaxed);
+    table *t;
+    try {
+        t = new_table(old->bucket_count);
+    } catch (...) {
+        unlock_all();
+        throw;
+    }
+    current.store(t, std::memory_order_release);
+    num_elements.store(0, std::memory_order_relaxed);
+    unlock_all();
+    epochs.retire(old, &delete_table);
+}
+
+#endif //BETHSTL_LOCKFREE_HASHMAP_H
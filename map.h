@@ -7,18 +7,17 @@
 #define BETHSTL_MAP_H
 
 #include <algorithm>
+#include <tuple>
 #include "alloc.h"
+#include "function.h"
 #include "tree.h"
 
-template<class Pair>
-struct Select1st : public std::unary_function<Pair, typename Pair::first_type> {
-    const typename Pair::first_type &operator()(const Pair &__x) const {
-        return __x.first;
-    }
-};
-
-template<class Key, class T, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+// Backend picks the tree: rb_tree_backend, or btree_backend<NodeBytes> from btree.h for a
+// B+-tree that keeps values side by side in its leaves
+template<class Key, class T, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR,
+        class Backend = rb_tree_backend>
 class map {
+public:
     typedef Key key_type;
     typedef T data_type;
     typedef T mapped_type;
@@ -26,7 +25,7 @@ class map {
     typedef Compare key_compare;
 
     class value_compare : public std::binary_function<value_type, value_type, bool> {
-        friend class map<Key, T, Compare, Alloc>;
+        friend class map;
 
     protected:
         Compare comp;
@@ -40,17 +39,37 @@ class map {
     };
 
 private:
-    typedef rb_tree<key_type, value_type, Select1st<value_type>, key_compare, Alloc> rep_type;
+    typedef typename Backend::template rebind<key_type, value_type, Select1st<value_type>, key_compare, Alloc>::other
+            rep_type;
     rep_type t;
+
+    template<class K1, class T1, class C1, class A1, class B1>
+    friend bool operator==(const map<K1, T1, C1, A1, B1> &, const map<K1, T1, C1, A1, B1> &);
+
+    template<class K1, class T1, class C1, class A1, class B1>
+    friend bool operator<(const map<K1, T1, C1, A1, B1> &, const map<K1, T1, C1, A1, B1> &);
+
+    // with a backend that summarizes the values, such as rb_tree_aggregate, an element changed in
+    // place would leave the summaries above it stale, so the elements are const as in a set and
+    // a mapped value changes only through insert_or_assign
+    static const bool const_elements = rb_tree_summarizes_values<Backend>::value;
+
+    typedef typename rep_type::iterator rep_iterator;
+
 public:
-    typedef typename rep_type::pointer pointer;
+    typedef typename std::conditional<const_elements, typename rep_type::const_pointer,
+            typename rep_type::pointer>::type pointer;
     typedef typename rep_type::const_pointer const_pointer;
-    typedef typename rep_type::reference reference;
+    typedef typename std::conditional<const_elements, typename rep_type::const_reference,
+            typename rep_type::reference>::type reference;
     typedef typename rep_type::const_reference const_reference;
-    typedef typename rep_type::iterator iterator;
+    typedef typename std::conditional<const_elements, typename rep_type::const_iterator,
+            rep_iterator>::type iterator;
     typedef typename rep_type::const_iterator const_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::node_type node_type;
+    typedef node_insert_return<iterator, node_type> insert_return_type;
 
     map() : t(Compare()) {}
 
@@ -61,9 +80,9 @@ public:
         t.insert_unique(first, last);
     }
 
-    map(const map<Key, T, Compare, Alloc> &x) : t(x.t) {}
+    map(const map &x) : t(x.t) {}
 
-    map<Key, T, Compare, Alloc> &operator=(const map<Key, T, Compare, Alloc> &x) {
+    map &operator=(const map &x) {
         t = x.t;
         return *this;
     }
@@ -87,17 +106,91 @@ public:
     size_type max_size() const { return t.max_size(); }
 
     T &operator[](const key_type &k) {
-        return (*(insert(value_type(k, T())).first)).second;
+        static_assert(!const_elements, "this backend summarizes the mapped values, use insert_or_assign");
+        return (*(try_emplace(k).first)).second;
+    }
+
+    T &operator[](key_type &&k) {
+        static_assert(!const_elements, "this backend summarizes the mapped values, use insert_or_assign");
+        return (*(try_emplace(std::move(k)).first)).second;
+    }
+
+    // mapped value is only constructed from args when k is not present
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type &k, Args &&... args) {
+        return t.try_emplace_unique(k, std::piecewise_construct, std::forward_as_tuple(k),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(key_type &&k, Args &&... args) {
+        return t.try_emplace_unique(k, std::piecewise_construct, std::forward_as_tuple(std::move(k)),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type &k, M &&obj) {
+        std::pair<rep_iterator, bool> result = t.try_emplace_unique(k, k, std::forward<M>(obj));
+        if (!result.second) {
+            (*result.first).second = std::forward<M>(obj);
+            t.refresh(result.first);
+        }
+        return result;
+    }
+
+    // k is moved from only when it is inserted
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(key_type &&k, M &&obj) {
+        std::pair<rep_iterator, bool> result = t.try_emplace_unique(k, std::move(k), std::forward<M>(obj));
+        if (!result.second) {
+            (*result.first).second = std::forward<M>(obj);
+            t.refresh(result.first);
+        }
+        return result;
+    }
+
+    void swap(map &x) { t.swap(x.t); }
+
+    // parallel join-based set operations with the rb_tree backend; x is consumed and left
+    // empty, where both hold a key this map's element stays. see _Rb_tree::unite.
+    void unite(map &x, unsigned threads = 0) { t.unite(x.t, threads); }
+
+    void intersect(map &x, unsigned threads = 0) { t.intersect(x.t, threads); }
+
+    void subtract(map &x, unsigned threads = 0) { t.subtract(x.t, threads); }
+
+    // order statistics in O(log n), with Backend = augmented_rb_tree_backend<rb_tree_order_statistics>:
+    // the element with k elements before it (or end()), the number of keys less than x, and the
+    // number of elements before an iterator or between two
+    iterator select(size_type k) { return t.select(k); }
+
+    const_iterator select(size_type k) const { return t.select(k); }
+
+    size_type rank(const key_type &x) const { return t.rank(x); }
+
+    size_type index_of(const_iterator it) const { return t.index_of(it); }
+
+    difference_type distance(const_iterator first, const_iterator last) const {
+        return (difference_type) t.index_of(last) - (difference_type) t.index_of(first);
     }
 
-    void swap(map<Key, T, Compare, Alloc> &x) { t.swap(x.t); }
+    // subtree aggregates, with Backend = augmented_rb_tree_backend<rb_tree_aggregate<Monoid> >: the
+    // monoid over every element, and over the elements whose key lies in [lo, hi), in O(log n).
+    // the elements are const with this backend and operator[] is unavailable; insert_or_assign
+    // changes a mapped value and refreshes the summaries above it. refresh(it) is for a value
+    // whose mutable members were changed.
+    auto aggregate() const { return t.aggregate(); }
+
+    auto range_aggregate(const key_type &lo, const key_type &hi) const { return t.range_aggregate(lo, hi); }
+
+    void refresh(const_iterator it) { t.refresh(it); }
 
     std::pair<iterator, bool> insert(const value_type &x) {
         return t.insert_unique(x);
     }
 
     iterator insert(iterator pos, const value_type &x) {
-        return t.insert_unique(pos, x);
+        return t.insert_unique((rep_iterator &) pos, x);
     }
 
     template<class InputIterator>
@@ -105,8 +198,22 @@ public:
         t.insert_unique(first, last);
     }
 
+    // node handles: an extracted element keeps its node, insert() and merge() relink nodes
+    // instead of copying elements. merge leaves in source the elements whose key is here already.
+    node_type extract(iterator pos) { return t.extract((rep_iterator &) pos); }
+
+    node_type extract(const key_type &x) { return t.extract(x); }
+
+    insert_return_type insert(node_type &&nh) {
+        typename rep_type::insert_return_type r = t.insert_unique(std::move(nh));
+        insert_return_type result = {r.position, r.inserted, std::move(r.node)};
+        return result;
+    }
+
+    void merge(map &source) { t.merge_unique(source.t); }
+
     void erase(iterator pos) {
-        t.erase(pos);
+        t.erase((rep_iterator &) pos);
     }
 
     size_type erase(const key_type &x) {
@@ -114,7 +221,7 @@ public:
     }
 
     void erase(iterator first, iterator last) {
-        t.erase(first, last);
+        t.erase((rep_iterator &) first, (rep_iterator &) last);
     }
 
     void clear() {
@@ -131,6 +238,56 @@ public:
 
     size_type count(const key_type &x) const { return t.count(x); }
 
+    // heterogeneous lookup, available when Compare is transparent (e.g. std::less<>)
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type find(const K &x) {
+        return t.find(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, const_iterator>::type find(const K &x) const {
+        return t.find(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, size_type>::type count(const K &x) const { return t.count(x); }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type lower_bound(const K &x) {
+        return t.lower_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, const_iterator>::type lower_bound(const K &x) const {
+        return t.lower_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type upper_bound(const K &x) {
+        return t.upper_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, const_iterator>::type upper_bound(const K &x) const {
+        return t.upper_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, std::pair<iterator, iterator> >::type equal_range(const K &x) {
+        return t.equal_range(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, std::pair<const_iterator, const_iterator> >::type
+    equal_range(const K &x) const {
+        return t.equal_range(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, size_type>::type erase(const K &x) {
+        return t.erase(x);
+    }
+
     iterator lower_bound(const key_type &x) {
         return t.lower_bound(x);
     }
@@ -156,13 +313,243 @@ public:
     }
 };
 
-template<class Key, class T, class Compare, class Alloc>
-inline bool operator==(const map<Key, T, Compare, Alloc> &x, const map<Key, T, Compare, Alloc> &y) {
+template<class Key, class T, class Compare, class Alloc, class Backend>
+inline bool operator==(const map<Key, T, Compare, Alloc, Backend> &x, const map<Key, T, Compare, Alloc, Backend> &y) {
+    return x.t == y.t;
+}
+
+template<class Key, class T, class Compare, class Alloc, class Backend>
+inline bool operator<(const map<Key, T, Compare, Alloc, Backend> &x, const map<Key, T, Compare, Alloc, Backend> &y) {
+    return x.t < y.t;
+}
+
+template<class Key, class T, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR,
+        class Backend = rb_tree_backend>
+class multimap {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef Compare key_compare;
+
+    class value_compare {
+        friend class multimap;
+
+    protected:
+        Compare comp;
+
+        value_compare(Compare c) : comp(c) {}
+
+    public:
+        bool operator()(const value_type &x, const value_type &y) const {
+            return comp(x.first, y.first);
+        }
+    };
+
+private:
+    typedef typename Backend::template rebind<key_type, value_type, Select1st<value_type>, key_compare, Alloc>::other
+            rep_type;
+    rep_type t;
+
+    template<class K1, class T1, class C1, class A1, class B1>
+    friend bool operator==(const multimap<K1, T1, C1, A1, B1> &, const multimap<K1, T1, C1, A1, B1> &);
+
+    template<class K1, class T1, class C1, class A1, class B1>
+    friend bool operator<(const multimap<K1, T1, C1, A1, B1> &, const multimap<K1, T1, C1, A1, B1> &);
+
+    // const elements with a backend that summarizes the values, as for map
+    static const bool const_elements = rb_tree_summarizes_values<Backend>::value;
+
+    typedef typename rep_type::iterator rep_iterator;
+
+public:
+    typedef typename std::conditional<const_elements, typename rep_type::const_pointer,
+            typename rep_type::pointer>::type pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename std::conditional<const_elements, typename rep_type::const_reference,
+            typename rep_type::reference>::type reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename std::conditional<const_elements, typename rep_type::const_iterator,
+            rep_iterator>::type iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::node_type node_type;
+
+    multimap() : t(Compare()) {}
+
+    explicit multimap(const Compare &comp) : t(comp) {}
+
+    template<class InputIterator>
+    multimap(InputIterator first, InputIterator last, const Compare &comp = Compare()):t(comp) {
+        t.insert_equal(first, last);
+    }
+
+    multimap(const multimap &x) : t(x.t) {}
+
+    multimap &operator=(const multimap &x) {
+        t = x.t;
+        return *this;
+    }
+
+    key_compare key_comp() const { return t.key_comp(); }
+
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+
+    iterator begin() { return t.begin(); }
+
+    const_iterator begin() const { return t.begin(); }
+
+    iterator end() { return t.end(); }
+
+    const_iterator end() const { return t.end(); }
+
+    bool empty() const { return t.empty(); }
+
+    size_type size() const { return t.size(); }
+
+    size_type max_size() const { return t.max_size(); }
+
+    void swap(multimap &x) { t.swap(x.t); }
+
+    // order statistics in O(log n), as for map
+    iterator select(size_type k) { return t.select(k); }
+
+    const_iterator select(size_type k) const { return t.select(k); }
+
+    size_type rank(const key_type &x) const { return t.rank(x); }
+
+    size_type index_of(const_iterator it) const { return t.index_of(it); }
+
+    difference_type distance(const_iterator first, const_iterator last) const {
+        return (difference_type) t.index_of(last) - (difference_type) t.index_of(first);
+    }
+
+    // subtree aggregates, as for map
+    auto aggregate() const { return t.aggregate(); }
+
+    auto range_aggregate(const key_type &lo, const key_type &hi) const { return t.range_aggregate(lo, hi); }
+
+    void refresh(const_iterator it) { t.refresh(it); }
+
+    // an equal key goes after the ones already present
+    iterator insert(const value_type &x) {
+        return t.insert_equal(x);
+    }
+
+    iterator insert(iterator pos, const value_type &x) {
+        return t.insert_equal((rep_iterator &) pos, x);
+    }
+
+    template<class InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+        t.insert_equal(first, last);
+    }
+
+    // node handles, as for map; merge moves every element of source
+    node_type extract(iterator pos) { return t.extract((rep_iterator &) pos); }
+
+    node_type extract(const key_type &x) { return t.extract(x); }
+
+    iterator insert(node_type &&nh) { return t.insert_equal(std::move(nh)); }
+
+    void merge(multimap &source) { t.merge_equal(source.t); }
+
+    void erase(iterator pos) {
+        t.erase((rep_iterator &) pos);
+    }
+
+    size_type erase(const key_type &x) {
+        return t.erase(x);
+    }
+
+    void erase(iterator first, iterator last) {
+        t.erase((rep_iterator &) first, (rep_iterator &) last);
+    }
+
+    void clear() {
+        t.clear();
+    }
+
+    iterator find(const key_type &x) {
+        return t.find(x);
+    }
+
+    const_iterator find(const key_type &x) const {
+        return t.find(x);
+    }
+
+    size_type count(const key_type &x) const { return t.count(x); }
+
+    iterator lower_bound(const key_type &x) {
+        return t.lower_bound(x);
+    }
+
+    const_iterator lower_bound(const key_type &x) const {
+        return t.lower_bound(x);
+    }
+
+    iterator upper_bound(const key_type &x) {
+        return t.upper_bound(x);
+    }
+
+    const_iterator upper_bound(const key_type &x) const {
+        return t.upper_bound(x);
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type &x) {
+        return t.equal_range(x);
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &x) const {
+        return t.equal_range(x);
+    }
+
+    // heterogeneous lookup, available when Compare is transparent (e.g. std::less<>)
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type find(const K &x) {
+        return t.find(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, const_iterator>::type find(const K &x) const {
+        return t.find(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, size_type>::type count(const K &x) const { return t.count(x); }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type lower_bound(const K &x) {
+        return t.lower_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type upper_bound(const K &x) {
+        return t.upper_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, std::pair<iterator, iterator> >::type equal_range(const K &x) {
+        return t.equal_range(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, size_type>::type erase(const K &x) {
+        return t.erase(x);
+    }
+};
+
+template<class Key, class T, class Compare, class Alloc, class Backend>
+inline bool operator==(const multimap<Key, T, Compare, Alloc, Backend> &x,
+                       const multimap<Key, T, Compare, Alloc, Backend> &y) {
     return x.t == y.t;
 }
 
-template<class Key, class T, class Compare, class Alloc>
-inline bool operator<(const map<Key, T, Compare, Alloc> &x, const map<Key, T, Compare, Alloc> &y) {
+template<class Key, class T, class Compare, class Alloc, class Backend>
+inline bool operator<(const multimap<Key, T, Compare, Alloc, Backend> &x,
+                      const multimap<Key, T, Compare, Alloc, Backend> &y) {
     return x.t < y.t;
 }
 
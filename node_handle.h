@@ -0,0 +1,86 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_NODE_HANDLE_H
+#define BETHSTL_NODE_HANDLE_H
+
+#include <cstddef>
+#include <utility>
+
+// node_handle owns one element taken out of a container by extract(), in a node, until
+// insert() links the node into a container again or the handle is dropped. insert() never
+// allocates or copies; extract() does not either for the trees, whose nodes are allocated one
+// by one, while the B+-tree and the hash tables, whose nodes share memory with their
+// neighbours, move the element once into a node of the handle's own.
+//
+// NodeOps is supplied by the container and says where the value lives and how a dropped
+// node goes away:
+//
+//     static value_type &value(Node *)    the element inside the node
+//     static void drop(Node *)            destroys the element and frees the node
+//
+// the constructor taking a node, get() and release() are meant for the containers only.
+// the node belongs to the handle alone, so it outlives the container it came from.
+template<class Node, class NodeOps>
+class node_handle {
+public:
+    typedef typename NodeOps::value_type value_type;
+
+private:
+    Node *node;
+
+    void reset() {
+        if (node) NodeOps::drop(node);
+        node = nullptr;
+    }
+
+public:
+    node_handle() : node(nullptr) {}
+
+    explicit node_handle(Node *p) : node(p) {}
+
+    node_handle(node_handle &&x) : node(x.node) { x.node = nullptr; }
+
+    node_handle &operator=(node_handle &&x) {
+        if (&x != this) {
+            reset();
+            std::swap(node, x.node);
+        }
+        return *this;
+    }
+
+    node_handle(const node_handle &) = delete;
+
+    node_handle &operator=(const node_handle &) = delete;
+
+    ~node_handle() { reset(); }
+
+    bool empty() const { return node == nullptr; }
+
+    explicit operator bool() const { return node != nullptr; }
+
+    // the element, for a map the key is const as in the container
+    value_type &value() const { return NodeOps::value(node); }
+
+    void swap(node_handle &x) { std::swap(node, x.node); }
+
+    Node *get() const { return node; }
+
+    Node *release() {
+        Node *result = node;
+        node = nullptr;
+        return result;
+    }
+};
+
+// result of inserting a node handle into a container with unique keys: where the key is,
+// and the handle back when the key was already present
+template<class Iterator, class NodeHandle>
+struct node_insert_return {
+    Iterator position;
+    bool inserted;
+    NodeHandle node;
+};
+
+#endif //BETHSTL_NODE_HANDLE_H
@@ -8,14 +8,12 @@
 
 #include <algorithm>
 #include "alloc.h"
+#include "function.h"
 #include "tree.h"
 
-template<class T>
-struct Identity : public std::unary_function<T, T> {
-    const T &operator()(const T &x) const { return x; }
-};
-
-template<class Key, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+// Backend picks the tree as for map: rb_tree_backend or btree_backend<NodeBytes>
+template<class Key, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR,
+        class Backend = rb_tree_backend>
 class set {
 public:
     typedef Key key_type;
@@ -23,8 +21,15 @@ public:
     typedef Compare key_compare;
     typedef Compare value_compare;
 protected:
-    typedef rb_tree<key_type, value_type, Identity<value_type>, Alloc> rep_type;
+    typedef typename Backend::template rebind<key_type, value_type, Identity<value_type>, key_compare, Alloc>::other
+            rep_type;
     rep_type t;     //use rb_tree represent set
+
+    template<class K1, class C1, class A1, class B1>
+    friend bool operator==(const set<K1, C1, A1, B1> &, const set<K1, C1, A1, B1> &);
+
+    template<class K1, class C1, class A1, class B1>
+    friend bool operator<(const set<K1, C1, A1, B1> &, const set<K1, C1, A1, B1> &);
 public:
     typedef typename rep_type::const_pointer pointer;
     typedef typename rep_type::const_pointer const_pointer;
@@ -34,6 +39,8 @@ public:
     typedef typename rep_type::const_iterator const_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    typedef typename rep_type::node_type node_type;
+    typedef node_insert_return<iterator, node_type> insert_return_type;
     typedef typename rep_type::allocator_type allocator_type;
 
     set() : t(Compare()) {}
@@ -50,16 +57,16 @@ public:
         t.insert_unique(first, last);
     }
 
-    set(const set<Key, Compare, Alloc> &x) : t(x.t) {}
+    set(const set &x) : t(x.t) {}
 
-    set<Key, Compare, Alloc> &operator=(const set<Key, Compare, Alloc> &x) {
+    set &operator=(const set &x) {
         t = x.t;
         return *this;
     }
 
-    key_compare key_comp() const { return t.key_compare(); }
+    key_compare key_comp() const { return t.key_comp(); }
 
-    value_compare value_comp() const { return t.key_compare(); }
+    value_compare value_comp() const { return t.key_comp(); }
 
     iterator begin() const { return t.begin(); }
 
@@ -71,7 +78,34 @@ public:
 
     size_type max_size() const { return t.max_size(); }
 
-    void swap(set<Key, Compare, Alloc> &x) { t.swap(x.t); }
+    void swap(set &x) { t.swap(x.t); }
+
+    // parallel join-based set operations with the rb_tree backend; x is consumed and left
+    // empty, where both hold a key this set's element stays. see _Rb_tree::unite.
+    void unite(set &x, unsigned threads = 0) { t.unite(x.t, threads); }
+
+    void intersect(set &x, unsigned threads = 0) { t.intersect(x.t, threads); }
+
+    void subtract(set &x, unsigned threads = 0) { t.subtract(x.t, threads); }
+
+    // order statistics in O(log n), with Backend = augmented_rb_tree_backend<rb_tree_order_statistics>:
+    // the element with k elements before it (or end()), the number of keys less than x, and the
+    // number of elements before an iterator or between two
+    iterator select(size_type k) const { return t.select(k); }
+
+    size_type rank(const key_type &x) const { return t.rank(x); }
+
+    size_type index_of(const_iterator it) const { return t.index_of(it); }
+
+    difference_type distance(const_iterator first, const_iterator last) const {
+        return (difference_type) t.index_of(last) - (difference_type) t.index_of(first);
+    }
+
+    // subtree aggregates, with Backend = augmented_rb_tree_backend<rb_tree_aggregate<Monoid> >: the
+    // monoid over every element, and over the elements in [lo, hi), in O(log n)
+    auto aggregate() const { return t.aggregate(); }
+
+    auto range_aggregate(const key_type &lo, const key_type &hi) const { return t.range_aggregate(lo, hi); }
 
     typedef std::pair<iterator, bool> pair_iterator_bool;
 
@@ -80,7 +114,7 @@ public:
         return std::pair<iterator, bool>(p.first, p.second);
     }
 
-    std::pair<iterator, bool> insert(iterator pos, const value_type &value) {
+    iterator insert(iterator pos, const value_type &value) {
         typedef typename rep_type::iterator rep_iterator;
         return t.insert_unique((rep_iterator &) pos, value);
     }
@@ -90,6 +124,23 @@ public:
         t.insert_unique(first, last);
     }
 
+    // node handles: an extracted element keeps its node, insert() and merge() relink nodes
+    // instead of copying elements. merge leaves in source the elements that are here already.
+    node_type extract(iterator pos) {
+        typedef typename rep_type::iterator rep_iterator;
+        return t.extract((rep_iterator &) pos);
+    }
+
+    node_type extract(const key_type &x) { return t.extract(x); }
+
+    insert_return_type insert(node_type &&nh) {
+        typename rep_type::insert_return_type r = t.insert_unique(std::move(nh));
+        insert_return_type result = {r.position, r.inserted, std::move(r.node)};
+        return result;
+    }
+
+    void merge(set &source) { t.merge_unique(source.t); }
+
     void erase(iterator pos) {
         typedef typename rep_type::iterator rep_iterator;
         t.erase((rep_iterator &) pos);
@@ -120,15 +171,43 @@ public:
         return t.equal_range(x);
     }
 
+    // heterogeneous lookup, available when Compare is transparent (e.g. std::less<>)
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type find(const K &x) const { return t.find(x); }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, size_type>::type count(const K &x) const { return t.count(x); }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type lower_bound(const K &x) const {
+        return t.lower_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, iterator>::type upper_bound(const K &x) const {
+        return t.upper_bound(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, std::pair<iterator, iterator> >::type
+    equal_range(const K &x) const {
+        return t.equal_range(x);
+    }
+
+    template<class K>
+    typename rep_type::template _If_transparent<K, size_type>::type erase(const K &keyValue) {
+        return t.erase(keyValue);
+    }
+
 };
 
-template<class Key, class Compare, class Alloc>
-inline bool operator==(const set<Key, Compare, Alloc> &x, const set<Key, Compare, Alloc> &y) {
+template<class Key, class Compare, class Alloc, class Backend>
+inline bool operator==(const set<Key, Compare, Alloc, Backend> &x, const set<Key, Compare, Alloc, Backend> &y) {
     return x.t == y.t;
 }
 
-template<class Key, class Compare, class Alloc>
-inline bool operator<(const set<Key, Compare, Alloc> &x, const set<Key, Compare, Alloc> &y) {
+template<class Key, class Compare, class Alloc, class Backend>
+inline bool operator<(const set<Key, Compare, Alloc, Backend> &x, const set<Key, Compare, Alloc, Backend> &y) {
     return x.t < y.t;
 }
 
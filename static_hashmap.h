@@ -0,0 +1,363 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_STATIC_HASHMAP_H
+#define BETHSTL_STATIC_HASHMAP_H
+
+#include "alloc.h"
+#include "construct.h"
+#include "function.h"
+#include "hash_fun.h"
+#include "vector.h"
+#include <cstdint>
+#include <stdexcept>
+
+// static_hash_map is a read only map over a key set fixed at construction. it builds a
+// minimal perfect hash in the hash-and-displace style of CHD: keys are split into buckets of
+// a few keys each, largest bucket first every bucket gets the first displacement d for which
+// all of its keys land in free slots. a bucket with a single key records its slot directly.
+//
+// as in PTHash, displacements pick slots out of a range a little larger than size(), so the
+// last buckets still find free slots quickly; the few slots beyond size() are mapped back onto
+// the holes below it through a small remap array. a lookup reads one displacement and one
+// value, one key in SPARE + 1 also reads remap, and compares one key. besides the values the
+// table costs four bytes per bucket plus the remap array, about one and a half bytes per key.
+//
+// keys are hashed with the same HashFunc as hash_map. two distinct keys with the same full
+// hash code cannot be separated and make the constructor throw; repeated keys keep the first.
+template<class Key, class T, class HashFunc = hash<Key>, class EqualKey = std::equal_to<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+class static_hash_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef HashFunc hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+    typedef value_type *iterator;
+    typedef const value_type *const_iterator;
+    typedef Alloc allocator_type;
+
+private:
+    // average keys per bucket, a smaller load finds displacements faster but stores more of them
+    enum {
+        BUCKET_LOAD = 3
+    };
+    // set in a displacement that holds the slot itself
+    enum {
+        DIRECT = 0x80000000u
+    };
+    // one slot beyond size() for every SPARE values
+    enum {
+        SPARE = 16
+    };
+
+    typedef simpleAlloc<value_type, Alloc> data_allocator;
+    typedef simpleAlloc<uint32_t, Alloc> disp_allocator;
+
+    hasher hash;
+    key_equal equals;
+    Select1st<value_type> get_key;
+
+    value_type *values;
+    size_type num_elements;
+    uint32_t *disp;
+    size_type buckets;
+    // remap[s - size()] is the real slot of slot s >= size()
+    uint32_t *remap;
+    size_type spare;
+
+    size_type bucket_of(uint64_t code) const { return (size_type) (hash_int(code) % buckets); }
+
+    // the mixed code is mapped onto [0, n) by its high bits, which costs a multiply, not a division
+    static size_type slot_of(uint64_t code, uint32_t d, size_type n) {
+        const uint64_t x = hash_mix(code ^ __stl_hash_k2, (uint64_t) (d + 1) * __stl_hash_k3);
+#ifdef __SIZEOF_INT128__
+        return (size_type) (((unsigned __int128) x * n) >> 64);
+#else
+        return (size_type) (x % n);
+#endif
+    }
+
+    size_type slot_for(uint64_t code) const {
+        const uint32_t d = disp[bucket_of(code)];
+        if (d & DIRECT) return (size_type) (d & ~(uint32_t) DIRECT);
+        const size_type s = slot_of(code, d, num_elements + spare);
+        return s < num_elements ? s : (size_type) remap[s - num_elements];
+    }
+
+    template<class ForwardIterator>
+    void build(ForwardIterator first, ForwardIterator last);
+
+    void destroy_all() {
+        for (size_type i = 0; i < num_elements; ++i) destroy(&values[i]);
+        data_allocator::deallocate(values, num_elements);
+        disp_allocator::deallocate(disp, buckets);
+        disp_allocator::deallocate(remap, spare);
+        values = nullptr;
+        disp = nullptr;
+        remap = nullptr;
+        num_elements = 0;
+        buckets = 0;
+        spare = 0;
+    }
+
+public:
+    explicit static_hash_map(const hasher &hf = hasher(), const key_equal &eql = key_equal())
+            : hash(hf), equals(eql), values(nullptr), num_elements(0), disp(nullptr), buckets(0),
+              remap(nullptr), spare(0) {}
+
+    // [first, last) is walked more than once, its elements are pairs convertible to value_type
+    template<class ForwardIterator>
+    static_hash_map(ForwardIterator first, ForwardIterator last, const hasher &hf = hasher(),
+                    const key_equal &eql = key_equal())
+            : hash(hf), equals(eql), values(nullptr), num_elements(0), disp(nullptr), buckets(0),
+              remap(nullptr), spare(0) {
+        build(first, last);
+    }
+
+    static_hash_map(const static_hash_map &x);
+
+    static_hash_map &operator=(const static_hash_map &x) {
+        if (&x != this) {
+            static_hash_map temp(x);
+            swap(temp);
+        }
+        return *this;
+    }
+
+    ~static_hash_map() { destroy_all(); }
+
+    void swap(static_hash_map &x) {
+        std::swap(hash, x.hash);
+        std::swap(equals, x.equals);
+        std::swap(values, x.values);
+        std::swap(num_elements, x.num_elements);
+        std::swap(disp, x.disp);
+        std::swap(buckets, x.buckets);
+        std::swap(remap, x.remap);
+        std::swap(spare, x.spare);
+    }
+
+    // replaces the key set, the old table is kept if the build throws
+    template<class ForwardIterator>
+    void assign(ForwardIterator first, ForwardIterator last) {
+        static_hash_map temp(first, last, hash, equals);
+        swap(temp);
+    }
+
+    hasher hash_function() const { return hash; }
+
+    key_equal key_eq() const { return equals; }
+
+    size_type size() const { return num_elements; }
+
+    bool empty() const { return num_elements == 0; }
+
+    size_type bucket_count() const { return buckets; }
+
+    // bytes held for values, displacements and the remap array
+    size_type bytes() const {
+        return num_elements * sizeof(value_type) + (buckets + spare) * sizeof(uint32_t);
+    }
+
+    // values in slot order, not in the order they were given
+    iterator begin() { return values; }
+
+    iterator end() { return values + num_elements; }
+
+    const_iterator begin() const { return values; }
+
+    const_iterator end() const { return values + num_elements; }
+
+    // mapped values may be changed through the iterator, keys may not
+    iterator find(const key_type &key) {
+        if (num_elements == 0) return end();
+        value_type *v = values + slot_for(hash(key));
+        return equals(get_key(*v), key) ? v : end();
+    }
+
+    const_iterator find(const key_type &key) const {
+        if (num_elements == 0) return end();
+        const value_type *v = values + slot_for(hash(key));
+        return equals(get_key(*v), key) ? v : end();
+    }
+
+    size_type count(const key_type &key) const { return find(key) == end() ? 0 : 1; }
+};
+
+template<class Key, class T, class HashFunc, class EqualKey, class Alloc>
+static_hash_map<Key, T, HashFunc, EqualKey, Alloc>::static_hash_map(const static_hash_map &x)
+        : hash(x.hash), equals(x.equals), values(nullptr), num_elements(0), disp(nullptr), buckets(0),
+          remap(nullptr), spare(0) {
+    size_type i = 0;
+    try {
+        disp = disp_allocator::allocate(x.buckets);
+        buckets = x.buckets;
+        for (size_type b = 0; b < buckets; ++b) disp[b] = x.disp[b];
+        remap = disp_allocator::allocate(x.spare);
+        spare = x.spare;
+        for (size_type s = 0; s < spare; ++s) remap[s] = x.remap[s];
+        values = data_allocator::allocate(x.num_elements);
+        for (; i < x.num_elements; ++i) construct(&values[i], x.values[i]);
+    } catch (...) {
+        for (size_type j = 0; j < i; ++j) destroy(&values[j]);
+        if (values) data_allocator::deallocate(values, x.num_elements);
+        if (disp) disp_allocator::deallocate(disp, buckets);
+        if (remap) disp_allocator::deallocate(remap, spare);
+        throw;
+    }
+    num_elements = x.num_elements;
+}
+
+template<class Key, class T, class HashFunc, class EqualKey, class Alloc>
+template<class ForwardIterator>
+void static_hash_map<Key, T, HashFunc, EqualKey, Alloc>::build(ForwardIterator first, ForwardIterator last) {
+    const size_type npos = (size_type) -1;
+    size_type n = 0;
+    for (ForwardIterator cur = first; cur != last; ++cur) ++n;
+    if (n == 0) return;
+    if (n >= (size_type) DIRECT) throw std::length_error("static_hash_map: too many keys");
+
+    const size_type bucket_total = n / BUCKET_LOAD + 1;
+    buckets = bucket_total;
+    vector<ForwardIterator, Alloc> source(n, first);
+    vector<uint64_t, Alloc> codes(n, (uint64_t) 0);
+    size_type i = 0;
+    for (ForwardIterator cur = first; cur != last; ++cur, ++i) {
+        source[i] = cur;
+        codes[i] = hash((*cur).first);
+    }
+
+    // counting sort of the keys by bucket, stable so that each bucket keeps the input order
+    vector<size_type, Alloc> start(bucket_total + 1, (size_type) 0);
+    vector<size_type, Alloc> order(n, (size_type) 0);
+    for (i = 0; i < n; ++i) ++start[bucket_of(codes[i]) + 1];
+    for (size_type b = 0; b < bucket_total; ++b) start[b + 1] += start[b];
+    for (i = 0; i < n; ++i) order[start[bucket_of(codes[i])]++] = i;
+    for (size_type b = bucket_total; b > 0; --b) start[b] = start[b - 1];
+    start[0] = 0;
+
+    // equal keys have equal codes and share a bucket, so repeats are dropped here keeping the
+    // first. distinct keys with one code are beyond any displacement.
+    vector<size_type, Alloc> slot(n, npos);
+    size_type m = 0, max_size = 0;
+    for (size_type b = 0; b < bucket_total; ++b) {
+        const size_type bucket_start = m;
+        for (size_type k = start[b]; k < start[b + 1]; ++k) {
+            const size_type key = order[k];
+            bool repeat = false;
+            for (size_type j = bucket_start; j < m && !repeat; ++j) {
+                if (codes[order[j]] != codes[key]) continue;
+                if (!equals((*source[order[j]]).first, (*source[key]).first))
+                    throw std::invalid_argument("static_hash_map: distinct keys share a hash code");
+                repeat = true;
+            }
+            if (!repeat) order[m++] = key;
+        }
+        start[b] = bucket_start;
+        if (m - bucket_start > max_size) max_size = m - bucket_start;
+    }
+    start[bucket_total] = m;
+
+    // buckets by size, largest first, so the big ones meet an empty table
+    vector<size_type, Alloc> by_size(bucket_total, (size_type) 0);
+    {
+        vector<size_type, Alloc> position(max_size + 2, (size_type) 0);
+        for (size_type b = 0; b < bucket_total; ++b) ++position[max_size - (start[b + 1] - start[b]) + 1];
+        for (size_type s = 0; s <= max_size; ++s) position[s + 1] += position[s];
+        for (size_type b = 0; b < bucket_total; ++b) by_size[position[max_size - (start[b + 1] - start[b])]++] = b;
+    }
+
+    const size_type range = m + m / SPARE + 1;
+    vector<uint32_t, Alloc> displacement(bucket_total, (uint32_t) 0);
+    // one bit per slot keeps the randomly probed set in cache for large tables
+    vector<uint64_t, Alloc> taken(range / 64 + 1, (uint64_t) 0);
+    size_type k = 0;
+    for (; k < bucket_total; ++k) {
+        const size_type b = by_size[k];
+        const size_type first_key = start[b], size = start[b + 1] - start[b];
+        if (size < 2) break;
+        for (uint32_t d = 0;; ++d) {
+            if (d == (uint32_t) DIRECT) throw std::runtime_error("static_hash_map: no displacement found");
+            size_type j = 0;
+            for (; j < size; ++j) {
+                const size_type s = slot_of(codes[order[first_key + j]], d, range);
+                if (taken[s / 64] >> (s % 64) & 1) break;
+                taken[s / 64] |= (uint64_t) 1 << (s % 64);
+                slot[order[first_key + j]] = s;
+            }
+            if (j == size) {
+                displacement[b] = d;
+                break;
+            }
+            // give back this attempt's slots, a clash between two of its own keys included
+            while (j > 0) {
+                --j;
+                const size_type s = slot[order[first_key + j]];
+                taken[s / 64] &= ~((uint64_t) 1 << (s % 64));
+            }
+        }
+    }
+
+    // the holes below m take the keys that landed beyond it, then the single key buckets
+    vector<uint32_t, Alloc> remapped(range - m, (uint32_t) 0);
+    size_type next_free = 0;
+    for (size_type j = 0; j < n; ++j) {
+        if (slot[j] == npos || slot[j] < m) continue;
+        while (taken[next_free / 64] >> (next_free % 64) & 1) ++next_free;
+        taken[next_free / 64] |= (uint64_t) 1 << (next_free % 64);
+        remapped[slot[j] - m] = (uint32_t) next_free;
+        slot[j] = next_free;
+    }
+    for (; k < bucket_total; ++k) {
+        const size_type b = by_size[k];
+        if (start[b + 1] == start[b]) break;
+        while (taken[next_free / 64] >> (next_free % 64) & 1) ++next_free;
+        taken[next_free / 64] |= (uint64_t) 1 << (next_free % 64);
+        slot[order[start[b]]] = next_free;
+        displacement[b] = (uint32_t) next_free | (uint32_t) DIRECT;
+    }
+
+    // the values are copied in input order, repeats have no slot
+    value_type *result = data_allocator::allocate(m);
+    i = 0;
+    try {
+        for (; i < n; ++i) {
+            if (slot[i] != npos) construct(&result[slot[i]], *source[i]);
+        }
+    } catch (...) {
+        while (i > 0) {
+            --i;
+            if (slot[i] != npos) destroy(&result[slot[i]]);
+        }
+        data_allocator::deallocate(result, m);
+        throw;
+    }
+    try {
+        disp = disp_allocator::allocate(bucket_total);
+        remap = disp_allocator::allocate(range - m);
+    } catch (...) {
+        for (i = 0; i < n; ++i) {
+            if (slot[i] != npos) destroy(&result[slot[i]]);
+        }
+        data_allocator::deallocate(result, m);
+        if (disp) disp_allocator::deallocate(disp, bucket_total);
+        disp = nullptr;
+        throw;
+    }
+    for (size_type b = 0; b < bucket_total; ++b) disp[b] = displacement[b];
+    for (size_type s = 0; s < range - m; ++s) remap[s] = remapped[s];
+    spare = range - m;
+    values = result;
+    num_elements = m;
+}
+
+#endif //BETHSTL_STATIC_HASHMAP_H
@@ -0,0 +1,303 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#ifndef BETHSTL_STATIC_SET_H
+#define BETHSTL_STATIC_SET_H
+
+#include "alloc.h"
+#include "config.h"
+#include "construct.h"
+#include "iterator.h"
+#include "vector.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+// static_set is a read only sorted set over keys fixed at construction, laid out for search
+// rather than for scanning. the keys are stored in Eytzinger order: the array is a complete
+// binary search tree read breadth first, the root at index 1 and the children of k at 2k and
+// 2k + 1. a search is a descent k = 2k + (key at k < x) with no branch to mispredict, and the
+// first levels, the ones every search reads, share a few cache lines at the front.
+//
+// a node's descendants PREFETCH_SHIFT levels down are contiguous, and with the array aligned
+// to a cache line they fill one line, so each step prefetches the line it will read that many
+// steps later. a lookup then waits on about one miss per PREFETCH_SHIFT levels instead of one
+// per level, which is where it beats lower_bound over a sorted array once the keys no longer
+// fit in L2. repeated keys keep the first. iteration is in key order.
+template<class Key>
+struct static_set_iterator {
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef Key value_type;
+    typedef const Key *pointer;
+    typedef const Key &reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    typedef static_set_iterator _self;
+
+    const Key *tree;
+    size_type k;    // index in tree, 0 past the end
+    size_type n;
+
+    static_set_iterator() : tree(nullptr), k(0), n(0) {}
+
+    static_set_iterator(const Key *t, size_type i, size_type size) : tree(t), k(i), n(size) {}
+
+    reference operator*() const { return tree[k]; }
+
+    pointer operator->() const { return &tree[k]; }
+
+    // the successor is the leftmost node of the right subtree, or else the first ancestor
+    // reached from a left child
+    _self &operator++() {
+        if (2 * k + 1 <= n) {
+            k = 2 * k + 1;
+            while (2 * k <= n) k = 2 * k;
+        } else {
+            while (k & 1) k >>= 1;
+            k >>= 1;
+        }
+        return *this;
+    }
+
+    _self operator++(int) {
+        _self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    _self &operator--() {
+        if (k == 0) {
+            k = n == 0 ? 0 : 1;
+            while (k && 2 * k + 1 <= n) k = 2 * k + 1;
+        } else if (2 * k <= n) {
+            k = 2 * k;
+            while (2 * k + 1 <= n) k = 2 * k + 1;
+        } else {
+            while (k != 0 && !(k & 1)) k >>= 1;
+            k >>= 1;
+        }
+        return *this;
+    }
+
+    _self operator--(int) {
+        _self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    bool operator==(const _self &x) const { return k == x.k; }
+
+    bool operator!=(const _self &x) const { return k != x.k; }
+};
+
+template<class Key, class Compare = std::less<Key>, class Alloc = STL_DEFAULT_ALLOCATOR>
+class static_set {
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef static_set_iterator<Key> iterator;
+    typedef static_set_iterator<Key> const_iterator;
+    typedef const Key &reference;
+    typedef const Key &const_reference;
+    typedef const Key *pointer;
+    typedef const Key *const_pointer;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
+
+private:
+    enum {
+        LINE = 64
+    };
+    // levels between a node and the line of descendants it prefetches, log2 of keys per line
+    enum {
+        PREFETCH_SHIFT = sizeof(Key) <= 4 ? 4 : sizeof(Key) <= 8 ? 3 : sizeof(Key) <= 16 ? 2 : 1
+    };
+    // bytes allocated beyond n + 1 keys so that tree can start on a line, whatever the
+    // alignment of the allocator; none when keys do not tile a line evenly
+    enum {
+        PAD = LINE % sizeof(Key) == 0 ? LINE : 0
+    };
+
+    typedef simpleAlloc<char, Alloc> data_allocator;
+
+    key_compare comp;
+    char *raw;
+    Key *tree;          // tree[1] .. tree[num_elements], tree[0] is never constructed
+    size_type num_elements;
+
+    static size_type first_in_order(size_type n) {
+        size_type k = n == 0 ? 0 : 1;
+        while (k && 2 * k <= n) k = 2 * k;
+        return k;
+    }
+
+    // the descent stops below a leaf; the answer is the last node it left to the left,
+    // found by dropping the trailing right turns and then one more level
+    static size_type drop_right_turns(size_type k) {
+#if defined(__GNUC__) || defined(__clang__)
+        return k >> (__builtin_ctzll(~(unsigned long long) k) + 1);
+#else
+        while (k & 1) k >>= 1;
+        return k >> 1;
+#endif
+    }
+
+    void prefetch(size_type k) const {
+        // by address, the line may lie past the end of the array
+        __stl_prefetch((const void *) ((uintptr_t) tree + (k << PREFETCH_SHIFT) * sizeof(Key)));
+    }
+
+    size_type lower_index(const key_type &x) const {
+        const size_type n = num_elements;
+        size_type k = 1;
+        while (k <= n) {
+            prefetch(k);
+            k = 2 * k + (size_type) comp(tree[k], x);
+        }
+        return drop_right_turns(k);
+    }
+
+    size_type upper_index(const key_type &x) const {
+        const size_type n = num_elements;
+        size_type k = 1;
+        while (k <= n) {
+            prefetch(k);
+            k = 2 * k + (size_type) !comp(x, tree[k]);
+        }
+        return drop_right_turns(k);
+    }
+
+    size_type find_index(const key_type &x) const {
+        size_type k = lower_index(x);
+        return k != 0 && !comp(x, tree[k]) ? k : 0;
+    }
+
+    iterator at_index(size_type k) const { return iterator(tree, k, num_elements); }
+
+    static size_type storage_bytes(size_type n) { return (n + 1) * sizeof(Key) + PAD; }
+
+    // raw storage for n keys with tree[1] .. tree[n] inside it and tree on a line when PAD allows.
+    // raw is aligned for Key and a line boundary is too, so rounding up stays aligned for Key
+    void allocate_tree(size_type n) {
+        raw = data_allocator::allocate(storage_bytes(n));
+        tree = (Key *) raw;
+        if (PAD != 0)
+            tree = (Key *) (((uintptr_t) raw + LINE - 1) & ~(uintptr_t) (LINE - 1));
+    }
+
+    // fills tree[1 .. n] from keys sorted and unique, in order; frees the storage on a throw
+    void fill_tree(const Key *sorted, size_type n);
+
+    void destroy_all() {
+        if (raw) {
+            iterator it = at_index(first_in_order(num_elements));
+            for (; it.k != 0; ++it) destroy(&tree[it.k]);
+            data_allocator::deallocate(raw, storage_bytes(num_elements));
+        }
+        raw = nullptr;
+        tree = nullptr;
+        num_elements = 0;
+    }
+
+public:
+    explicit static_set(const Compare &c = Compare()) : comp(c), raw(nullptr), tree(nullptr), num_elements(0) {}
+
+    template<class InputIterator>
+    static_set(InputIterator first, InputIterator last, const Compare &c = Compare())
+            : comp(c), raw(nullptr), tree(nullptr), num_elements(0) {
+        vector<Key, Alloc> sorted;
+        for (; first != last; ++first) sorted.push_back(*first);
+        std::stable_sort(sorted.begin(), sorted.end(), comp);
+        key_compare cmp = comp;
+        Key *end = std::unique(sorted.begin(), sorted.end(),
+                               [&cmp](const Key &x, const Key &y) { return !cmp(x, y); });
+        fill_tree(sorted.begin(), (size_type) (end - sorted.begin()));
+    }
+
+    static_set(const static_set &x) : comp(x.comp), raw(nullptr), tree(nullptr), num_elements(0) {
+        vector<Key, Alloc> sorted;
+        for (iterator it = x.begin(); it != x.end(); ++it) sorted.push_back(*it);
+        fill_tree(sorted.begin(), sorted.size());
+    }
+
+    static_set &operator=(const static_set &x) {
+        if (&x != this) {
+            static_set temp(x);
+            swap(temp);
+        }
+        return *this;
+    }
+
+    ~static_set() { destroy_all(); }
+
+    void swap(static_set &x) {
+        std::swap(comp, x.comp);
+        std::swap(raw, x.raw);
+        std::swap(tree, x.tree);
+        std::swap(num_elements, x.num_elements);
+    }
+
+    // replaces the key set, the old one is kept if the build throws
+    template<class InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        static_set temp(first, last, comp);
+        swap(temp);
+    }
+
+    key_compare key_comp() const { return comp; }
+
+    value_compare value_comp() const { return comp; }
+
+    size_type size() const { return num_elements; }
+
+    bool empty() const { return num_elements == 0; }
+
+    iterator begin() const { return at_index(first_in_order(num_elements)); }
+
+    iterator end() const { return at_index(0); }
+
+    iterator find(const key_type &x) const { return at_index(find_index(x)); }
+
+    size_type count(const key_type &x) const { return find_index(x) != 0; }
+
+    iterator lower_bound(const key_type &x) const { return at_index(lower_index(x)); }
+
+    iterator upper_bound(const key_type &x) const { return at_index(upper_index(x)); }
+
+    std::pair<iterator, iterator> equal_range(const key_type &x) const {
+        size_type k = find_index(x);
+        iterator first = at_index(k);
+        iterator last = first;
+        if (k != 0) ++last;
+        return std::pair<iterator, iterator>(first, last);
+    }
+};
+
+template<class Key, class Compare, class Alloc>
+void static_set<Key, Compare, Alloc>::fill_tree(const Key *sorted, size_type n) {
+    if (n == 0) return;
+    allocate_tree(n);
+    num_elements = n;
+    // an in-order walk of the implicit tree visits its slots in key order
+    iterator it = at_index(first_in_order(n));
+    size_type i = 0;
+    try {
+        for (; i < n; ++i, ++it) construct(&tree[it.k], sorted[i]);
+    } catch (...) {
+        iterator undo = at_index(first_in_order(n));
+        for (; i > 0; --i, ++undo) destroy(&tree[undo.k]);
+        data_allocator::deallocate(raw, storage_bytes(n));
+        raw = nullptr;
+        tree = nullptr;
+        num_elements = 0;
+        throw;
+    }
+}
+
+#endif //BETHSTL_STATIC_SET_H
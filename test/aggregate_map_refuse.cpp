@@ -0,0 +1,13 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "map.h"
+
+// must not compile: m[1] += 1000 would change a value behind the back of the sums above it
+int main() {
+    map<int, long, std::less<int>, STL_DEFAULT_ALLOCATOR,
+            augmented_rb_tree_backend<rb_tree_aggregate<rb_tree_sum<long> > > > m;
+    m[1] += 1000;
+    return (int) m.aggregate();
+}
@@ -0,0 +1,97 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "map.h"
+#include "set.h"
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <random>
+#include <set>
+
+struct checked_set : public set<int> {
+    bool valid() const { return t.__rb_verify(); }
+};
+
+// ascending keys take the append path past the rightmost node, the rest descend as before
+static void test_append_then_random() {
+    std::mt19937 rng(9);
+    checked_set s;
+    std::set<int> ref;
+    for (int i = 0; i < 5000; ++i) {
+        s.insert(i * 2);
+        ref.insert(i * 2);
+    }
+    for (int i = 0; i < 5000; ++i) {
+        const int k = (int) (rng() % 12000);
+        s.insert(k);
+        ref.insert(k);
+    }
+    assert(s.valid() && s.size() == ref.size() && std::equal(s.begin(), s.end(), ref.begin()));
+    assert(!s.insert(9998).second);
+    assert(!s.insert(*ref.rbegin()).second);
+}
+
+// a hint at the element before the key, at the element after it, and one that is wrong
+static void test_hints() {
+    std::mt19937 rng(9);
+    checked_set h;
+    std::set<int> ref;
+    set<int>::iterator it = h.end();
+    for (int i = 0; i < 3000; ++i) {
+        it = h.insert(it, i);
+        ref.insert(i);
+        assert(*it == i);
+    }
+    for (int i = 0; i < 3000; ++i) {
+        const int k = (int) (rng() % 6000) - 1000;
+        set<int>::iterator pos = h.find(k);
+        h.insert(pos != h.end() ? pos : h.begin(), k);
+        ref.insert(k);
+    }
+    for (int i = 0; i < 3000; ++i) {
+        const int k = (int) (rng() % 6000) - 1000;
+        set<int>::iterator pos = h.lower_bound(k);
+        if (pos != h.begin() && rng() % 2) --pos;
+        h.insert(pos, k);
+        ref.insert(k);
+    }
+    assert(h.valid() && h.size() == ref.size() && std::equal(h.begin(), h.end(), ref.begin()));
+}
+
+// equal keys append after the last one, so the order among them is insertion order
+static void test_multimap() {
+    std::mt19937 rng(9);
+    multimap<int, int> m;
+    std::multimap<int, int> ref;
+    for (int i = 0; i < 4000; ++i) {
+        m.insert(std::make_pair(i / 3, i));
+        ref.insert(std::make_pair(i / 3, i));
+    }
+    for (int i = 0; i < 4000; ++i) {
+        const int k = (int) (rng() % 1500);
+        m.insert(std::make_pair(k, i));
+        ref.insert(std::make_pair(k, i));
+    }
+    assert(m.size() == ref.size());
+    multimap<int, int>::iterator a = m.begin();
+    for (std::multimap<int, int>::iterator b = ref.begin(); b != ref.end(); ++a, ++b)
+        assert(a->first == b->first && a->second == b->second);
+}
+
+static void test_subscript() {
+    map<int, int> m;
+    for (int i = 0; i < 1000; ++i) m[i] = i;
+    assert(m.size() == 1000 && m[500] == 500 && m[999] == 999);
+    m[-1] = 7;
+    assert(m.size() == 1001 && m.begin()->second == 7);
+}
+
+int main() {
+    test_append_then_random();
+    test_hints();
+    test_multimap();
+    test_subscript();
+    return 0;
+}
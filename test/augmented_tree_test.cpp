@@ -0,0 +1,167 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "map.h"
+#include "set.h"
+#include <cassert>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <type_traits>
+
+typedef map<int, long, std::less<int>, STL_DEFAULT_ALLOCATOR,
+        augmented_rb_tree_backend<rb_tree_aggregate<rb_tree_sum<long> > > > sum_map;
+typedef multimap<int, int, std::less<int>, STL_DEFAULT_ALLOCATOR,
+        augmented_rb_tree_backend<rb_tree_aggregate<rb_tree_max<int> > > > max_multimap;
+typedef set<int, std::less<int>, STL_DEFAULT_ALLOCATOR,
+        augmented_rb_tree_backend<rb_tree_order_statistics> > ranked_set;
+typedef map<int, int, std::less<int>, STL_DEFAULT_ALLOCATOR,
+        augmented_rb_tree_backend<rb_tree_order_statistics> > ranked_map;
+
+// a summary of the values goes stale if a value changes in place, so those elements are const;
+// the node counts do not depend on the values, so an order statistics map stays writable
+static_assert(std::is_const<std::remove_reference<sum_map::reference>::type>::value, "");
+static_assert(std::is_const<std::remove_reference<decltype(*std::declval<sum_map::iterator>())>::type>::value, "");
+static_assert(std::is_const<std::remove_reference<decltype(*std::declval<max_multimap::iterator>())>::type>::value, "");
+static_assert(!std::is_const<std::remove_reference<decltype(*std::declval<ranked_map::iterator>())>::type>::value, "");
+
+// select, rank, index_of and distance of every element and of keys between them, against the
+// position in a sorted std container
+template<class Tree, class Ref>
+static void check_order(const Tree &t, const Ref &ref, int range) {
+    assert(t.size() == ref.size());
+    typename Tree::const_iterator it = t.begin();
+    size_t i = 0;
+    for (typename Ref::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it, ++i) {
+        assert(t.select(i) == it && t.index_of(it) == i);
+        assert(t.distance(t.begin(), it) == (typename Tree::difference_type) i);
+        assert(t.distance(it, t.end()) == (typename Tree::difference_type) (ref.size() - i));
+    }
+    assert(t.select(ref.size()) == t.end() && t.index_of(t.end()) == ref.size());
+    assert(t.select(ref.size() + 5) == t.end());
+    for (int k = -2; k < range + 2; ++k) {
+        const size_t less = (size_t) std::distance(ref.begin(), ref.lower_bound(k));
+        assert(t.rank(k) == less);
+    }
+}
+
+// sum over [lo, hi) for every pair of bounds, lo == hi and lo > hi included
+static void check_sums(const sum_map &m, const std::map<int, long> &ref, int range) {
+    long total = 0;
+    for (std::map<int, long>::const_iterator r = ref.begin(); r != ref.end(); ++r) total += r->second;
+    assert(m.aggregate() == total);
+    for (int lo = -1; lo <= range + 1; lo += 3)
+        for (int hi = lo - 2; hi <= range + 1; ++hi) {
+            long want = 0;
+            for (std::map<int, long>::const_iterator r = ref.lower_bound(lo); r != ref.end() && r->first < hi; ++r)
+                want += r->second;
+            assert(m.range_aggregate(lo, hi) == want);
+        }
+}
+
+static void test_sum_map() {
+    const int range = 300;
+    sum_map m;
+    std::map<int, long> ref;
+    std::mt19937 rng(43);
+    for (int step = 0; step < 3000; ++step) {
+        const int k = (int) (rng() % range);
+        const long v = (long) (rng() % 2001) - 1000;
+        switch (rng() % 4) {
+            case 0:
+                assert(m.insert(std::make_pair(k, v)).second == ref.insert(std::make_pair(k, v)).second);
+                break;
+            case 1:
+                // the summaries follow a mapped value that insert_or_assign replaces
+                assert(m.insert_or_assign(k, v).second == (ref.count(k) == 0));
+                ref[k] = v;
+                break;
+            case 2:
+                assert(m.erase(k) == ref.erase(k));
+                break;
+            default:
+                if (!ref.empty()) {
+                    sum_map::iterator it = m.select(rng() % m.size());
+                    ref.erase(it->first);
+                    m.erase(it);
+                }
+        }
+        if (step % 100 == 0) {
+            check_order(m, ref, range);
+            check_sums(m, ref, range);
+        }
+    }
+    check_order(m, ref, range);
+    check_sums(m, ref, range);
+
+    // m[k] += 1000 does not compile here; insert_or_assign is the way to change a value
+    const int k = m.begin()->first;
+    const long before = m.aggregate();
+    m.insert_or_assign(k, m.begin()->second + 1000);
+    assert(m.aggregate() == before + 1000 && m.range_aggregate(k, k + 1) == m.find(k)->second);
+
+    m.clear();
+    assert(m.aggregate() == 0 && m.range_aggregate(0, range) == 0 && m.select(0) == m.end());
+}
+
+static void test_max_multimap() {
+    const int range = 100;
+    max_multimap m;
+    std::multimap<int, int> ref;
+    std::mt19937 rng(44);
+    for (int step = 0; step < 2000; ++step) {
+        const int k = (int) (rng() % range);
+        if (rng() % 3) {
+            const int v = (int) (rng() % 100000);
+            m.insert(std::make_pair(k, v));
+            ref.insert(std::make_pair(k, v));
+        } else {
+            assert(m.erase(k) == ref.erase(k));
+        }
+        if (step % 50 == 0) {
+            check_order(m, ref, range);
+            for (int lo = -1; lo <= range; lo += 7)
+                for (int hi = lo - 1; hi <= range + 1; hi += 2) {
+                    int want = std::numeric_limits<int>::lowest();
+                    for (std::multimap<int, int>::const_iterator r = ref.lower_bound(lo); r != ref.end() && r->first < hi; ++r)
+                        if (r->second > want) want = r->second;
+                    assert(m.range_aggregate(lo, hi) == want);
+                }
+        }
+    }
+}
+
+// order statistics alone: a set, and a map whose values stay writable
+static void test_order_statistics() {
+    const int range = 2000;
+    ranked_set s;
+    std::set<int> ref;
+    ranked_map m;
+    std::mt19937 rng(45);
+    for (int step = 0; step < 20000; ++step) {
+        const int k = (int) (rng() % range);
+        if (rng() % 3) {
+            assert(s.insert(k).second == ref.insert(k).second);
+            m[k] = k;
+        } else {
+            assert(s.erase(k) == ref.erase(k));
+            m.erase(k);
+        }
+        if (step % 2000 == 0) {
+            check_order(s, ref, range);
+            assert(s.aggregate() == ref.size() && m.size() == ref.size());
+        }
+    }
+    check_order(s, ref, range);
+    for (ranked_map::iterator it = m.begin(); it != m.end(); ++it) it->second = -it->second;
+    for (size_t i = 0; i < m.size(); ++i) assert(m.select(i)->second == -m.select(i)->first);
+}
+
+int main() {
+    test_sum_map();
+    test_max_multimap();
+    test_order_statistics();
+    return 0;
+}
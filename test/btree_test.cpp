@@ -0,0 +1,206 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "btree.h"
+#include "map.h"
+#include "set.h"
+#include <cassert>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+
+// the same elements in the same order, walked forwards and backwards
+template<class Tree, class Ref>
+static void check_same(const Tree &t, const Ref &ref) {
+    assert(t.size() == ref.size());
+    typename Tree::const_iterator it = t.begin();
+    for (typename Ref::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it) {
+        assert(it != t.end());
+        assert(*it == *r);
+    }
+    assert(it == t.end());
+    for (typename Ref::const_reverse_iterator r = ref.rbegin(); r != ref.rend(); ++r) {
+        --it;
+        assert(*it == *r);
+    }
+    assert(it == t.begin());
+}
+
+// random inserts, erases, bounds and operator[] against std::map; values are strings long
+// enough to allocate, so a missed destroy or copy shows up under the sanitizers
+template<size_t NodeBytes>
+static void test_map(unsigned seed, int range, int ops) {
+    typedef map<int, std::string, std::less<int>, STL_DEFAULT_ALLOCATOR, btree_backend<NodeBytes> > M;
+    M m;
+    std::map<int, std::string> ref;
+    std::mt19937 rng(seed);
+    for (int i = 0; i < ops; ++i) {
+        const int k = (int) (rng() % range);
+        const unsigned op = rng() % 10;
+        if (op < 5) {
+            std::string v = std::to_string(k) + "-a-value-past-the-small-string-buffer";
+            std::pair<typename M::iterator, bool> r = m.insert(std::make_pair(k, v));
+            assert(r.second == ref.insert(std::make_pair(k, v)).second);
+            assert(r.first->first == k);
+        } else if (op < 7) {
+            assert(m.erase(k) == ref.erase(k));
+        } else if (op < 8) {
+            typename M::iterator it = m.find(k);
+            std::map<int, std::string>::iterator r = ref.find(k);
+            assert((it == m.end()) == (r == ref.end()));
+            if (r != ref.end()) {
+                m.erase(it);
+                ref.erase(r);
+            }
+        } else if (op < 9) {
+            typename M::iterator a = m.lower_bound(k);
+            std::map<int, std::string>::iterator b = ref.lower_bound(k);
+            assert((a == m.end()) == (b == ref.end()));
+            if (b != ref.end()) assert(a->first == b->first);
+            a = m.upper_bound(k);
+            b = ref.upper_bound(k);
+            assert((a == m.end()) == (b == ref.end()));
+            if (b != ref.end()) assert(a->first == b->first);
+        } else {
+            m[k] += "y";
+            ref[k] += "y";
+        }
+        if (i % 997 == 0) check_same(m, ref);
+    }
+    check_same(m, ref);
+
+    M copy(m);
+    check_same(copy, ref);
+    assert(copy == m);
+
+    m.erase(m.lower_bound(range / 4), m.lower_bound(range / 2));
+    ref.erase(ref.lower_bound(range / 4), ref.lower_bound(range / 2));
+    check_same(m, ref);
+    while (!ref.empty()) {
+        const int k = ref.begin()->first;
+        ref.erase(k);
+        assert(m.erase(k) == 1);
+    }
+    assert(m.empty() && m.begin() == m.end());
+}
+
+// duplicates, erasing the middle one of a run, and ascending appends past the last leaf
+template<size_t NodeBytes>
+static void test_multimap(unsigned seed, int range, int ops) {
+    typedef multimap<int, int, std::less<int>, STL_DEFAULT_ALLOCATOR, btree_backend<NodeBytes> > M;
+    M m;
+    std::multimap<int, int> ref;
+    std::mt19937 rng(seed);
+    for (int i = 0; i < ops; ++i) {
+        const int k = (int) (rng() % range);
+        const unsigned op = rng() % 10;
+        if (op < 6) {
+            typename M::iterator it = m.insert(std::make_pair(k, i));
+            ref.insert(std::make_pair(k, i));
+            assert(it->first == k && it->second == i);
+        } else if (op < 7) {
+            assert(m.erase(k) == ref.erase(k));
+        } else if (op < 9) {
+            std::pair<std::multimap<int, int>::iterator, std::multimap<int, int>::iterator> r = ref.equal_range(k);
+            const size_t n = (size_t) std::distance(r.first, r.second);
+            assert(m.count(k) == n);
+            if (n) {
+                std::multimap<int, int>::iterator jt = r.first;
+                std::advance(jt, n / 2);
+                typename M::iterator it = m.equal_range(k).first;
+                for (size_t j = 0; j < n / 2; ++j) ++it;
+                assert(it->second == jt->second);
+                m.erase(it);
+                ref.erase(jt);
+            }
+        } else {
+            m.insert(std::make_pair(range + i, i));
+            ref.insert(std::make_pair(range + i, i));
+        }
+        if (i % 991 == 0) check_same(m, ref);
+    }
+    check_same(m, ref);
+}
+
+// ascending then descending fills, then random erases that merge and borrow between leaves
+template<size_t NodeBytes>
+static void test_set(unsigned seed) {
+    typedef set<long, std::less<long>, STL_DEFAULT_ALLOCATOR, btree_backend<NodeBytes> > S;
+    S s;
+    std::set<long> ref;
+    for (long i = 0; i < 20000; ++i) {
+        s.insert(i * 3);
+        ref.insert(i * 3);
+    }
+    check_same(s, ref);
+    for (long i = 20000; i-- > 0;) {
+        s.insert(i * 3 + 1);
+        ref.insert(i * 3 + 1);
+    }
+    check_same(s, ref);
+    std::mt19937 rng(seed);
+    for (int i = 0; i < 30000; ++i) {
+        const long k = (long) (rng() % 60000);
+        assert(s.erase(k) == ref.erase(k));
+    }
+    check_same(s, ref);
+    assert(s.count(3) == ref.count(3));
+    S copy(s);
+    assert(copy == s && !(copy < s));
+}
+
+// erase(iterator) on the tree itself returns the element after the erased one
+template<size_t NodeBytes>
+static void test_erase_returns_next(unsigned seed) {
+    typedef btree<int, int, Identity<int>, std::less<int>, STL_DEFAULT_ALLOCATOR, NodeBytes> T;
+    T t{std::less<int>()};
+    std::multiset<int> ref;
+    std::mt19937 rng(seed);
+    for (int i = 0; i < 30000; ++i) {
+        const int k = (int) (rng() % 3000);
+        if (rng() % 3) {
+            t.insert_equal(k);
+            ref.insert(k);
+            continue;
+        }
+        std::multiset<int>::iterator r = ref.lower_bound(k);
+        if (r == ref.end()) continue;
+        typename T::iterator it = t.lower_bound(k);
+        assert(*it == *r);
+        typename T::iterator next = t.erase(it);
+        r = ref.erase(r);
+        assert((next == t.end()) == (r == ref.end()));
+        if (r != ref.end()) assert(*next == *r);
+    }
+    check_same(t, ref);
+    t.erase(t.begin(), t.end());
+    assert(t.size() == 0);
+}
+
+static void test_transparent() {
+    map<std::string, int, std::less<>, STL_DEFAULT_ALLOCATOR, btree_backend<> > m;
+    m["abc"] = 1;
+    assert(m.find(std::string_view("abc")) != m.end());
+    assert(m.find(std::string_view("abd")) == m.end());
+}
+
+int main() {
+    for (unsigned seed = 1; seed <= 3; ++seed) {
+        test_map<64>(seed, 500, 40000);
+        test_map<64>(seed, 20000, 60000);
+        test_map<256>(seed, 20000, 60000);
+        test_multimap<64>(seed, 300, 40000);
+        test_multimap<256>(seed, 300, 40000);
+        test_set<64>(seed);
+        test_set<256>(seed);
+        test_set<4096>(seed);
+        test_erase_returns_next<64>(seed);
+        test_erase_returns_next<128>(seed);
+        test_erase_returns_next<512>(seed);
+    }
+    test_transparent();
+    return 0;
+}
@@ -0,0 +1,82 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "concurrent_hash_cache.h"
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a default constructed hasher trips the assert, so every shard has to get the cache's own
+struct seeded_hash {
+    size_t seed;
+
+    explicit seeded_hash(size_t s = 0) : seed(s) {}
+
+    size_t operator()(int k) const {
+        assert(seed == 42);
+        return (size_t) k * 0x9E3779B1u + seed;
+    }
+};
+
+static void test_hasher_reaches_shards() {
+    concurrent_hash_cache<int, int, tinylfu_eviction, seeded_hash> c(64, 4, seeded_hash(42));
+    for (int i = 0; i < 1000; ++i) {
+        int v;
+        if (!c.get(i % 100, v)) c.put(i % 100, i);
+    }
+    assert(c.size() <= c.capacity() + c.shard_count());
+    assert(c.erase(99) <= 1 && !c.contains(99));
+    assert(c.hash_function().seed == 42);
+}
+
+// gets, puts, erases and contains from several threads; each value is a function of its key
+template<class Cache>
+static void hammer(Cache &c, int threads) {
+    std::atomic<long> evicted(0);
+    c.set_eviction_callback([&evicted](typename Cache::value_type &v) {
+        assert(v.second == std::to_string(v.first));
+        evicted.fetch_add(1, std::memory_order_relaxed);
+    });
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&c, t] {
+            uint64_t x = (uint64_t) t + 1;
+            for (int i = 0; i < 20000; ++i) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                const int k = (int) (x % 3000);
+                std::string v;
+                if (c.get(k, v)) assert(v == std::to_string(k));
+                else c.put(k, std::to_string(k));
+                if (i % 97 == 0) c.erase(k + 1);
+                if (i % 501 == 0) (void) c.contains(k);
+            }
+        });
+    }
+    for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+    // every shard rounds its share of the capacity up
+    assert(c.size() <= c.capacity() + c.shard_count());
+    assert(evicted.load() > 0);
+    c.set_eviction_callback(typename Cache::eviction_callback());
+}
+
+int main() {
+    test_hasher_reaches_shards();
+
+    concurrent_hash_cache<int, std::string> clock(1000, 16);
+    hammer(clock, 8);
+    concurrent_hash_cache<int, std::string, lru_eviction> lru(1000, 16);
+    hammer(lru, 8);
+    concurrent_hash_cache<int, std::string, tinylfu_eviction> lfu(1000, 16);
+    hammer(lfu, 8);
+
+    clock.set_capacity(100);
+    assert(clock.size() <= 100 + clock.shard_count());
+    clock.clear();
+    assert(clock.empty());
+    return 0;
+}
@@ -0,0 +1,85 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "concurrent_hashmap.h"
+#include <cassert>
+#include <thread>
+#include <vector>
+
+// a default constructed functor trips the assert, so every shard has to get the map's own
+struct seeded_hash {
+    size_t seed;
+
+    explicit seeded_hash(size_t s = 0) : seed(s) {}
+
+    size_t operator()(int k) const {
+        assert(seed == 42);
+        return (size_t) k * 31 + seed;
+    }
+};
+
+struct tagged_equal {
+    int tag;
+
+    explicit tagged_equal(int t = 0) : tag(t) {}
+
+    bool operator()(int a, int b) const {
+        assert(tag == 7);
+        return a == b;
+    }
+};
+
+static void test_functors_reach_shards() {
+    concurrent_hash_map<int, int, seeded_hash, tagged_equal> m(8, seeded_hash(42), tagged_equal(7));
+    for (int i = 0; i < 1000; ++i) assert(m.insert(std::pair<const int, int>(i, i)));
+    assert(!m.insert(std::pair<const int, int>(5, 0)));
+    int v = 0;
+    assert(m.find(5, v) && v == 5);
+    assert(m.erase(5) == 1 && !m.contains(5));
+    assert(m.size() == 999);
+    assert(m.hash_function().seed == 42 && m.key_eq().tag == 7);
+}
+
+// every thread inserts its own range and bumps a shared range through upsert, while reading
+static void test_threads() {
+    enum {
+        THREADS = 8, KEYS = 5000
+    };
+    concurrent_hash_map<int, long> m(16);
+    assert(m.shard_count() == 16);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&m, t] {
+            for (int i = 0; i < KEYS; ++i) {
+                m.insert(std::pair<const int, long>(t * KEYS + i, i));
+                m.upsert(i, [](long &v) { ++v; });
+                long seen;
+                m.find(i, seen);
+            }
+        });
+    }
+    for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+
+    size_t n = 0;
+    m.for_each([&n](const std::pair<const int, long> &) { ++n; });
+    assert(n == m.size() && n == THREADS * KEYS);
+    for (int i = 0; i < KEYS; ++i) {
+        // thread 0 inserted i, or an upsert got there first with a default value
+        long v = 0;
+        assert(m.find(i, v) && (v == i + THREADS || v == THREADS));
+    }
+    for (int i = KEYS; i < THREADS * KEYS; ++i) {
+        long v = 0;
+        assert(m.find(i, v) && v == i % KEYS);
+    }
+    assert(m.erase(3) == 1 && !m.contains(3));
+    m.clear();
+    assert(m.empty());
+}
+
+int main() {
+    test_functors_reach_shards();
+    test_threads();
+    return 0;
+}
@@ -0,0 +1,134 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "concurrent_skiplist.h"
+#include <atomic>
+#include <cassert>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one thread against std::map, with a reader checking order and bounds every so often
+static void test_single_thread() {
+    concurrent_map<int, std::string> m;
+    std::map<int, std::string> ref;
+    std::mt19937 rng(50);
+    for (int i = 0; i < 20000; ++i) {
+        const int k = (int) (rng() % 2000);
+        if (rng() % 3) {
+            const std::string v = std::to_string(i);
+            assert(m.insert(std::make_pair(k, v)) == ref.insert(std::make_pair(k, v)).second);
+        } else {
+            assert(m.erase(k) == ref.erase(k));
+        }
+        if (i % 1000 == 0) {
+            concurrent_map<int, std::string>::reader r(m);
+            concurrent_map<int, std::string>::const_iterator it = r.begin();
+            for (std::map<int, std::string>::iterator e = ref.begin(); e != ref.end(); ++e, ++it)
+                assert(it != r.end() && it->first == e->first && it->second == e->second);
+            assert(it == r.end());
+            for (int q = 0; q < 200; ++q) {
+                const int x = (int) (rng() % 2100);
+                concurrent_map<int, std::string>::const_iterator a = r.lower_bound(x);
+                std::map<int, std::string>::iterator b = ref.lower_bound(x);
+                assert((a == r.end()) == (b == ref.end()));
+                if (b != ref.end()) assert(a->first == b->first);
+                a = r.upper_bound(x);
+                b = ref.upper_bound(x);
+                assert((a == r.end()) == (b == ref.end()));
+                if (b != ref.end()) assert(a->first == b->first);
+                assert((r.find(x) != r.end()) == (ref.count(x) == 1));
+            }
+        }
+        std::string v;
+        assert(m.find(k, v) == (ref.count(k) == 1));
+        if (ref.count(k)) assert(v == ref[k]);
+    }
+    assert(m.size() == ref.size());
+    m.clear();
+    assert(m.empty());
+    concurrent_map<int, std::string>::reader r(m);
+    assert(r.begin() == r.end());
+}
+
+// each writer owns the keys equal to its id modulo the writer count and checks its own view
+// of them, while two readers scan and check the order
+static void test_disjoint_writers() {
+    const int writers = 8;
+    const int ops = 10000;
+    concurrent_set<int> s;
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+    for (int id = 0; id < writers; ++id) {
+        threads.emplace_back([&s, id, writers, ops] {
+            std::mt19937 rng(id);
+            std::set<int> mine;
+            for (int i = 0; i < ops; ++i) {
+                const int k = (int) (rng() % 4000) * writers + id;
+                if (rng() % 4) assert(s.insert(k) == mine.insert(k).second);
+                else assert(s.erase(k) == mine.erase(k));
+                if (i % 97 == 0) assert(s.contains(k) == (mine.count(k) == 1));
+            }
+            for (std::set<int>::iterator it = mine.begin(); it != mine.end(); ++it) assert(s.contains(*it));
+        });
+    }
+    for (int id = 0; id < 2; ++id) {
+        threads.emplace_back([&s, &stop] {
+            while (!stop.load()) {
+                concurrent_set<int>::reader r(s);
+                int prev = -1;
+                int n = 0;
+                for (concurrent_set<int>::const_iterator it = r.lower_bound(1000); it != r.end() && n < 5000; ++it, ++n) {
+                    assert(*it > prev && *it >= 1000);
+                    prev = *it;
+                }
+            }
+        });
+    }
+    for (int id = 0; id < writers; ++id) threads[id].join();
+    stop = true;
+    threads[writers].join();
+    threads[writers + 1].join();
+
+    concurrent_set<int>::reader r(s);
+    size_t n = 0;
+    int prev = -1;
+    for (concurrent_set<int>::const_iterator it = r.begin(); it != r.end(); ++it, ++n) {
+        assert(*it > prev);
+        prev = *it;
+    }
+    assert(n == s.size());
+}
+
+// every thread on the same 64 keys; what survives matches the successful inserts less erases
+static void test_contended() {
+    concurrent_map<int, int> m;
+    std::atomic<long> net(0);
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 8; ++id) {
+        threads.emplace_back([&m, &net, id] {
+            std::mt19937 rng(100 + id);
+            for (int i = 0; i < 20000; ++i) {
+                const int k = (int) (rng() % 64);
+                if (rng() & 1) net += m.insert(std::make_pair(k, i));
+                else net -= (long) m.erase(k);
+            }
+        });
+    }
+    for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+    concurrent_map<int, int>::reader r(m);
+    long n = 0;
+    for (concurrent_map<int, int>::const_iterator it = r.begin(); it != r.end(); ++it) ++n;
+    assert(n == net.load() && (size_t) n == m.size());
+}
+
+int main() {
+    test_single_thread();
+    test_disjoint_writers();
+    test_contended();
+    return 0;
+}
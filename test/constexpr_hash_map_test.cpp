@@ -0,0 +1,102 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "constexpr_hashmap.h"
+#include <cassert>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std::string_view_literals;
+
+// both tables are built by the compiler; every check in a static_assert is a compile-time one
+constexpr std::pair<const std::string_view, int> keyword_items[] = {
+        {"if", 1}, {"else", 2}, {"for", 3}, {"while", 4}, {"do", 5}, {"return", 6},
+        {"break", 7}, {"continue", 8}, {"switch", 9}, {"case", 10}, {"default", 11},
+        {"goto", 12}, {"struct", 13}, {"union", 14}, {"enum", 15}, {"typedef", 16}, {"", 17}};
+constexpr auto keywords = make_constexpr_hash_map(keyword_items);
+
+constexpr std::pair<const int, long> square_items[] = {
+        {0, 0}, {1, 1}, {-1, 1}, {2, 4}, {3, 9}, {10, 100}, {-10, 100}, {1000, 1000000},
+        {65536, 4294967296L}, {-2147483647 - 1, 4611686018427387904L}, {2147483647, 4611686014132420609L}};
+constexpr auto squares = make_constexpr_hash_map(square_items);
+
+static_assert(keywords.size() == 17 && squares.size() == 11, "");
+static_assert(keywords.find("while"sv)->second == 4 && keywords.at("typedef"sv) == 16, "");
+static_assert(keywords.at(""sv) == 17 && keywords.contains("goto"sv), "");
+static_assert(keywords.find("whil"sv) == keywords.end() && keywords.count("While"sv) == 0, "");
+static_assert(!keywords.contains("returns"sv) && !keywords.contains(" if"sv), "");
+static_assert(squares.at(-10) == 100 && squares.at(65536) == 4294967296L, "");
+static_assert(squares.at(-2147483647 - 1) == 4611686018427387904L && squares.find(0)->second == 0, "");
+static_assert(squares.find(4) == squares.end() && squares.count(-2) == 0 && !squares.contains(999), "");
+
+// every key finds its own entry, at() throws on a miss
+template<class Map, size_t N>
+static void check_hits(const Map &m, const std::pair<const typename Map::key_type, typename Map::mapped_type> (&items)[N]) {
+    for (size_t i = 0; i < N; ++i) {
+        assert(m.find(items[i].first) == m.begin() + i && m.at(items[i].first) == items[i].second);
+        assert(m.count(items[i].first) == 1);
+    }
+}
+
+static void test_int_misses() {
+    check_hits(squares, square_items);
+    size_t hits = 0;
+    for (int x = -100000; x <= 100000; ++x) hits += squares.count(x);
+    assert(hits == 9);
+    for (long x = 2147483648L - 100000; x < 2147483648L; ++x) hits += squares.count((int) x);
+    assert(hits == 10);
+    bool threw = false;
+    try {
+        squares.at(5);
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// every string of up to three letters from a small alphabet, and every keyword with one letter
+// changed, missing or added; only the keywords themselves are found
+static void test_string_misses() {
+    check_hits(keywords, keyword_items);
+    std::set<std::string_view> ref;
+    for (const auto &item : keyword_items) ref.insert(item.first);
+    const char alphabet[] = "abcdefghiorstuw";
+    std::string s;
+    for (size_t a = 0; a < sizeof alphabet; ++a)
+        for (size_t b = 0; b < sizeof alphabet; ++b)
+            for (size_t c = 0; c < sizeof alphabet; ++c) {
+                s.clear();
+                for (char ch : {alphabet[a], alphabet[b], alphabet[c]})
+                    if (ch) s += ch;
+                assert(keywords.contains(s) == (ref.count(s) == 1));
+            }
+    for (const auto &item : keyword_items) {
+        const std::string k(item.first);
+        for (size_t i = 0; i < k.size(); ++i) {
+            std::string t = k;
+            t[i] ^= 0x20;
+            assert(!keywords.contains(t));
+            t = k;
+            t.erase(i, 1);
+            assert(keywords.contains(t) == (ref.count(t) == 1));
+        }
+        assert(!keywords.contains(k + "_"));
+        assert(!keywords.contains("_" + k));
+    }
+    bool threw = false;
+    try {
+        keywords.at("then"sv);
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main() {
+    test_int_misses();
+    test_string_misses();
+    return 0;
+}
@@ -0,0 +1,39 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hashmap.h"
+#include "hashset.h"
+#include <cassert>
+#include <random>
+#include <vector>
+
+int main() {
+    // more keys than one batch, with hits and misses mixed
+    const long N = 20000;
+    hash_map<long, long> m;
+    for (long i = 0; i < N; ++i) m[i * 3] = i;
+    std::vector<long> keys;
+    std::mt19937_64 rng(1);
+    for (long i = 0; i < N; ++i) keys.push_back((long) (rng() % (3 * (unsigned long) N)));
+
+    std::vector<hash_map<long, long>::iterator> found(keys.size());
+    m.find_batch(keys.begin(), keys.end(), found.begin());
+    for (size_t i = 0; i < keys.size(); ++i) assert(found[i] == m.find(keys[i]));
+
+    const hash_map<long, long> &cm = m;
+    std::vector<hash_map<long, long>::const_iterator> cfound(keys.size());
+    cm.find_batch(keys.begin(), keys.end(), cfound.begin());
+    for (size_t i = 0; i < keys.size(); ++i) assert(cfound[i] == cm.find(keys[i]));
+
+    hash_set<int> s;
+    for (int i = 0; i < 100; ++i) s.insert(i);
+    int ks[] = {1, 500, 99};
+    hash_set<int>::iterator sr[3];
+    assert(s.find_batch(ks, ks + 3, sr) == sr + 3);
+    assert(*sr[0] == 1 && sr[1] == s.end() && *sr[2] == 99);
+
+    // an empty range writes nothing
+    assert(s.find_batch(ks, ks, sr) == sr);
+    return 0;
+}
@@ -0,0 +1,173 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "flat_map.h"
+#include "flat_set.h"
+#include <cassert>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// a key type at global scope, where std::sort finds swap by both lookups
+struct plain_key {
+    int k;
+
+    bool operator<(const plain_key &x) const { return k < x.k; }
+
+    bool operator==(const plain_key &x) const { return k == x.k; }
+};
+
+// random batches, single and hinted inserts, erases, operator[] and range erases, checked
+// against std::map and std::set after every step
+static void test_against_std() {
+    std::mt19937 rng(48);
+    flat_map<int, std::string> fm;
+    std::map<int, std::string> rm;
+    flat_set<int> fs;
+    std::set<int> rs;
+    for (int round = 0; round < 200; ++round) {
+        const unsigned op = rng() % 6;
+        const int k = (int) (rng() % 5000);
+        if (op == 0) {
+            std::vector<std::pair<int, std::string> > batch;
+            std::vector<int> keys;
+            const unsigned m = rng() % 200;
+            for (unsigned j = 0; j < m; ++j) {
+                const int key = (int) (rng() % 5000);
+                batch.push_back(std::make_pair(key, std::to_string(rng())));
+                keys.push_back(key);
+            }
+            fm.insert(batch.begin(), batch.end());
+            rm.insert(batch.begin(), batch.end());
+            fs.insert(keys.begin(), keys.end());
+            rs.insert(keys.begin(), keys.end());
+        } else if (op == 1) {
+            const std::string v = std::to_string(k);
+            std::pair<flat_map<int, std::string>::iterator, bool> a = fm.insert(std::pair<const int, std::string>(k, v));
+            std::pair<std::map<int, std::string>::iterator, bool> b = rm.insert(std::make_pair(k, v));
+            assert(a.second == b.second && a.first->first == k && a.first->second == b.first->second);
+            std::pair<flat_set<int>::iterator, bool> c = fs.insert(k);
+            assert(c.second == rs.insert(k).second && *c.first == k);
+        } else if (op == 2) {
+            assert(fm.erase(k) == rm.erase(k));
+            assert(fs.erase(k) == rs.erase(k));
+        } else if (op == 3) {
+            fm[k] += "x";
+            rm[k] += "x";
+        } else if (op == 4) {
+            flat_map<int, std::string>::iterator a = fm.lower_bound(k), b = fm.upper_bound(k + 100);
+            std::map<int, std::string>::iterator c = rm.lower_bound(k), d = rm.upper_bound(k + 100);
+            assert(b - a == (long) std::distance(c, d));
+            fm.erase(a, b);
+            rm.erase(c, d);
+            fs.erase(fs.lower_bound(k), fs.upper_bound(k + 100));
+            rs.erase(rs.lower_bound(k), rs.upper_bound(k + 100));
+        } else {
+            flat_map<int, std::string>::iterator it = fm.insert(fm.lower_bound(k), std::pair<const int, std::string>(k, "h"));
+            rm.insert(std::make_pair(k, std::string("h")));
+            assert(it->first == k && it->second == rm[k]);
+            fs.insert(fs.lower_bound(k + 1), k);
+            rs.insert(k);
+        }
+
+        assert(fm.size() == rm.size() && fs.size() == rs.size());
+        flat_map<int, std::string>::iterator it = fm.begin();
+        for (std::map<int, std::string>::iterator e = rm.begin(); e != rm.end(); ++e, ++it)
+            assert(it->first == e->first && (*it).second == e->second);
+        assert(it == fm.end());
+        assert(std::equal(fs.begin(), fs.end(), rs.begin()));
+
+        const flat_map<int, std::string> &cf = fm;
+        for (int q = 0; q < 50; ++q) {
+            const int key = (int) (rng() % 5000);
+            flat_map<int, std::string>::const_iterator f = cf.find(key);
+            std::map<int, std::string>::iterator g = rm.find(key);
+            assert((f == cf.end()) == (g == rm.end()));
+            if (g != rm.end()) assert(f->second == g->second);
+            assert(cf.count(key) == rm.count(key) && fs.count(key) == rs.count(key));
+            std::pair<flat_map<int, std::string>::iterator, flat_map<int, std::string>::iterator> er = fm.equal_range(key);
+            assert(er.second - er.first == (long) rm.count(key));
+        }
+    }
+}
+
+// the first of repeated keys in a batch wins, and keys already present win over the batch
+static void test_batch_precedence() {
+    flat_map<int, int> a;
+    std::pair<int, int> in[] = {{3, 1}, {1, 1}, {3, 2}, {2, 1}, {1, 2}};
+    a.insert(in, in + 5);
+    assert(a.size() == 3 && a[3] == 1 && a[1] == 1);
+    std::pair<int, int> more[] = {{3, 9}, {0, 9}};
+    a.insert(more, more + 2);
+    assert(a.size() == 4 && a[3] == 1 && a[0] == 9);
+
+    flat_map<int, int, std::greater<int> > g(in, in + 5);
+    assert(g.begin()->first == 3);
+
+    flat_set<std::string> s;
+    const char *words[] = {"b", "a", "c", "a"};
+    s.insert(words, words + 4);
+    assert(s.size() == 3 && *s.begin() == "a");
+}
+
+// random access iterators that write the value array, copies, comparison and swap
+static void test_iterators_and_copies() {
+    flat_map<int, int> a;
+    for (int i = 0; i < 4; ++i) a[i] = i;
+    flat_map<int, int>::iterator i = a.begin();
+    i += 2;
+    assert(i->first == 2);
+    i->second = 7;
+    assert(a[2] == 7);
+    assert((a.end() - 1)->first == 3 && a.begin()[1].first == 1);
+    flat_map<int, int>::const_iterator ci = i;
+    assert(ci == i && !(ci < i) && ci - a.begin() == 2);
+
+    flat_map<int, int> b(a);
+    assert(b == a);
+    b[10] = 1;
+    assert(b != a);
+    b.swap(a);
+    assert(a.size() == 5 && b.size() == 4);
+    assert(a.keys().size() == 5 && a.values()[4] == 1);
+
+    flat_set<int> x, y;
+    x.insert(1);
+    y.swap(x);
+    assert(x.empty() && y.count(1) == 1);
+}
+
+static void test_global_key_type() {
+    std::vector<std::pair<plain_key, int> > v;
+    std::vector<plain_key> keys;
+    for (int i = 0; i < 1000; ++i) {
+        v.push_back(std::make_pair(plain_key{(i * 37) % 500}, i));
+        keys.push_back(plain_key{(i * 11) % 300});
+    }
+    flat_map<plain_key, int> m(v.begin(), v.end());
+    assert(m.size() == 500 && m.find(plain_key{0})->second == 0 && m.find(plain_key{37})->second == 1);
+    flat_set<plain_key> s(keys.begin(), keys.end());
+    assert(s.size() == 300);
+}
+
+// the comparator forms of the algorithm_base searches
+static void test_searches_with_comparator() {
+    int a[] = {9, 7, 5, 3};
+    assert(::lower_bound(a, a + 4, 6, std::greater<int>()) - a == 2);
+    assert(::upper_bound(a, a + 4, 7, std::greater<int>()) - a == 2);
+    assert(::binary_search(a, a + 4, 5, std::greater<int>()));
+    assert(!::binary_search(a, a + 4, 4, std::greater<int>()));
+}
+
+int main() {
+    test_against_std();
+    test_batch_precedence();
+    test_iterators_and_copies();
+    test_global_key_type();
+    test_searches_with_comparator();
+    return 0;
+}
@@ -0,0 +1,104 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hash_cache.h"
+#include <cassert>
+#include <string>
+#include <vector>
+
+// every key in one chain, so erasing an entry keeps comparing keys after it is gone
+struct constant_hash {
+    size_t operator()(const std::string &) const { return 3; }
+};
+
+static void test_lru() {
+    hash_cache<int, std::string> c(3);
+    std::vector<int> evicted;
+    c.set_eviction_callback([&evicted](std::pair<const int, std::string> &v) { evicted.push_back(v.first); });
+    c.put(1, "a");
+    c.put(2, "b");
+    c.put(3, "c");
+    assert(*c.get(1) == "a");
+    c.put(4, "d");
+    assert(evicted.size() == 1 && evicted[0] == 2 && !c.contains(2) && c.size() == 3);
+    c.put(3, "cc");
+    assert(evicted.size() == 1 && *c.peek(3) == "cc");
+    c.put(5, "e");
+    assert(evicted.size() == 2 && evicted[1] == 1);
+    assert(c.erase(4) == 1 && c.erase(4) == 0 && c.size() == 2);
+    c.set_capacity(1);
+    assert(c.size() == 1 && evicted.back() == 3 && c.contains(5));
+    c.clear();
+    assert(c.empty() && c.get(5) == nullptr);
+    c.set_capacity(2);
+    c.put(7, std::string("x"));
+    assert(*c.get(7) == "x");
+
+    hash_cache<int, int> none(0);
+    assert(!none.put(1, 1) && none.size() == 0);
+}
+
+static void test_clock() {
+    hash_cache<int, int, clock_eviction> c(3);
+    c.put(1, 1);
+    c.put(2, 2);
+    c.put(3, 3);
+    c.get(1);
+    c.get(2);
+    // 1 and 2 get a second chance, 3 goes
+    c.put(4, 4);
+    assert(!c.contains(3) && c.contains(1) && c.contains(2) && c.contains(4));
+    c.put(5, 5);
+    assert(c.size() == 3 && c.contains(5));
+    for (int i = 0; i < 10000; ++i) {
+        c.put(i % 17, i);
+        if (i % 3 == 0) c.get(i % 5);
+        assert(c.size() <= 3);
+    }
+}
+
+// a scan of one-off keys must not flush the hot set out of a tinylfu cache, as it does with lru
+static void test_tinylfu() {
+    hash_cache<int, int, tinylfu_eviction> t(100);
+    hash_cache<int, int> l(100);
+    for (int round = 0; round < 20; ++round) {
+        for (int k = 0; k < 80; ++k) {
+            if (!t.get(k)) t.put(k, k);
+            if (!l.get(k)) l.put(k, k);
+        }
+    }
+    for (int k = 1000; k < 1500; ++k) {
+        if (!t.get(k)) t.put(k, k);
+        if (!l.get(k)) l.put(k, k);
+    }
+    int tinylfu_hot = 0, lru_hot = 0;
+    for (int k = 0; k < 80; ++k) {
+        tinylfu_hot += t.contains(k);
+        lru_hot += l.contains(k);
+    }
+    assert(tinylfu_hot > 70 && lru_hot == 0 && t.size() <= 100);
+}
+
+static void test_heap_keys() {
+    hash_cache<std::string, std::vector<int>, lru_eviction, constant_hash> c(8);
+    size_t evictions = 0;
+    c.set_eviction_callback([&evictions](std::pair<const std::string, std::vector<int> > &) { ++evictions; });
+    for (int i = 0; i < 1000; ++i) {
+        std::string k = std::string(32, 'k') + std::to_string(i % 30);
+        if (std::vector<int> *v = c.get(k)) v->push_back(i);
+        else c.put(k, std::vector<int>(3, i));
+        assert(c.size() <= 8);
+    }
+    assert(c.size() == 8 && evictions > 0);
+    c.set_capacity(2);
+    assert(c.size() == 2);
+}
+
+int main() {
+    test_lru();
+    test_clock();
+    test_tinylfu();
+    test_heap_keys();
+    return 0;
+}
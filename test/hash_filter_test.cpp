@@ -0,0 +1,187 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hash_filter.h"
+#include "hashmap.h"
+#include "hashset.h"
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+// keys below 2^40 are inserted, the misses are drawn above it
+static std::vector<long> draw(size_t n, unsigned seed, long base) {
+    std::mt19937_64 rng(seed);
+    std::set<long> seen;
+    std::vector<long> keys;
+    while (keys.size() < n) {
+        const long k = base + (long) (rng() >> 24);
+        if (seen.insert(k).second) keys.push_back(k);
+    }
+    return keys;
+}
+
+template<class Filter>
+static double false_positive_rate(const Filter &f, const std::vector<long> &misses) {
+    size_t yes = 0;
+    for (size_t i = 0; i < misses.size(); ++i) yes += f.may_contain(misses[i]);
+    return (double) yes / (double) misses.size();
+}
+
+// every inserted key gets a yes, and the misses get one rarely, for filters at capacity
+template<class Filter>
+static void test_no_false_negatives(const char *name, double max_rate) {
+    const std::vector<long> keys = draw(20000, 1, 0);
+    const std::vector<long> misses = draw(200000, 2, 1L << 40);
+    Filter f(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) assert(f.insert(keys[i]));
+    assert(f.size() == keys.size() && f.capacity() == keys.size() && f.bytes() > 0);
+    for (size_t i = 0; i < keys.size(); ++i) assert(f.may_contain(keys[i]));
+    const double rate = false_positive_rate(f, misses);
+    std::printf("%s: %.4f%% false positives\n", name, rate * 100);
+    assert(rate < max_rate);
+
+    Filter copy(f);
+    for (size_t i = 0; i < keys.size(); ++i) assert(copy.may_contain(keys[i]));
+    f.clear();
+    assert(f.size() == 0 && false_positive_rate(f, keys) == 0);
+    f.swap(copy);
+    assert(f.size() == keys.size() && copy.size() == 0 && f.may_contain(keys[0]));
+}
+
+// a bloom filter cannot forget a key, so erase() keeps every yes
+static void test_bloom_erase() {
+    const std::vector<long> keys = draw(1000, 3, 0);
+    blocked_bloom_filter<long> f(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) f.insert(keys[i]);
+    for (size_t i = 0; i < keys.size(); i += 2) f.erase(keys[i]);
+    for (size_t i = 0; i < keys.size(); ++i) assert(f.may_contain(keys[i]));
+}
+
+// a cuckoo filter drops an erased key's fingerprint and keeps every other key
+static void test_cuckoo_erase() {
+    const std::vector<long> keys = draw(20000, 4, 0);
+    cuckoo_filter<long> f(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) f.insert(keys[i]);
+    std::vector<long> erased;
+    for (size_t i = 0; i < keys.size(); i += 2) {
+        f.erase(keys[i]);
+        erased.push_back(keys[i]);
+    }
+    assert(f.size() == keys.size() / 2);
+    for (size_t i = 1; i < keys.size(); i += 2) assert(f.may_contain(keys[i]));
+    assert(false_positive_rate(f, erased) < 0.001);
+    // the freed slots take new keys
+    const std::vector<long> more = draw(10000, 5, 1L << 41);
+    for (size_t i = 0; i < more.size(); ++i) assert(f.insert(more[i]));
+    for (size_t i = 0; i < more.size(); ++i) assert(f.may_contain(more[i]));
+    for (size_t i = 1; i < keys.size(); i += 2) assert(f.may_contain(keys[i]));
+}
+
+// past its capacity a cuckoo filter refuses an insert, and every key it took before, the last
+// one included, is still a yes
+static void test_cuckoo_full() {
+    const std::vector<long> keys = draw(4000, 6, 0);
+    cuckoo_filter<long> f(1000);
+    size_t n = 0;
+    while (n < keys.size() && f.insert(keys[n])) ++n;
+    assert(n >= 1000 && n < keys.size());
+    for (size_t i = 0; i < n; ++i) assert(f.may_contain(keys[i]));
+    assert(!f.insert(keys[n]));
+}
+
+// find, count, erase and insert through the filter against a std::map kept alongside; the
+// filter starts at 64 keys, so the table outgrows it several times and it is rebuilt each time
+template<class Container, class Ref>
+static void check_same(const Container &c, const Ref &ref, const std::vector<long> &misses) {
+    assert(c.size() == ref.size() && c.filter().capacity() >= c.size());
+    for (typename Ref::const_iterator it = ref.begin(); it != ref.end(); ++it) {
+        assert(c.may_contain(*it) && c.count(*it) == 1 && c.find(*it) != c.end());
+    }
+    for (size_t i = 0; i < misses.size(); ++i)
+        assert(c.count(misses[i]) == 0 && c.find(misses[i]) == c.end());
+}
+
+template<class Filter>
+static void test_filtered_set() {
+    typedef filtered_hash_container<hash_set<long>, Filter> Set;
+    const std::vector<long> keys = draw(20000, 7, 0);
+    const std::vector<long> misses = draw(20000, 8, 1L << 40);
+    Set s;
+    std::set<long> ref;
+    const size_t initial = s.filter().capacity();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        assert(s.insert(keys[i]).second);
+        ref.insert(keys[i]);
+        assert(!s.insert(keys[i]).second);
+    }
+    assert(s.filter().capacity() > initial);
+    check_same(s, ref, misses);
+
+    for (size_t i = 0; i < keys.size(); i += 3) {
+        assert(s.erase(keys[i]) == 1 && s.erase(keys[i]) == 0);
+        ref.erase(keys[i]);
+    }
+    for (size_t i = 0; i < misses.size(); i += 7) assert(s.erase(misses[i]) == 0);
+    for (size_t i = 1; i < keys.size(); i += 3) {
+        s.erase(s.find(keys[i]));
+        ref.erase(keys[i]);
+    }
+    check_same(s, ref, misses);
+    for (size_t i = 0; i < keys.size(); i += 3) assert(s.count(keys[i]) == 0);
+
+    // erased keys come back
+    for (size_t i = 0; i < keys.size(); i += 3) {
+        assert(s.insert(keys[i]).second);
+        ref.insert(keys[i]);
+    }
+    check_same(s, ref, misses);
+    s.clear();
+    assert(s.empty() && s.count(keys[2]) == 0);
+}
+
+template<class Filter>
+static void test_filtered_map() {
+    typedef filtered_hash_container<hash_map<long, long>, Filter> Map;
+    const std::vector<long> keys = draw(10000, 9, 0);
+    const std::vector<long> misses = draw(10000, 10, 1L << 40);
+    Map m;
+    std::map<long, long> ref;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i % 2) m[keys[i]] = (long) i;
+        else m.insert(std::make_pair(keys[i], (long) i));
+        ref[keys[i]] = (long) i;
+    }
+    assert(m.size() == ref.size());
+    for (std::map<long, long>::iterator it = ref.begin(); it != ref.end(); ++it) {
+        assert(m.find(it->first)->second == it->second && m.count(it->first) == 1);
+        // operator[] on a present key does not grow the filter
+        const size_t before = m.filter().size();
+        m[it->first] += 1;
+        assert(m.filter().size() == before && m.find(it->first)->second == it->second + 1);
+    }
+    for (size_t i = 0; i < misses.size(); ++i) assert(m.find(misses[i]) == m.end() && m.count(misses[i]) == 0);
+    for (size_t i = 0; i < keys.size(); i += 2) assert(m.erase(keys[i]) == 1);
+    for (size_t i = 0; i < keys.size(); ++i) assert(m.count(keys[i]) == i % 2);
+    assert(m.size() == keys.size() / 2);
+}
+
+int main() {
+#ifdef __AVX2__
+    // the -mavx2 build of this test has nothing to check on a machine without the instructions
+    if (!__builtin_cpu_supports("avx2")) return 0;
+#endif
+    test_no_false_negatives<blocked_bloom_filter<long> >("blocked_bloom_filter", 0.01);
+    test_no_false_negatives<cuckoo_filter<long> >("cuckoo_filter", 0.001);
+    test_bloom_erase();
+    test_cuckoo_erase();
+    test_cuckoo_full();
+    test_filtered_set<blocked_bloom_filter<long> >();
+    test_filtered_set<cuckoo_filter<long> >();
+    test_filtered_map<blocked_bloom_filter<long> >();
+    test_filtered_map<cuckoo_filter<long> >();
+    return 0;
+}
@@ -0,0 +1,132 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hash_fun.h"
+#include <cassert>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+static std::vector<unsigned char> random_bytes(size_t n) {
+    std::mt19937 rng(32);
+    std::vector<unsigned char> bytes(n);
+    for (size_t i = 0; i < n; ++i) bytes[i] = (unsigned char) rng();
+    return bytes;
+}
+
+// the codes of every length from first to last, at two alignments and two seeds, folded into one
+static uint64_t digest(const std::vector<unsigned char> &bytes, size_t first, size_t last) {
+    uint64_t d = 0;
+    for (size_t len = first; len <= last; ++len) {
+        d = hash_combine(d, hash_bytes(bytes.data(), len));
+        d = hash_combine(d, hash_bytes(bytes.data() + 1, len, len));
+    }
+    return d;
+}
+
+// a code never depends on how the library was compiled: this test is built with and without
+// -mavx2 and both builds must see the same codes, the ones pinned here
+static void test_byte_codes() {
+    const std::vector<unsigned char> bytes = random_bytes(4096);
+    assert(digest(bytes, 0, 256) == 0x323aa4e601c9d5dbull);
+    // lengths of __stl_hash_long and more take the stripe loop, vector or scalar
+    assert(digest(bytes, 257, 4000) == 0x5ebaef99d649f512ull);
+}
+
+#ifdef __AVX2__
+
+// the vector stripe and scramble steps against the scalar ones, on random lanes
+static void test_avx2_steps() {
+    const std::vector<unsigned char> bytes = random_bytes(4096);
+    std::mt19937_64 rng(33);
+    for (int round = 0; round < 1000; ++round) {
+        uint64_t scalar[8];
+        for (int i = 0; i < 8; ++i) scalar[i] = rng();
+        __m256i vec[2] = {_mm256_loadu_si256((const __m256i *) scalar), _mm256_loadu_si256((const __m256i *) (scalar + 4))};
+        const unsigned char *p = bytes.data() + rng() % (bytes.size() - __stl_hash_stripe);
+        const uint64_t *key = __stl_hash_secret + rng() % 17;
+        __hash_accumulate_scalar(scalar, p, key);
+        __hash_accumulate_avx2(vec, p, key);
+        if (round % 2) {
+            __hash_scramble_scalar(scalar, __stl_hash_secret + 16);
+            __hash_scramble_avx2(vec, __stl_hash_secret + 16);
+        }
+        uint64_t out[8];
+        _mm256_storeu_si256((__m256i *) out, vec[0]);
+        _mm256_storeu_si256((__m256i *) (out + 4), vec[1]);
+        assert(memcmp(out, scalar, sizeof out) == 0);
+    }
+}
+
+#endif
+
+// a string, its view, its characters and a C string of them all hash alike, short and long
+static void test_strings() {
+    const std::vector<unsigned char> bytes = random_bytes(2000);
+    for (size_t len = 0; len < bytes.size(); len += len < 600 ? 1 : 37) {
+        const std::string s((const char *) bytes.data(), len);
+        const std::string_view v(s);
+        const size_t code = hash<std::string>()(s);
+        assert(code == hash<std::string_view>()(v));
+        assert(code == hash<std::string>()(v));
+        assert(code == hash_bytes(s.data(), s.size()));
+    }
+    const std::string word = "transparent";
+    assert(hash<std::string>()(word) == hash<std::string>()("transparent"));
+    assert(hash<std::string>()(word) == hash<const char *>()("transparent"));
+    const std::u16string wide = u"wide";
+    assert(hash<std::u16string>()(wide) == hash<std::u16string_view>()(std::u16string_view(wide)));
+    assert(hash<std::string>()("ab") != hash<std::string>()("ba"));
+
+    // the constant-expression path gives the run-time code
+    constexpr size_t at_compile_time = hash<std::string_view>()("constexpr");
+    assert(at_compile_time == hash<std::string>()(std::string("constexpr")));
+}
+
+// the two zeros compare equal, so they hash equal; other values keep their own codes
+static void test_signed_zero() {
+    assert(hash<double>()(0.0) == hash<double>()(-0.0));
+    assert(hash<float>()(0.0f) == hash<float>()(-0.0f));
+    assert(hash<double>()(1.0) != hash<double>()(-1.0));
+    assert(hash<double>()(0.0) != hash<double>()(5e-324));
+    assert(hash<float>()(1.5f) != hash<float>()(-1.5f));
+}
+
+// a pair or tuple hashes its elements in order, so swapping two of them changes the code
+static void test_combinators() {
+    const hash<std::pair<int, int> > hp;
+    for (int a = 0; a < 50; ++a)
+        for (int b = 0; b < 50; ++b)
+            if (a != b) assert(hp(std::make_pair(a, b)) != hp(std::make_pair(b, a)));
+    assert(hp(std::make_pair(3, 4)) == hp(std::make_pair(3, 4)));
+    assert((hash<std::pair<const std::string, long> >()(std::make_pair(std::string("k"), 7L))
+            == hash<std::pair<std::string, long> >()(std::make_pair(std::string("k"), 7L))));
+
+    const hash<std::tuple<int, int, int> > ht;
+    assert(ht(std::make_tuple(1, 2, 3)) != ht(std::make_tuple(3, 2, 1)));
+    assert(ht(std::make_tuple(1, 2, 3)) != ht(std::make_tuple(1, 3, 2)));
+    assert(ht(std::make_tuple(1, 2, 3)) != ht(std::make_tuple(2, 1, 3)));
+    assert(ht(std::make_tuple(0, 0, 0)) != ht(std::make_tuple(0, 0, 1)));
+    // the element count is the seed, so trailing zeros are not lost
+    assert((hash<std::tuple<int> >()(std::make_tuple(0)) != hash<std::tuple<int, int> >()(std::make_tuple(0, 0))));
+    assert(hash<std::tuple<> >()(std::tuple<>()) != hash<std::tuple<int> >()(std::make_tuple(0)));
+    assert(hash_combine(hash_combine(1, 2), 3) != hash_combine(hash_combine(1, 3), 2));
+}
+
+int main() {
+#ifdef __AVX2__
+    // the -mavx2 build of this test has nothing to check on a machine without the instructions
+    if (!__builtin_cpu_supports("avx2")) return 0;
+    test_avx2_steps();
+#endif
+    test_byte_codes();
+    test_strings();
+    test_signed_zero();
+    test_combinators();
+    return 0;
+}
@@ -0,0 +1,12 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hash_snapshot.h"
+#include <string>
+
+// must not compile: a std::string holds a pointer, so its bytes mean nothing in another process
+int main() {
+    hash_map_image<int, std::string> img;
+    return img.is_open();
+}
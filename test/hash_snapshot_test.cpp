@@ -0,0 +1,146 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hash_snapshot.h"
+#include "hashmap.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static const char *const image_path = "hash_snapshot_test.img";
+
+// a hasher that disagrees with hash<int>, as a reader built with a different hasher would
+struct shifted_hash {
+    size_t operator()(int x) const { return (size_t) x * 31 + 7; }
+};
+
+static std::vector<char> read_file(const char *path) {
+    std::vector<char> bytes;
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, f)) > 0) bytes.insert(bytes.end(), buf, buf + n);
+    fclose(f);
+    return bytes;
+}
+
+static void write_file(const char *path, const char *data, size_t n) {
+    FILE *f = fopen(path, "wb");
+    assert(f && fwrite(data, 1, n, f) == n);
+    fclose(f);
+}
+
+// every key is found with its value, misses are not, and the image holds exactly the map
+static void test_map_round_trip() {
+    hash_map<int, double> m;
+    for (int i = 0; i < 10000; ++i) m[i * 3] = i * 0.5;
+    assert((hash_map_image<int, double>::write(image_path, m)));
+
+    hash_map_image<int, double> img;
+    assert(!img.is_open() && img.find(3) == img.end());
+    assert(img.open(image_path));
+    assert(img.is_open() && img.size() == m.size() && img.bucket_count() >= m.size());
+    for (int i = 0; i < 10000; ++i) {
+        hash_map_image<int, double>::const_iterator it = img.find(i * 3);
+        assert(it != img.end() && it->first == i * 3 && it->second == i * 0.5);
+        assert(img.count(i * 3) == 1);
+        assert(img.find(i * 3 + 1) == img.end() && img.count(i * 3 + 2) == 0);
+    }
+    size_t n = 0;
+    for (hash_map_image<int, double>::const_iterator it = img.begin(); it != img.end(); ++it, ++n)
+        assert(m.find(it->first)->second == it->second);
+    assert(n == m.size());
+    img.close();
+    assert(!img.is_open() && img.size() == 0);
+}
+
+static void test_set_and_empty() {
+    hash_set<long> s;
+    for (long i = 0; i < 500; ++i) s.insert(i * i);
+    assert((hash_set_image<long>::write(image_path, s)));
+    hash_set_image<long> img;
+    assert(img.open(image_path) && img.size() == 500);
+    for (long i = 0; i < 500; ++i) assert(img.count(i * i) == 1);
+    assert(img.count(2) == 0 && img.count(-1) == 0);
+    img.close();
+
+    hash_set<long> none;
+    assert((hash_set_image<long>::write(image_path, none)));
+    assert(img.open(image_path) && img.empty() && img.begin() == img.end() && img.count(0) == 0);
+}
+
+// attach() reads an image already in memory, here a copy of the file aligned for the values
+static void test_attach() {
+    hash_map<int, int> m;
+    for (int i = 0; i < 100; ++i) m[i] = -i;
+    assert((hash_map_image<int, int>::write(image_path, m)));
+    std::vector<char> bytes = read_file(image_path);
+    std::vector<uint64_t> aligned((bytes.size() + 7) / 8);
+    memcpy(aligned.data(), bytes.data(), bytes.size());
+
+    hash_map_image<int, int> img;
+    assert(img.attach(aligned.data(), bytes.size()));
+    assert(img.size() == 100 && img.find(42)->second == -42 && img.find(100) == img.end());
+    // one byte short of the values is refused
+    assert(!img.attach(aligned.data(), bytes.size() - 1) && !img.is_open());
+}
+
+// a missing, truncated or corrupt file, another value type or another hasher is refused
+static void test_refused() {
+    hash_map_image<int, int> img;
+    assert(!img.open("hash_snapshot_test.missing"));
+
+    hash_map<int, int> m;
+    for (int i = 0; i < 1000; ++i) m[i] = i;
+    assert((hash_map_image<int, int>::write(image_path, m)));
+    const std::vector<char> good = read_file(image_path);
+    assert(img.open(image_path));
+    img.close();
+
+    const size_t cuts[] = {0, 1, sizeof(hashtable_image_header) - 1, sizeof(hashtable_image_header),
+                           good.size() / 2, good.size() - 1};
+    for (size_t cut : cuts) {
+        write_file(image_path, good.data(), cut);
+        assert(!img.open(image_path) && !img.is_open());
+    }
+
+    std::vector<char> bad(good);
+    bad[0] ^= 1;
+    write_file(image_path, bad.data(), bad.size());
+    assert(!img.open(image_path));
+
+    // the last bucket offset no longer matches the element count
+    bad = good;
+    hashtable_image_header header;
+    memcpy(&header, good.data(), sizeof header);
+    uint64_t wrong = header.element_count + 1;
+    memcpy(&bad[sizeof header + header.bucket_count * sizeof(uint64_t)], &wrong, sizeof wrong);
+    write_file(image_path, bad.data(), bad.size());
+    assert(!img.open(image_path));
+
+    bad = good;
+    header.version += 1;
+    memcpy(bad.data(), &header, sizeof header);
+    write_file(image_path, bad.data(), bad.size());
+    assert(!img.open(image_path));
+
+    write_file(image_path, good.data(), good.size());
+    assert(img.open(image_path));
+    img.close();
+    hash_map_image<int, double> other_value;
+    assert(!other_value.open(image_path));
+    hash_map_image<int, int, shifted_hash> other_hash;
+    assert(!other_hash.open(image_path));
+}
+
+int main() {
+    test_map_round_trip();
+    test_set_and_empty();
+    test_attach();
+    test_refused();
+    std::remove(image_path);
+    return 0;
+}
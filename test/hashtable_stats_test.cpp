@@ -0,0 +1,48 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#define __STL_HASHTABLE_STATS
+
+#include "hashmap.h"
+#include "hashset.h"
+#include <cassert>
+
+struct constant_hash {
+    size_t operator()(int) const { return 7; }
+};
+
+static size_t histogram_total(const hashtable_stats &s) {
+    size_t total = 0;
+    for (int i = 0; i < hashtable_stats::HISTOGRAM_SIZE; ++i) total += s.chain_lengths[i];
+    return total;
+}
+
+int main() {
+    hash_map<int, int> m;
+    for (int i = 0; i < 1000; ++i) m[i] = i;
+    m.reset_lookup_stats();
+    for (int i = 0; i < 2000; ++i) m.find(i);
+
+    hashtable_stats s = m.stats();
+    assert(s.elements == 1000 && s.buckets >= s.elements);
+    assert(histogram_total(s) == s.buckets);
+    assert(s.empty_buckets <= s.buckets && s.max_chain >= 1);
+    assert(s.expected_probes >= 1.0 && s.bytes_per_element() > 0);
+    assert(s.lookups == 2000 && s.average_probes() > 0);
+
+    // every key in one bucket: one chain of 100, counted in the last histogram slot
+    hash_set<int, constant_hash> b;
+    for (int i = 0; i < 100; ++i) b.insert(i);
+    hashtable_stats t = b.stats();
+    assert(t.max_chain == 100);
+    assert(t.chain_lengths[hashtable_stats::HISTOGRAM_SIZE - 1] == 1);
+    assert(t.empty_buckets == t.buckets - 1);
+    assert(t.expected_probes == 50.5);
+
+    m.reset_lookup_stats();
+    assert(m.stats().lookups == 0 && m.stats().probes == 0);
+    m.clear();
+    assert(m.stats().elements == 0 && m.stats().expected_probes == 0);
+    return 0;
+}
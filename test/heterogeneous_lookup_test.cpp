@@ -0,0 +1,92 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hashmap.h"
+#include "hashset.h"
+#include "map.h"
+#include "set.h"
+#include <cassert>
+#include <string>
+#include <string_view>
+
+struct string_hash {
+    typedef void is_transparent;
+
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+
+struct string_equal {
+    typedef void is_transparent;
+
+    bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+};
+
+static void test_hash_map() {
+    hash_map<std::string, int, string_hash, string_equal> h;
+    h["a"] = 1;
+    h["bb"] = 2;
+    const char *k = "bb";
+    assert(h.find(k) != h.end() && h.find(k)->second == 2);
+    assert(h.find(std::string_view("zz")) == h.end());
+    assert(h.count(std::string_view("a")) == 1);
+    assert(h.equal_range(k).first->second == 2);
+    const hash_map<std::string, int, string_hash, string_equal> &ch = h;
+    assert(ch.find(std::string_view("a"))->second == 1);
+    assert(h.erase(std::string_view("a")) == 1 && h.size() == 1);
+
+    // without a transparent hasher the key is converted as before
+    hash_map<std::string, int> plain;
+    plain["x"] = 1;
+    assert(plain.find("x") != plain.end() && plain.count("x") == 1);
+}
+
+static void test_hash_set() {
+    hash_set<std::string, string_hash, string_equal> s;
+    s.insert("abc");
+    s.insert("de");
+    assert(s.find("abc") != s.end());
+    assert(s.count(std::string_view("de")) == 1);
+    assert(s.erase("abc") == 1 && s.size() == 1);
+}
+
+static void test_map() {
+    map<std::string, int, std::less<> > m;
+    m["a"] = 1;
+    m["c"] = 3;
+    m["b"] = 2;
+    assert(m.find(std::string_view("b"))->second == 2);
+    assert(m.find("zz") == m.end());
+    assert(m.count("c") == 1);
+    assert(m.lower_bound(std::string_view("bb"))->second == 3);
+    assert(m.upper_bound(std::string_view("b"))->second == 3);
+    assert(m.equal_range("a").first->second == 1);
+    const map<std::string, int, std::less<> > &cm = m;
+    assert(cm.find("c") != cm.end());
+    assert(m.erase(std::string_view("a")) == 1 && m.size() == 2);
+
+    map<int, int> mi;
+    mi[1] = 1;
+    mi.erase(mi.begin());
+    assert(mi.empty());
+}
+
+static void test_set() {
+    set<std::string, std::less<> > s;
+    s.insert("a");
+    s.insert("c");
+    assert(s.find(std::string_view("a")) != s.end());
+    assert(s.count("c") == 1);
+    assert(*s.lower_bound(std::string_view("b")) == "c");
+    assert(*s.upper_bound(std::string_view("a")) == "c");
+    assert(s.upper_bound("c") == s.end());
+    assert(s.equal_range("c").first != s.end());
+}
+
+int main() {
+    test_hash_map();
+    test_hash_set();
+    test_map();
+    test_set();
+    return 0;
+}
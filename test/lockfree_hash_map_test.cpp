@@ -0,0 +1,75 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "lockfree_hashmap.h"
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void test_single_thread() {
+    lockfree_hash_map<int, std::string> m(10);
+    for (int i = 0; i < 1000; ++i) assert(m.insert(std::pair<const int, std::string>(i, std::to_string(i))));
+    assert(!m.insert(std::pair<const int, std::string>(7, "x")));
+    assert(m.size() == 1000 && m.bucket_count() >= 1000);
+    std::string v;
+    assert(m.find(7, v) && v == "7");
+    assert(!m.insert_or_assign(7, std::string("seven")));
+    assert(m.find(7, v) && v == "seven");
+    assert(m.insert_or_assign(5000, std::string("new")) && m.size() == 1001);
+    assert(m.erase(7) == 1 && m.erase(7) == 0 && !m.contains(7));
+    m.clear();
+    assert(m.empty() && !m.contains(1));
+}
+
+// readers run find() without locks while writers insert, replace, erase and grow the table
+static void test_readers_during_writes() {
+    enum {
+        KEYS = 2000, READERS = 4, WRITERS = 3
+    };
+    lockfree_hash_map<int, std::string> m(10);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r) {
+        readers.emplace_back([&m, &stop] {
+            std::string v;
+            while (!stop.load()) {
+                for (int i = 0; i < KEYS; ++i) {
+                    if (m.find(i, v)) assert(v.size() == 20 || v.size() == 30);
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; ++w) {
+        writers.emplace_back([&m, w] {
+            for (int round = 0; round < 5; ++round) {
+                for (int i = w; i < KEYS; i += WRITERS) {
+                    m.insert(std::pair<const int, std::string>(i, std::string(20, (char) ('a' + w))));
+                    m.insert_or_assign(i, std::string(30, 'x'));
+                    if (i % 5 == 0) m.erase(i);
+                }
+            }
+        });
+    }
+    for (size_t i = 0; i < writers.size(); ++i) writers[i].join();
+    stop.store(true);
+    for (size_t i = 0; i < readers.size(); ++i) readers[i].join();
+
+    size_t n = 0;
+    for (int i = 0; i < KEYS; ++i) {
+        assert(m.contains(i) == (i % 5 != 0));
+        n += m.contains(i);
+    }
+    assert(n == m.size());
+    std::string v;
+    assert(m.find(1, v) && v == std::string(30, 'x'));
+}
+
+int main() {
+    test_single_thread();
+    test_readers_during_writes();
+    return 0;
+}
@@ -0,0 +1,198 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "btree.h"
+#include "hashmap.h"
+#include "hashset.h"
+#include "map.h"
+#include "set.h"
+#include <cassert>
+#include <string>
+
+// extract, insert into another map, a refused insert handing the node back, and merge
+template<class Map>
+static void test_tree_map() {
+    Map a, b;
+    for (int i = 0; i < 2000; ++i) a.insert(std::make_pair(i, std::to_string(i)));
+    for (int i = 1000; i < 3000; ++i) b.insert(std::make_pair(i, "b" + std::to_string(i)));
+
+    typename Map::node_type nh = a.extract(5);
+    assert(nh && nh.value().first == 5 && a.size() == 1999 && a.find(5) == a.end());
+    nh.value().second = "moved";
+    typename Map::insert_return_type r = b.insert(std::move(nh));
+    assert(r.inserted && !r.node && r.position->second == "moved" && b.size() == 2001);
+
+    r = a.insert(b.extract(b.find(1500)));
+    assert(!r.inserted && r.node && r.position->first == 1500 && r.position->second == "1500");
+    {
+        typename Map::node_type dropped = a.extract(7);
+    }
+    assert(a.extract(-1).empty());
+
+    // the keys of b that a already holds stay in b
+    a.merge(b);
+    assert(a.size() == 2999);
+    assert(b.size() == 999 && b.find(1500) == b.end() && b.find(5) == b.end());
+    assert(a.find(5)->second == "moved" && a.find(2500)->second == "b2500" && a.find(1200)->second == "1200");
+    int prev = -1;
+    for (typename Map::iterator it = a.begin(); it != a.end(); ++it) {
+        assert(it->first > prev);
+        prev = it->first;
+    }
+}
+
+// aggregates follow the nodes that merge moves between trees
+static void test_augmented_merge() {
+    typedef augmented_rb_tree_backend<rb_tree_aggregate<rb_tree_sum<long> > > sum_backend;
+    map<int, long, std::less<int>, STL_DEFAULT_ALLOCATOR, sum_backend> s1, s2;
+    for (int i = 0; i < 100; ++i) {
+        s1.insert(std::make_pair(i, (long) i));
+        s2.insert(std::make_pair(i + 50, 1000L));
+    }
+    s1.merge(s2);
+    assert(s1.aggregate() == 4950 + 50 * 1000 && s2.aggregate() == 50 * 1000);
+    assert(s1.select(120)->first == 120 && s1.rank(120) == 120);
+}
+
+static void test_multimap_and_set() {
+    multimap<int, int> m1, m2;
+    for (int i = 0; i < 10; ++i) {
+        m1.insert(std::make_pair(i % 3, i));
+        m2.insert(std::make_pair(i % 3, 100 + i));
+    }
+    m1.merge(m2);
+    assert(m1.size() == 20 && m2.size() == 0 && m1.count(0) == 8);
+    assert(m1.equal_range(1).first->second == 1);
+    m1.insert(m1.extract(2));
+    assert(m1.size() == 20);
+
+    set<std::string> x, y;
+    x.insert("a");
+    x.insert("b");
+    y.insert("b");
+    y.insert("c");
+    x.merge(y);
+    assert(x.size() == 3 && y.size() == 1 && *y.begin() == "b");
+    set<std::string>::node_type sn = x.extract(x.begin());
+    assert(sn.value() == "a");
+    set<std::string>::insert_return_type sr = y.insert(std::move(sn));
+    assert(sr.inserted && *sr.position == "a");
+
+    set<std::string, std::less<std::string>, STL_DEFAULT_ALLOCATOR, btree_backend<> > bx, by;
+    for (int i = 0; i < 500; ++i) {
+        bx.insert(std::to_string(i));
+        by.insert(std::to_string(i + 250));
+    }
+    bx.merge(by);
+    assert(bx.size() == 750 && by.size() == 250 && *by.begin() == "250");
+}
+
+// the handle's node is relinked into whichever table takes it, its own or another
+static void test_hash_map() {
+    hash_map<int, std::string> h1(10), h2(10);
+    for (int i = 0; i < 1000; ++i) h1.try_emplace(i, std::to_string(i));
+    for (int i = 500; i < 1500; ++i) h2.try_emplace(i, "h" + std::to_string(i));
+
+    hash_map<int, std::string>::node_type hn = h1.extract(3);
+    assert(hn && hn.value().second == "3" && h1.size() == 999 && h1.count(3) == 0);
+    const std::string *slot = &hn.value().second;
+    hash_map<int, std::string>::insert_return_type hr = h1.insert(std::move(hn));
+    assert(hr.inserted && h1.size() == 1000 && &hr.position->second == slot);
+
+    hn = h1.extract(4);
+    slot = &hn.value().second;
+    hr = h2.insert(std::move(hn));
+    assert(hr.inserted && hr.position->second == "4" && &hr.position->second == slot);
+    // and on into a third table and back, each handle's node taken in place
+    hash_map<int, std::string> h4;
+    hn = h2.extract(4);
+    slot = &hn.value().second;
+    hr = h4.insert(std::move(hn));
+    assert(hr.inserted && &hr.position->second == slot);
+    hn = h4.extract(4);
+    slot = &hn.value().second;
+    hr = h2.insert(std::move(hn));
+    assert(hr.inserted && &hr.position->second == slot && h4.empty());
+
+    hr = h1.insert(h2.extract(600));
+    assert(!hr.inserted && hr.node && hr.node.value().second == "h600");
+    h2.insert(std::move(hr.node));
+
+    h1.merge(h2);
+    assert(h1.size() == 1500 && h2.size() == 500);
+    for (int i = 500; i < 1000; ++i) assert(h2.find(i)->second == "h" + std::to_string(i));
+    assert(h1.find(1200)->second == "h1200" && h1.find(700)->second == "700" && h1.find(4)->second == "4");
+    assert(&h1.find(4)->second == slot);
+    h2.clear();
+    h2.try_emplace(1, "x");
+    assert(h2.size() == 1);
+    {
+        hash_map<int, std::string> h3(10);
+        for (int i = 2000; i < 2100; ++i) h3.try_emplace(i, "z");
+        h1.merge(h3);
+    }
+    assert(h1.size() == 1600 && h1.find(2050)->second == "z");
+
+    hash_set<int> hs1(10), hs2(10);
+    hs1.insert(1);
+    hs2.insert(1);
+    hs2.insert(2);
+    hs1.merge(hs2);
+    assert(hs1.size() == 2 && hs2.size() == 1);
+    assert(hs1.extract(hs1.find(2)).value() == 2);
+}
+
+// a handle owns its node: it outlives the table it came from whether that table is destroyed,
+// cleared, swapped or merged away, and can be inserted or dropped afterwards
+static void test_hash_handle_outlives_table() {
+    typedef hash_map<int, std::string> table;
+    const std::string long_value = "long-enough-to-allocate-its-own-buffer";
+    table target(10);
+    table::node_type destroyed, cleared, swapped, merged, dropped;
+    const std::string *slot;
+    {
+        table a(10), b(10), c(10);
+        for (int i = 0; i < 100; ++i) {
+            a.try_emplace(i, long_value + std::to_string(i));
+            b.try_emplace(i + 1000, "b");
+            c.try_emplace(i + 2000, "c");
+        }
+        destroyed = a.extract(1);
+        slot = &destroyed.value().second;
+        dropped = a.extract(2);
+        cleared = b.extract(1001);
+        b.clear();
+        swapped = a.extract(3);
+        a.swap(c);
+        merged = c.extract(4);
+        target.merge(c);
+        assert(c.empty() && target.size() == 96);
+    }
+    table::insert_return_type r = target.insert(std::move(destroyed));
+    assert(r.inserted && &r.position->second == slot && r.position->second == long_value + "1");
+    assert(target.insert(std::move(cleared)).inserted && target.find(1001)->second == "b");
+    assert(target.insert(std::move(swapped)).inserted && target.find(3)->second == long_value + "3");
+    assert(target.insert(std::move(merged)).inserted && target.find(4)->second == long_value + "4");
+    assert(dropped.value().second == long_value + "2");
+    dropped = table::node_type();
+    assert(target.size() == 100);
+
+    // a table that took a handle's node frees it with its own nodes, erased or not
+    target.erase(1);
+    target.try_emplace(1, "reused");
+    target.clear();
+    assert(target.empty());
+}
+
+int main() {
+    test_tree_map<map<int, std::string> >();
+    test_tree_map<map<int, std::string, std::less<int>, STL_DEFAULT_ALLOCATOR, btree_backend<> > >();
+    test_tree_map<map<int, std::string, std::less<int>, STL_DEFAULT_ALLOCATOR,
+            augmented_rb_tree_backend<rb_tree_order_statistics> > >();
+    test_augmented_merge();
+    test_multimap_and_set();
+    test_hash_map();
+    test_hash_handle_outlives_table();
+    return 0;
+}
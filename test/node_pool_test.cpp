@@ -0,0 +1,146 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "alloc.h"
+#include "hashmap.h"
+#include "hashset.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <set>
+#include <vector>
+
+// memory 8 bytes past a 64 byte line, as an allocator promising only pointer alignment may give
+struct off_line_alloc {
+    static void *allocate(size_t n) {
+        char *line = (char *) std::aligned_alloc(64, (n + 8 + 63) / 64 * 64);
+        if (!line) throw std::bad_alloc();
+        return line + 8;
+    }
+
+    static void deallocate(void *p, size_t) { std::free((char *) p - 8); }
+};
+
+struct alignas(64) line_value {
+    long x;
+};
+
+struct alignas(32) half_line_value {
+    int x;
+};
+
+// every node is aligned for its type wherever Alloc put the slab, including a slab from reserve()
+template<class T, class Alloc>
+static void check_alignment() {
+    node_pool<T, Alloc> pool;
+    std::vector<T *> nodes;
+    for (int i = 0; i < 1000; ++i) nodes.push_back(pool.allocate());
+    pool.reserve(500);
+    for (int i = 0; i < 500; ++i) nodes.push_back(pool.allocate());
+    for (size_t i = 0; i < nodes.size(); ++i) assert((uintptr_t) nodes[i] % alignof(T) == 0);
+    std::set<T *> distinct(nodes.begin(), nodes.end());
+    assert(distinct.size() == nodes.size());
+}
+
+static void test_alignment() {
+    check_alignment<line_value, off_line_alloc>();
+    check_alignment<half_line_value, off_line_alloc>();
+    check_alignment<line_value, malloc_alloc>();
+    check_alignment<long, off_line_alloc>();
+
+    hash_map<int, line_value, hash<int>, std::equal_to<int>, off_line_alloc> m;
+    for (int i = 0; i < 1000; ++i) m[i].x = i;
+    for (int i = 0; i < 1000; ++i) assert((uintptr_t) &m.find(i)->second % 64 == 0 && m[i].x == i);
+}
+
+// freed nodes are handed out again before any new slab is taken
+static void test_reuse() {
+    node_pool<long, malloc_alloc> pool;
+    assert(pool.bytes() == 0);
+    std::vector<long *> nodes;
+    for (int i = 0; i < 5000; ++i) nodes.push_back(pool.allocate());
+    const size_t bytes = pool.bytes();
+    assert(bytes >= 5000 * sizeof(long));
+    std::set<long *> first(nodes.begin(), nodes.end());
+    for (size_t i = 0; i < nodes.size(); ++i) pool.deallocate(nodes[i]);
+    for (size_t i = 0; i < nodes.size(); ++i) assert(first.count(pool.allocate()) == 1);
+    assert(pool.bytes() == bytes);
+    pool.release();
+    assert(pool.bytes() == 0);
+
+    // the same through a table: erasing every key and inserting as many new ones takes no memory
+    hash_map<int, int> m;
+    for (int i = 0; i < 10000; ++i) m[i] = i;
+    const size_t table_bytes = m.stats().bytes;
+    for (int i = 0; i < 10000; ++i) m.erase(i);
+    for (int i = 0; i < 10000; ++i) m[i + 10000] = i;
+    assert(m.stats().bytes == table_bytes);
+}
+
+// reserve() makes one slab with room for all n nodes, and a bulk insert uses it
+static void test_reserve() {
+    node_pool<long, malloc_alloc> pool;
+    pool.reserve(1000);
+    const size_t bytes = pool.bytes();
+    assert(bytes >= 1000 * sizeof(long));
+    for (int i = 0; i < 1000; ++i) pool.allocate();
+    assert(pool.bytes() == bytes);
+    pool.allocate();
+    assert(pool.bytes() > bytes);
+
+    std::vector<long> keys;
+    for (long i = 0; i < 5000; ++i) keys.push_back(i * 7);
+    hash_set<long> s;
+    s.insert(keys.data(), keys.data() + keys.size());
+    const char *lo = nullptr, *hi = nullptr;
+    for (hash_set<long>::const_iterator it = s.begin(); it != s.end(); ++it) {
+        const char *p = (const char *) &*it;
+        if (!lo || p < lo) lo = p;
+        if (!hi || p > hi) hi = p;
+    }
+    // the 5000 nodes are adjacent
+    assert((size_t) (hi - lo) < keys.size() * sizeof(hashtable_node<long>));
+}
+
+// clear() gives every slab back, so the next insert takes a new one
+static void test_clear_releases() {
+    typedef hashtable_node<std::pair<const int, int> > node;
+    hash_map<int, int> m;
+    for (int i = 0; i < 10000; ++i) m[i] = i;
+    const size_t full = m.stats().bytes;
+    m.clear();
+    const size_t cleared = m.stats().bytes;
+    assert(m.empty() && full - cleared >= 10000 * sizeof(node));
+    m[1] = 1;
+    assert(m.stats().bytes > cleared && m.size() == 1 && m[1] == 1);
+}
+
+// a loose node is aligned, belongs to no pool until one adopts it, and is then counted and
+// freed with that pool's slabs
+static void test_loose_nodes() {
+    typedef node_pool<line_value, off_line_alloc> pool_type;
+    line_value *p = pool_type::allocate_loose();
+    line_value *q = pool_type::allocate_loose();
+    assert((uintptr_t) p % 64 == 0 && (uintptr_t) q % 64 == 0 && p != q);
+    pool_type::deallocate_loose(q);
+
+    pool_type pool;
+    pool.adopt_loose(p);
+    const size_t bytes = pool.bytes();
+    assert(bytes >= sizeof(line_value));
+    pool.deallocate(p);
+    assert(pool.allocate() == p && pool.bytes() == bytes);
+    pool.release();
+    assert(pool.bytes() == 0);
+}
+
+int main() {
+    test_alignment();
+    test_reuse();
+    test_reserve();
+    test_clear_releases();
+    test_loose_nodes();
+    return 0;
+}
@@ -0,0 +1,123 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "map.h"
+#include "set.h"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#ifdef __STL_RB_TREE_COMPACT_NODE
+static_assert(sizeof(_Rb_tree_node_base) == 3 * sizeof(void *), "the colour must live in the parent link");
+#endif
+
+struct checked_set : public set<int> {
+    bool valid() const { return t.__rb_verify(); }
+};
+
+enum set_op {
+    UNITE, INTERSECT, SUBTRACT
+};
+
+static void apply(checked_set &x, checked_set &y, set_op op, unsigned threads) {
+    if (op == UNITE) x.unite(y, threads);
+    else if (op == INTERSECT) x.intersect(y, threads);
+    else x.subtract(y, threads);
+}
+
+// x op y leaves expect in x, in order both ways, and y empty; both trees stay usable
+static void check(const std::set<int> &a, const std::set<int> &b, set_op op,
+                  const std::set<int> &expect, unsigned threads) {
+    checked_set x, y;
+    for (std::set<int>::const_iterator it = a.begin(); it != a.end(); ++it) x.insert(*it);
+    for (std::set<int>::const_iterator it = b.begin(); it != b.end(); ++it) y.insert(*it);
+    apply(x, y, op, threads);
+    assert(x.valid() && y.valid());
+    assert(y.size() == 0 && y.begin() == y.end());
+    assert(x.size() == expect.size());
+    set<int>::iterator it = x.begin();
+    for (std::set<int>::const_iterator e = expect.begin(); e != expect.end(); ++e) assert(*it++ == *e);
+    it = x.end();
+    for (std::set<int>::const_reverse_iterator e = expect.rbegin(); e != expect.rend(); ++e) assert(*--it == *e);
+    x.insert(-5);
+    x.erase(-5);
+    y.insert(1);
+    assert(x.valid() && y.valid());
+}
+
+// small and mid-sized random sets, with thread budgets that never reach the fork threshold
+static void test_random() {
+    std::mt19937 rng(7);
+    for (int iter = 0; iter < 400; ++iter) {
+        const unsigned cap = iter < 200 ? 60 : 3000;
+        const unsigned na = rng() % cap;
+        const unsigned nb = iter % 7 == 0 ? rng() % 3 : rng() % cap;
+        const unsigned range = 1 + rng() % 5000;
+        std::set<int> a, b;
+        for (unsigned i = 0; i < na; ++i) a.insert((int) (rng() % range));
+        for (unsigned i = 0; i < nb; ++i) b.insert((int) (rng() % range));
+        std::set<int> u, in, df;
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::inserter(u, u.end()));
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::inserter(in, in.end()));
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::inserter(df, df.end()));
+        const unsigned threads = 1 + rng() % 8;
+        check(a, b, UNITE, u, threads);
+        check(a, b, INTERSECT, in, threads);
+        check(a, b, SUBTRACT, df, threads);
+    }
+}
+
+// large enough that the halves run on their own threads
+static void test_parallel() {
+    std::vector<int> va, vb;
+    for (int i = 0; i < 200000; ++i) {
+        va.push_back(i * 2);
+        vb.push_back(i * 3);
+    }
+    checked_set x, y;
+    x.insert(va.data(), va.data() + va.size());
+    y.insert(vb.data(), vb.data() + vb.size());
+    checked_set x2(x), y2(y), x3(x), y3(y);
+
+    x.unite(y, 8);
+    assert(x.valid());
+    std::set<int> ref(va.begin(), va.end());
+    ref.insert(vb.begin(), vb.end());
+    assert(x.size() == ref.size() && std::equal(x.begin(), x.end(), ref.begin()));
+
+    x2.intersect(y2, 8);
+    assert(x2.valid());
+    for (set<int>::iterator it = x2.begin(); it != x2.end(); ++it) assert(*it % 6 == 0);
+
+    x3.subtract(y3, 8);
+    assert(x3.valid());
+    for (set<int>::iterator it = x3.begin(); it != x3.end(); ++it) assert(*it % 2 == 0 && *it % 3 != 0);
+    assert(x2.size() + x3.size() == 200000);
+}
+
+// where both hold a key, this map's value is kept
+static void test_map_keeps_own_values() {
+    map<int, int> m1, m2;
+    m1[1] = 10;
+    m1[2] = 20;
+    m2[2] = 99;
+    m2[3] = 30;
+    m1.unite(m2);
+    assert(m1.size() == 3 && m1[2] == 20 && m1[3] == 30 && m2.empty());
+
+    checked_set z;
+    z.insert(1);
+    z.subtract(z);
+    assert(z.size() == 0 && z.valid());
+}
+
+int main() {
+    test_random();
+    test_parallel();
+    test_map_keeps_own_values();
+    return 0;
+}
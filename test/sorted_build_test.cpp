@@ -0,0 +1,84 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "set.h"
+#include <cassert>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+// exposes the tree so the red-black invariants can be checked after a build
+template<class Key>
+struct checked_set : public set<Key> {
+    bool valid() const { return this->t.__rb_verify(); }
+};
+
+// every size up to a few levels: the bottom-up build hangs a full tree, then inserts and
+// erases run the usual fixups on it
+static void test_sizes() {
+    for (int n = 0; n < 300; ++n) {
+        std::vector<int> v;
+        for (int i = 0; i < n; ++i) v.push_back(i * 2);
+        checked_set<int> s;
+        s.insert(v.data(), v.data() + v.size());
+        assert(s.size() == (size_t) n && s.valid());
+        int i = 0;
+        for (set<int>::iterator it = s.begin(); it != s.end(); ++it) assert(*it == 2 * i++);
+        for (int k = 0; k < n; k += 3) s.insert(k * 2 + 1);
+        for (int k = 0; k < n; k += 2) assert(s.erase(k * 2) == 1);
+        assert(s.valid());
+    }
+}
+
+// adjacent duplicates are skipped, and the first out-of-order key ends the fast path
+static void test_duplicates_and_unsorted_tail() {
+    std::vector<int> v = {1, 1, 2, 3, 3, 3, 7, 9, 4, 4, 12, 0};
+    checked_set<int> s;
+    s.insert(v.data(), v.data() + v.size());
+    assert(s.valid());
+    std::set<int> ref(v.begin(), v.end());
+    assert(s.size() == ref.size());
+    set<int>::iterator it = s.begin();
+    for (std::set<int>::iterator r = ref.begin(); r != ref.end(); ++r) assert(*it++ == *r);
+    assert(s.count(3) == 1 && s.count(5) == 0);
+}
+
+// the nodes of a run come from one chunk, so an in-order walk mostly steps to the next node
+static void test_nodes_adjacent() {
+    std::vector<long> v;
+    for (long i = 0; i < 100000; ++i) v.push_back(i);
+    set<long> s;
+    s.insert(v.data(), v.data() + v.size());
+    size_t adjacent = 0;
+    const char *prev = nullptr;
+    for (set<long>::iterator it = s.begin(); it != s.end(); ++it) {
+        const char *p = (const char *) &*it;
+        if (prev && p > prev && p - prev <= 64) ++adjacent;
+        prev = p;
+    }
+    assert(adjacent > s.size() * 9 / 10);
+}
+
+static void test_strings() {
+    std::vector<std::string> v;
+    for (int i = 0; i < 5000; ++i) {
+        char buf[16];
+        std::snprintf(buf, sizeof buf, "k%06d", i);
+        v.push_back(std::string(buf) + "-long-enough-to-allocate");
+    }
+    set<std::string> s;
+    s.insert(v.data(), v.data() + v.size());
+    assert(s.size() == 5000);
+    s.insert(v.data(), v.data() + v.size());
+    assert(s.size() == 5000);
+}
+
+int main() {
+    test_sizes();
+    test_duplicates_and_unsorted_tail();
+    test_nodes_adjacent();
+    test_strings();
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "static_hashmap.h"
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct constant_hash {
+    size_t operator()(int) const { return 1; }
+};
+
+static void check(size_t n, long stride) {
+    std::vector<std::pair<long, int> > v;
+    for (size_t i = 0; i < n; ++i) v.push_back(std::make_pair((long) i * stride + 13, (int) i));
+    static_hash_map<long, int> m(v.begin(), v.end());
+    assert(m.size() == n);
+    for (size_t i = 0; i < n; ++i) {
+        static_hash_map<long, int>::iterator it = m.find((long) i * stride + 13);
+        assert(it != m.end() && it->second == (int) i);
+    }
+    for (long i = 1; i <= 200; ++i) assert(m.count(-i * stride) == 0);
+    size_t seen = 0;
+    for (static_hash_map<long, int>::const_iterator it = m.begin(); it != m.end(); ++it) ++seen;
+    assert(seen == n);
+}
+
+int main() {
+    // with BUCKET_LOAD keys per bucket on average about one bucket in six holds a single key
+    // and takes its slot directly, and the displaced keys that land in the SPARE slots past
+    // size() go through remap. small tables with many key sets hit both early and late in
+    // the build; the large ones have thousands of each.
+    for (size_t n = 0; n <= 64; ++n) {
+        for (long stride = 1; stride < 40; stride += 3) check(n, stride);
+    }
+    check(1000, 7919);
+    check(100000, 7919);
+
+    std::vector<std::pair<std::string, int> > s;
+    s.push_back(std::make_pair(std::string("GET"), 1));
+    s.push_back(std::make_pair(std::string("POST"), 2));
+    s.push_back(std::make_pair(std::string("PUT"), 3));
+    s.push_back(std::make_pair(std::string("GET"), 9));
+    static_hash_map<std::string, int> sm(s.begin(), s.end());
+    // repeated keys keep the first
+    assert(sm.size() == 3 && sm.find("GET")->second == 1 && sm.find("DELETE") == sm.end());
+    sm.find("PUT")->second = 4;
+    static_hash_map<std::string, int> c(sm);
+    assert(c.find("PUT")->second == 4);
+    static_hash_map<std::string, int> e;
+    assert(e.empty() && e.find("GET") == e.end());
+    e = c;
+    assert(e.size() == 3 && e.count("POST"));
+    e.assign(s.begin(), s.begin() + 1);
+    assert(e.size() == 1 && e.count("GET") && !e.count("POST"));
+
+    std::vector<std::pair<int, int> > clash;
+    clash.push_back(std::make_pair(1, 1));
+    clash.push_back(std::make_pair(2, 2));
+    bool threw = false;
+    try {
+        static_hash_map<int, int, constant_hash> b(clash.begin(), clash.end());
+    } catch (std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+    return 0;
+}
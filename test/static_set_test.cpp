@@ -0,0 +1,144 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "static_set.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// 16 bytes aligned to 8, so the allocator can hand out storage that sits half a key off a line
+struct wide_key {
+    long k;
+    long pad;
+
+    bool operator<(const wide_key &x) const { return k < x.k; }
+
+    bool operator==(const wide_key &x) const { return k == x.k; }
+};
+
+// hands out storage 8 bytes past a line, so a key wider than 8 bytes never starts on one
+struct off_line_alloc {
+    static void *allocate(size_t n) {
+        char *line = (char *) std::aligned_alloc(64, (n + 8 + 63) / 64 * 64);
+        if (!line) throw std::bad_alloc();
+        return line + 8;
+    }
+
+    static void deallocate(void *p, size_t) { std::free((char *) p - 8); }
+};
+
+struct big_key {
+    char bytes[24];
+    int k;
+
+    bool operator<(const big_key &x) const { return k < x.k; }
+};
+
+// in order both ways, and every search agrees with the std set over probes on and off the keys
+template<class Set, class Ref>
+static void check(const Set &s, const Ref &ref, std::mt19937 &rng, int range) {
+    assert(s.size() == ref.size() && s.empty() == ref.empty());
+    typename Set::iterator it = s.begin();
+    for (typename Ref::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it) {
+        assert(it != s.end());
+        assert(*it == *r);
+    }
+    assert(it == s.end());
+    for (typename Ref::const_reverse_iterator r = ref.rbegin(); r != ref.rend(); ++r) {
+        --it;
+        assert(*it == *r);
+    }
+    assert(it == s.begin());
+    for (int q = 0; q < 2000; ++q) {
+        const int x = (int) (rng() % (range + 2)) - 1;
+        typename Set::iterator a = s.lower_bound(x);
+        typename Ref::const_iterator b = ref.lower_bound(x);
+        assert((a == s.end()) == (b == ref.end()));
+        if (b != ref.end()) assert(*a == *b);
+        a = s.upper_bound(x);
+        b = ref.upper_bound(x);
+        assert((a == s.end()) == (b == ref.end()));
+        if (b != ref.end()) assert(*a == *b);
+        assert(s.count(x) == ref.count(x));
+        assert((s.find(x) != s.end()) == (ref.find(x) != ref.end()));
+        std::pair<typename Set::iterator, typename Set::iterator> e = s.equal_range(x);
+        assert((e.first != e.second) == (ref.count(x) == 1));
+    }
+}
+
+static void test_sizes() {
+    std::mt19937 rng(49);
+    const int sizes[] = {0, 1, 2, 3, 7, 8, 15, 16, 17, 100, 1000, 4095, 4096, 5000};
+    for (int n : sizes) {
+        std::vector<int> v;
+        for (int i = 0; i < n; ++i) v.push_back((int) (rng() % (2 * n + 1)));
+        std::set<int> ref(v.begin(), v.end());
+        static_set<int> s(v.begin(), v.end());
+        check(s, ref, rng, 2 * n + 1);
+        static_set<int> copy(s);
+        check(copy, ref, rng, 2 * n + 1);
+        static_set<int> assigned;
+        assigned = s;
+        check(assigned, ref, rng, 2 * n + 1);
+
+        static_set<int, std::greater<int> > g(v.begin(), v.end());
+        std::set<int, std::greater<int> > rg(v.begin(), v.end());
+        check(g, rg, rng, 2 * n + 1);
+        static_set<long long> wide(v.begin(), v.end());
+        assert(wide.size() == ref.size());
+    }
+}
+
+// the tree starts on a line for every key size that tiles one, including keys wider than the
+// allocator's alignment and storage that starts off a line
+static void test_alignment() {
+    for (int n = 1; n < 200; ++n) {
+        std::vector<int> ints;
+        std::vector<wide_key> wides;
+        for (int i = 0; i < n; ++i) {
+            ints.push_back(i);
+            wides.push_back(wide_key{i, 0});
+        }
+        static_set<int> s(ints.begin(), ints.end());
+        assert((uintptr_t) s.begin().tree % 64 == 0);
+        static_set<wide_key> w(wides.begin(), wides.end());
+        assert((uintptr_t) w.begin().tree % 64 == 0);
+        assert(w.size() == (size_t) n && w.find(wide_key{n / 2, 0})->k == n / 2);
+        assert(w.find(wide_key{n, 0}) == w.end());
+        static_set<wide_key, std::less<wide_key>, off_line_alloc> off(wides.begin(), wides.end());
+        assert((uintptr_t) off.begin().tree % 64 == 0);
+        assert(off.size() == (size_t) n && off.find(wide_key{n / 2, 0})->k == n / 2);
+    }
+}
+
+static void test_strings_and_big_keys() {
+    std::vector<std::string> w = {"pear", "apple", "fig", "apple", "kiwi"};
+    static_set<std::string> s(w.begin(), w.end());
+    assert(s.size() == 4 && *s.begin() == "apple");
+    assert(*s.lower_bound("b") == "fig" && s.count("kiwi") && !s.count("plum"));
+    static_set<std::string> t;
+    t.assign(w.begin(), w.begin() + 2);
+    assert(t.size() == 2);
+    t.swap(s);
+    assert(s.size() == 2 && t.size() == 4);
+
+    std::vector<big_key> keys(300);
+    for (int i = 0; i < 300; ++i) keys[i].k = (i * 7) % 300;
+    static_set<big_key> b(keys.begin(), keys.end());
+    big_key q;
+    q.k = 150;
+    assert(b.find(q)->k == 150 && b.size() == 300);
+}
+
+int main() {
+    test_sizes();
+    test_alignment();
+    test_strings_and_big_keys();
+    return 0;
+}
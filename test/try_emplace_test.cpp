@@ -0,0 +1,83 @@
+//
+// Created by Beth on 2026/10/19.
+//
+
+#include "hashmap.h"
+#include "map.h"
+#include <cassert>
+#include <string>
+
+static int constructions = 0;
+
+struct counted {
+    int v;
+
+    counted() : v(0) { ++constructions; }
+
+    counted(int a) : v(a) { ++constructions; }
+
+    counted(const counted &x) : v(x.v) { ++constructions; }
+
+    counted &operator=(const counted &x) {
+        v = x.v;
+        return *this;
+    }
+};
+
+template<class Map>
+static void test_no_construction_on_hit(Map &m) {
+    for (int i = 999; i >= 0; --i) m.try_emplace(i, i);
+    assert(m.size() == 1000);
+    constructions = 0;
+    for (int i = 0; i < 1000; ++i) assert(!m.try_emplace(i, 7).second);
+    assert(constructions == 0);
+    assert(m[5].v == 5 && constructions == 0);
+
+    assert(!m.insert_or_assign(5, counted(9)).second);
+    assert(m[5].v == 9);
+    assert(m.insert_or_assign(5000, 1).second && m[5000].v == 1);
+}
+
+template<class Map>
+static void test_rvalue_keys(Map &m) {
+    std::string key(40, 'k');
+    assert(m.try_emplace(std::move(key), 3).second);
+    assert(key.empty());
+    assert(m[std::string(40, 'k')] == 3);
+
+    // a key already present is left alone
+    std::string again(40, 'k');
+    assert(!m.try_emplace(std::move(again), 4).second);
+    assert(again == std::string(40, 'k') && m[again] == 3);
+
+    std::string other(40, 'o');
+    assert(m.insert_or_assign(std::move(other), 5).second);
+    assert(other.empty() && m[std::string(40, 'o')] == 5);
+
+    std::string present(40, 'o');
+    assert(!m.insert_or_assign(std::move(present), 6).second);
+    assert(present == std::string(40, 'o') && m[present] == 6);
+
+    std::string indexed(40, 'i');
+    m[std::move(indexed)] = 7;
+    assert(indexed.empty() && m[std::string(40, 'i')] == 7);
+    assert(m.size() == 3);
+}
+
+int main() {
+    hash_map<int, counted> h;
+    test_no_construction_on_hit(h);
+    map<int, counted> m;
+    test_no_construction_on_hit(m);
+    int prev = -1;
+    for (map<int, counted>::iterator it = m.begin(); it != m.end(); ++it) {
+        assert((*it).first > prev);
+        prev = (*it).first;
+    }
+
+    hash_map<std::string, int> hs;
+    test_rvalue_keys(hs);
+    map<std::string, int> ms;
+    test_rvalue_keys(ms);
+    return 0;
+}
@@ -28,21 +28,70 @@ relinked into its place, rather than copied, so that the only
 #include "alloc.h"
 #include "construct.h"
 #include "iterator.h"
+#include "node_handle.h"
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <type_traits>
 
 
 typedef bool _Rb_tree_Color_type;
 const _Rb_tree_Color_type _S_rb_tree_red = false;
 const _Rb_tree_Color_type _S_rb_tree_black = true;
 
+struct _Rb_tree_node_base;
+
+#ifdef __STL_RB_TREE_COMPACT_NODE
+
+// With __STL_RB_TREE_COMPACT_NODE defined the colour is kept in bit 0 of the
+// parent link, which node alignment always leaves clear, and a node base is
+// three words instead of four.  The word reads and assigns like the pointer
+// it replaces; assigning a new parent leaves the colour alone.
+struct _Rb_tree_parent_word {
+    uintptr_t _M_word;
+
+    operator _Rb_tree_node_base *() const { return (_Rb_tree_node_base *) (_M_word & ~uintptr_t(1)); }
+
+    _Rb_tree_node_base *operator->() const { return *this; }
+
+    _Rb_tree_parent_word &operator=(_Rb_tree_node_base *__p) {
+        _M_word = (uintptr_t) __p | (_M_word & uintptr_t(1));
+        return *this;
+    }
+
+    _Rb_tree_parent_word &operator=(const _Rb_tree_parent_word &__x) {
+        return *this = (_Rb_tree_node_base *) __x;
+    }
+};
+
+#endif
+
 struct _Rb_tree_node_base {
     typedef _Rb_tree_Color_type _Color_type;
     typedef _Rb_tree_node_base *_Base_ptr;
 
+#ifdef __STL_RB_TREE_COMPACT_NODE
+    _Rb_tree_parent_word _M_parent;
+#else
     _Color_type _M_color;
     _Base_ptr _M_parent;
+#endif
     _Base_ptr _M_left;
     _Base_ptr _M_right;
 
+#ifdef __STL_RB_TREE_COMPACT_NODE
+    _Color_type _M_get_color() const { return (_Color_type) (_M_parent._M_word & uintptr_t(1)); }
+
+    void _M_set_color(_Color_type __c) {
+        _M_parent._M_word = (_M_parent._M_word & ~uintptr_t(1)) | uintptr_t(__c);
+    }
+#else
+    _Color_type _M_get_color() const { return _M_color; }
+
+    void _M_set_color(_Color_type __c) { _M_color = __c; }
+#endif
+
     static _Base_ptr _S_minimum(_Base_ptr __x) {
         while (__x->_M_left != 0) __x = __x->_M_left;
         return __x;
@@ -84,7 +133,7 @@ struct _Rb_tree_base_iterator {
     }
 
     void _M_decrement() {
-        if (_M_node->_M_color == _S_rb_tree_red &&
+        if (_M_node->_M_get_color() == _S_rb_tree_red &&
             _M_node->_M_parent->_M_parent == _M_node)
             _M_node = _M_node->_M_right;
         else if (_M_node->_M_left != 0) {
@@ -182,8 +231,189 @@ inline _Value *value_type(const _Rb_tree_iterator<_Value, _Ref, _Ptr> &) {
 
 #endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
 
+// Augmentation hook.  An augmentation keeps a summary of every subtree in
+// the subtree's root.  _Rb_tree takes it as a template parameter and uses
+// its _Traits<_Value>:
+//   _Node      the node type, an _Rb_tree_node<_Value> with room for the summary
+//   _Update    a functor that recomputes the summary of a node from its value
+//              and its children, and whose static _S_copy copies a summary
+//   _Aggregate the result of range_aggregate, with the static members
+//              _S_identity(), _S_lift(node), _S_aggregate(subtree) and
+//              _S_combine(a, b) it is computed from
+// The rotations and the rebalancing after insert and erase call _Update on
+// every node whose subtree changed, children before parents.
+struct _Rb_tree_no_update {
+    void operator()(_Rb_tree_node_base *) const {}
+
+    static void _S_copy(_Rb_tree_node_base *, const _Rb_tree_node_base *) {}
+};
+
+struct _Rb_tree_no_augment {
+    template<class _Value>
+    struct _Traits {
+        typedef _Rb_tree_node<_Value> _Node;
+        typedef _Rb_tree_no_update _Update;
+        typedef void _Aggregate;
+    };
+};
+
+template<class _Value, class _Summary>
+struct _Rb_tree_augmented_node : public _Rb_tree_node<_Value> {
+    _Summary _M_summary;
+};
+
+// Subtree sizes, for select, rank and distance in O(log n).
+struct rb_tree_order_statistics {
+    template<class _Value>
+    struct _Traits {
+        typedef _Rb_tree_augmented_node<_Value, size_t> _Node;
+
+        typedef size_t _Aggregate;
+
+        static size_t _S_count(const _Rb_tree_node_base *__x) {
+            return __x ? static_cast<const _Node *>(__x)->_M_summary : 0;
+        }
+
+        static size_t _S_identity() { return 0; }
+
+        static size_t _S_lift(const _Rb_tree_node_base *) { return 1; }
+
+        static size_t _S_aggregate(const _Rb_tree_node_base *__x) { return _S_count(__x); }
+
+        static size_t _S_combine(size_t __a, size_t __b) { return __a + __b; }
+
+        struct _Update {
+            void operator()(_Rb_tree_node_base *__x) const {
+                static_cast<_Node *>(__x)->_M_summary = 1 + _S_count(__x->_M_left) + _S_count(__x->_M_right);
+            }
+
+            static void _S_copy(_Rb_tree_node_base *__to, const _Rb_tree_node_base *__from) {
+                static_cast<_Node *>(__to)->_M_summary = static_cast<const _Node *>(__from)->_M_summary;
+            }
+        };
+    };
+};
+
+// Subtree sizes together with a monoid over the elements, for range_aggregate
+// in O(log n) on top of the order statistics.  _Monoid has a result_type and
+// the static members
+//   identity()        the neutral element
+//   lift(__v)         the aggregate of the single element __v
+//   combine(__a, __b) associative, __a covering the elements before __b
+// The summaries live in the raw node memory next to the value, without a
+// constructor or destructor of their own, so result_type must be trivially
+// copyable.
+template<class _Monoid>
+struct rb_tree_aggregate {
+    template<class _Value>
+    struct _Traits {
+        typedef typename _Monoid::result_type _Aggregate;
+
+        static_assert(std::is_trivially_copyable<_Aggregate>::value,
+                      "rb_tree_aggregate needs a trivially copyable result_type");
+
+        struct _Summary {
+            size_t _M_count;
+            _Aggregate _M_value;
+        };
+
+        typedef _Rb_tree_augmented_node<_Value, _Summary> _Node;
+
+        static const _Summary &_S_summary(const _Rb_tree_node_base *__x) {
+            return static_cast<const _Node *>(__x)->_M_summary;
+        }
+
+        static size_t _S_count(const _Rb_tree_node_base *__x) { return __x ? _S_summary(__x)._M_count : 0; }
+
+        static _Aggregate _S_identity() { return _Monoid::identity(); }
+
+        static _Aggregate _S_lift(const _Rb_tree_node_base *__x) {
+            return _Monoid::lift(static_cast<const _Node *>(__x)->_M_value_field);
+        }
+
+        static _Aggregate _S_aggregate(const _Rb_tree_node_base *__x) {
+            return __x ? _S_summary(__x)._M_value : _Monoid::identity();
+        }
+
+        static _Aggregate _S_combine(const _Aggregate &__a, const _Aggregate &__b) {
+            return _Monoid::combine(__a, __b);
+        }
+
+        struct _Update {
+            void operator()(_Rb_tree_node_base *__x) const {
+                _Summary &__s = static_cast<_Node *>(__x)->_M_summary;
+                __s._M_count = 1 + _S_count(__x->_M_left) + _S_count(__x->_M_right);
+                __s._M_value = _Monoid::combine(_Monoid::combine(_S_aggregate(__x->_M_left), _S_lift(__x)),
+                                                _S_aggregate(__x->_M_right));
+            }
+
+            static void _S_copy(_Rb_tree_node_base *__to, const _Rb_tree_node_base *__from) {
+                static_cast<_Node *>(__to)->_M_summary = _S_summary(__from);
+            }
+        };
+    };
+};
+
+// The mapped value of a map element, the element itself otherwise; the
+// default projection of the monoids below.
+struct rb_tree_mapped_value {
+    template<class _Kp, class _Tp>
+    const _Tp &operator()(const std::pair<_Kp, _Tp> &__x) const { return __x.second; }
+
+    template<class _Tp>
+    const _Tp &operator()(const _Tp &__x) const { return __x; }
+};
+
+template<class _Tp, class _Project = rb_tree_mapped_value>
+struct rb_tree_sum {
+    typedef _Tp result_type;
+
+    static _Tp identity() { return _Tp(); }
+
+    template<class _Value>
+    static _Tp lift(const _Value &__v) { return _Tp(_Project()(__v)); }
+
+    static _Tp combine(const _Tp &__a, const _Tp &__b) { return __a + __b; }
+};
+
+// min and max start from numeric_limits, so an empty range gives max() and
+// lowest() respectively.
+template<class _Tp, class _Project = rb_tree_mapped_value>
+struct rb_tree_min {
+    typedef _Tp result_type;
+
+    static _Tp identity() { return std::numeric_limits<_Tp>::max(); }
+
+    template<class _Value>
+    static _Tp lift(const _Value &__v) { return _Tp(_Project()(__v)); }
+
+    static _Tp combine(const _Tp &__a, const _Tp &__b) { return __b < __a ? __b : __a; }
+};
+
+template<class _Tp, class _Project = rb_tree_mapped_value>
+struct rb_tree_max {
+    typedef _Tp result_type;
+
+    static _Tp identity() { return std::numeric_limits<_Tp>::lowest(); }
+
+    template<class _Value>
+    static _Tp lift(const _Value &__v) { return _Tp(_Project()(__v)); }
+
+    static _Tp combine(const _Tp &__a, const _Tp &__b) { return __a < __b ? __b : __a; }
+};
+
+// Recomputes the summaries from __x up to, not including, __end.
+template<class _Update>
+inline void _Rb_tree_update_path(_Rb_tree_node_base *__x, _Rb_tree_node_base *__end, _Update __update) {
+    for (; __x != __end; __x = __x->_M_parent)
+        __update(__x);
+}
+
+inline void _Rb_tree_update_path(_Rb_tree_node_base *, _Rb_tree_node_base *, _Rb_tree_no_update) {}
+
+template<class _Update>
 inline void
-_Rb_tree_rotate_left(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root) {
+_Rb_tree_rotate_left(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root, _Update __update) {
     _Rb_tree_node_base *__y = __x->_M_right;
     __x->_M_right = __y->_M_left;
     if (__y->_M_left != 0)
@@ -198,10 +428,13 @@ _Rb_tree_rotate_left(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root) {
         __x->_M_parent->_M_right = __y;
     __y->_M_left = __x;
     __x->_M_parent = __y;
+    __update(__x);
+    __update(__y);
 }
 
+template<class _Update>
 inline void
-_Rb_tree_rotate_right(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root) {
+_Rb_tree_rotate_right(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root, _Update __update) {
     _Rb_tree_node_base *__y = __x->_M_left;
     __x->_M_left = __y->_M_right;
     if (__y->_M_right != 0)
@@ -216,54 +449,60 @@ _Rb_tree_rotate_right(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root) {
         __x->_M_parent->_M_left = __y;
     __y->_M_right = __x;
     __x->_M_parent = __y;
+    __update(__x);
+    __update(__y);
 }
 
+template<class _Update>
 inline void
-_Rb_tree_rebalance(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root) {
-    __x->_M_color = _S_rb_tree_red;
-    while (__x != __root && __x->_M_parent->_M_color == _S_rb_tree_red) {
+_Rb_tree_rebalance(_Rb_tree_node_base *__x, _Rb_tree_node_base *&__root, _Update __update) {
+    _Rb_tree_update_path(__x, __root->_M_parent, __update);
+    __x->_M_set_color(_S_rb_tree_red);
+    while (__x != __root && __x->_M_parent->_M_get_color() == _S_rb_tree_red) {
         if (__x->_M_parent == __x->_M_parent->_M_parent->_M_left) {
             _Rb_tree_node_base *__y = __x->_M_parent->_M_parent->_M_right;
-            if (__y && __y->_M_color == _S_rb_tree_red) {
-                __x->_M_parent->_M_color = _S_rb_tree_black;
-                __y->_M_color = _S_rb_tree_black;
-                __x->_M_parent->_M_parent->_M_color = _S_rb_tree_red;
+            if (__y && __y->_M_get_color() == _S_rb_tree_red) {
+                __x->_M_parent->_M_set_color(_S_rb_tree_black);
+                __y->_M_set_color(_S_rb_tree_black);
+                __x->_M_parent->_M_parent->_M_set_color(_S_rb_tree_red);
                 __x = __x->_M_parent->_M_parent;
             } else {
                 if (__x == __x->_M_parent->_M_right) {
                     __x = __x->_M_parent;
-                    _Rb_tree_rotate_left(__x, __root);
+                    _Rb_tree_rotate_left(__x, __root, __update);
                 }
-                __x->_M_parent->_M_color = _S_rb_tree_black;
-                __x->_M_parent->_M_parent->_M_color = _S_rb_tree_red;
-                _Rb_tree_rotate_right(__x->_M_parent->_M_parent, __root);
+                __x->_M_parent->_M_set_color(_S_rb_tree_black);
+                __x->_M_parent->_M_parent->_M_set_color(_S_rb_tree_red);
+                _Rb_tree_rotate_right(__x->_M_parent->_M_parent, __root, __update);
             }
         } else {
             _Rb_tree_node_base *__y = __x->_M_parent->_M_parent->_M_left;
-            if (__y && __y->_M_color == _S_rb_tree_red) {
-                __x->_M_parent->_M_color = _S_rb_tree_black;
-                __y->_M_color = _S_rb_tree_black;
-                __x->_M_parent->_M_parent->_M_color = _S_rb_tree_red;
+            if (__y && __y->_M_get_color() == _S_rb_tree_red) {
+                __x->_M_parent->_M_set_color(_S_rb_tree_black);
+                __y->_M_set_color(_S_rb_tree_black);
+                __x->_M_parent->_M_parent->_M_set_color(_S_rb_tree_red);
                 __x = __x->_M_parent->_M_parent;
             } else {
                 if (__x == __x->_M_parent->_M_left) {
                     __x = __x->_M_parent;
-                    _Rb_tree_rotate_right(__x, __root);
+                    _Rb_tree_rotate_right(__x, __root, __update);
                 }
-                __x->_M_parent->_M_color = _S_rb_tree_black;
-                __x->_M_parent->_M_parent->_M_color = _S_rb_tree_red;
-                _Rb_tree_rotate_left(__x->_M_parent->_M_parent, __root);
+                __x->_M_parent->_M_set_color(_S_rb_tree_black);
+                __x->_M_parent->_M_parent->_M_set_color(_S_rb_tree_red);
+                _Rb_tree_rotate_left(__x->_M_parent->_M_parent, __root, __update);
             }
         }
     }
-    __root->_M_color = _S_rb_tree_black;
+    __root->_M_set_color(_S_rb_tree_black);
 }
 
+template<class _Update>
 inline _Rb_tree_node_base *
 _Rb_tree_rebalance_for_erase(_Rb_tree_node_base *__z,
                              _Rb_tree_node_base *&__root,
                              _Rb_tree_node_base *&__leftmost,
-                             _Rb_tree_node_base *&__rightmost) {
+                             _Rb_tree_node_base *&__rightmost,
+                             _Update __update) {
     _Rb_tree_node_base *__y = __z;
     _Rb_tree_node_base *__x = 0;
     _Rb_tree_node_base *__x_parent = 0;
@@ -295,7 +534,9 @@ _Rb_tree_rebalance_for_erase(_Rb_tree_node_base *__z,
         else
             __z->_M_parent->_M_right = __y;
         __y->_M_parent = __z->_M_parent;
-        std::swap(__y->_M_color, __z->_M_color);
+        _Rb_tree_Color_type __c = __y->_M_get_color();
+        __y->_M_set_color(__z->_M_get_color());
+        __z->_M_set_color(__c);
         __y = __z;
         // __y now points to node to be actually deleted
     } else {                        // __y == __z
@@ -320,72 +561,150 @@ _Rb_tree_rebalance_for_erase(_Rb_tree_node_base *__z,
             else                      // __x == __z->_M_left
                 __rightmost = _Rb_tree_node_base::_S_maximum(__x);
     }
-    if (__y->_M_color != _S_rb_tree_red) {
-        while (__x != __root && (__x == 0 || __x->_M_color == _S_rb_tree_black))
+    // every node above the one unlinked lost an element
+    if (__root) _Rb_tree_update_path(__x_parent, __root->_M_parent, __update);
+    if (__y->_M_get_color() != _S_rb_tree_red) {
+        while (__x != __root && (__x == 0 || __x->_M_get_color() == _S_rb_tree_black))
             if (__x == __x_parent->_M_left) {
                 _Rb_tree_node_base *__w = __x_parent->_M_right;
-                if (__w->_M_color == _S_rb_tree_red) {
-                    __w->_M_color = _S_rb_tree_black;
-                    __x_parent->_M_color = _S_rb_tree_red;
-                    _Rb_tree_rotate_left(__x_parent, __root);
+                if (__w->_M_get_color() == _S_rb_tree_red) {
+                    __w->_M_set_color(_S_rb_tree_black);
+                    __x_parent->_M_set_color(_S_rb_tree_red);
+                    _Rb_tree_rotate_left(__x_parent, __root, __update);
                     __w = __x_parent->_M_right;
                 }
                 if ((__w->_M_left == 0 ||
-                     __w->_M_left->_M_color == _S_rb_tree_black) &&
+                     __w->_M_left->_M_get_color() == _S_rb_tree_black) &&
                     (__w->_M_right == 0 ||
-                     __w->_M_right->_M_color == _S_rb_tree_black)) {
-                    __w->_M_color = _S_rb_tree_red;
+                     __w->_M_right->_M_get_color() == _S_rb_tree_black)) {
+                    __w->_M_set_color(_S_rb_tree_red);
                     __x = __x_parent;
                     __x_parent = __x_parent->_M_parent;
                 } else {
                     if (__w->_M_right == 0 ||
-                        __w->_M_right->_M_color == _S_rb_tree_black) {
-                        if (__w->_M_left) __w->_M_left->_M_color = _S_rb_tree_black;
-                        __w->_M_color = _S_rb_tree_red;
-                        _Rb_tree_rotate_right(__w, __root);
+                        __w->_M_right->_M_get_color() == _S_rb_tree_black) {
+                        if (__w->_M_left) __w->_M_left->_M_set_color(_S_rb_tree_black);
+                        __w->_M_set_color(_S_rb_tree_red);
+                        _Rb_tree_rotate_right(__w, __root, __update);
                         __w = __x_parent->_M_right;
                     }
-                    __w->_M_color = __x_parent->_M_color;
-                    __x_parent->_M_color = _S_rb_tree_black;
-                    if (__w->_M_right) __w->_M_right->_M_color = _S_rb_tree_black;
-                    _Rb_tree_rotate_left(__x_parent, __root);
+                    __w->_M_set_color(__x_parent->_M_get_color());
+                    __x_parent->_M_set_color(_S_rb_tree_black);
+                    if (__w->_M_right) __w->_M_right->_M_set_color(_S_rb_tree_black);
+                    _Rb_tree_rotate_left(__x_parent, __root, __update);
                     break;
                 }
             } else {                  // same as above, with _M_right <-> _M_left.
                 _Rb_tree_node_base *__w = __x_parent->_M_left;
-                if (__w->_M_color == _S_rb_tree_red) {
-                    __w->_M_color = _S_rb_tree_black;
-                    __x_parent->_M_color = _S_rb_tree_red;
-                    _Rb_tree_rotate_right(__x_parent, __root);
+                if (__w->_M_get_color() == _S_rb_tree_red) {
+                    __w->_M_set_color(_S_rb_tree_black);
+                    __x_parent->_M_set_color(_S_rb_tree_red);
+                    _Rb_tree_rotate_right(__x_parent, __root, __update);
                     __w = __x_parent->_M_left;
                 }
                 if ((__w->_M_right == 0 ||
-                     __w->_M_right->_M_color == _S_rb_tree_black) &&
+                     __w->_M_right->_M_get_color() == _S_rb_tree_black) &&
                     (__w->_M_left == 0 ||
-                     __w->_M_left->_M_color == _S_rb_tree_black)) {
-                    __w->_M_color = _S_rb_tree_red;
+                     __w->_M_left->_M_get_color() == _S_rb_tree_black)) {
+                    __w->_M_set_color(_S_rb_tree_red);
                     __x = __x_parent;
                     __x_parent = __x_parent->_M_parent;
                 } else {
                     if (__w->_M_left == 0 ||
-                        __w->_M_left->_M_color == _S_rb_tree_black) {
-                        if (__w->_M_right) __w->_M_right->_M_color = _S_rb_tree_black;
-                        __w->_M_color = _S_rb_tree_red;
-                        _Rb_tree_rotate_left(__w, __root);
+                        __w->_M_left->_M_get_color() == _S_rb_tree_black) {
+                        if (__w->_M_right) __w->_M_right->_M_set_color(_S_rb_tree_black);
+                        __w->_M_set_color(_S_rb_tree_red);
+                        _Rb_tree_rotate_left(__w, __root, __update);
                         __w = __x_parent->_M_left;
                     }
-                    __w->_M_color = __x_parent->_M_color;
-                    __x_parent->_M_color = _S_rb_tree_black;
-                    if (__w->_M_left) __w->_M_left->_M_color = _S_rb_tree_black;
-                    _Rb_tree_rotate_right(__x_parent, __root);
+                    __w->_M_set_color(__x_parent->_M_get_color());
+                    __x_parent->_M_set_color(_S_rb_tree_black);
+                    if (__w->_M_left) __w->_M_left->_M_set_color(_S_rb_tree_black);
+                    _Rb_tree_rotate_right(__x_parent, __root, __update);
                     break;
                 }
             }
-        if (__x) __x->_M_color = _S_rb_tree_black;
+        if (__x) __x->_M_set_color(_S_rb_tree_black);
     }
     return __y;
 }
 
+// Black nodes on a path from __x down to a leaf, __x included.
+inline size_t _Rb_tree_black_height(_Rb_tree_node_base *__x) {
+    size_t __h = 0;
+    for (; __x != 0; __x = __x->_M_left)
+        if (__x->_M_get_color() == _S_rb_tree_black) ++__h;
+    return __h;
+}
+
+// Joins the detached trees __l and __r around the node __k, where every key
+// of __l is before __k and every key of __r after it.  __k goes down the spine
+// of the taller tree to the first black node as high as the other tree, and
+// the insert fixup repairs a red parent on the way back up, so the cost is
+// the difference in height.  Returns the detached root of the result.
+template<class _Update>
+inline _Rb_tree_node_base *
+_Rb_tree_join(_Rb_tree_node_base *__l, _Rb_tree_node_base *__k, _Rb_tree_node_base *__r, _Update __update) {
+    if (__l) __l->_M_set_color(_S_rb_tree_black);
+    if (__r) __r->_M_set_color(_S_rb_tree_black);
+    const size_t __hl = _Rb_tree_black_height(__l);
+    const size_t __hr = _Rb_tree_black_height(__r);
+    _Rb_tree_node_base *__root = __hl >= __hr ? __l : __r;
+    _Rb_tree_node_base *__p = 0;
+    _Rb_tree_node_base *__c = __root;
+    size_t __h = __hl >= __hr ? __hl : __hr;
+    const size_t __target = __hl >= __hr ? __hr : __hl;
+    for (;;) {
+        if (__c == 0 || __c->_M_get_color() == _S_rb_tree_black) {
+            if (__h == __target) break;
+            --__h;
+        }
+        __p = __c;
+        __c = __hl >= __hr ? __c->_M_right : __c->_M_left;
+    }
+    __k->_M_left = __hl >= __hr ? __c : __l;
+    __k->_M_right = __hl >= __hr ? __r : __c;
+    if (__k->_M_left) __k->_M_left->_M_parent = __k;
+    if (__k->_M_right) __k->_M_right->_M_parent = __k;
+    __k->_M_parent = __p;
+    if (__p == 0) {
+        __k->_M_set_color(_S_rb_tree_black);
+        __update(__k);
+        return __k;
+    }
+    if (__hl >= __hr) __p->_M_right = __k;
+    else __p->_M_left = __k;
+    _Rb_tree_rebalance(__k, __root, __update);
+    return __root;
+}
+
+// Takes the last node of the detached tree __t out into __last and returns
+// the rest.
+template<class _Update>
+inline _Rb_tree_node_base *
+_Rb_tree_split_last(_Rb_tree_node_base *__t, _Rb_tree_node_base *&__last, _Update __update) {
+    _Rb_tree_node_base *__l = __t->_M_left;
+    _Rb_tree_node_base *__r = __t->_M_right;
+    if (__l) __l->_M_parent = 0;
+    if (__r == 0) {
+        __last = __t;
+        return __l;
+    }
+    __r->_M_parent = 0;
+    return _Rb_tree_join(__l, __t, _Rb_tree_split_last(__r, __last, __update), __update);
+}
+
+// Joins two detached trees with no node between them.
+template<class _Update>
+inline _Rb_tree_node_base *
+_Rb_tree_join2(_Rb_tree_node_base *__l, _Rb_tree_node_base *__r, _Update __update) {
+    if (__l == 0) return __r;
+    if (__r == 0) return __l;
+    _Rb_tree_node_base *__k = 0;
+    __l = _Rb_tree_split_last(__l, __k, __update);
+    return _Rb_tree_join(__l, __k, __r, __update);
+}
+
 // Base class to encapsulate the differences between old SGI-style
 // allocators and standard-conforming allocators.  In order to avoid
 // having an empty base class, we arbitrarily move one of rb_tree's
@@ -394,7 +713,7 @@ _Rb_tree_rebalance_for_erase(_Rb_tree_node_base *__z,
 #ifdef __STL_USE_STD_ALLOCATORS
 
 // _Base for general standard-conforming allocators.
-template <class _Tp, class _Alloc, bool _S_instanceless>
+template <class _Tp, class _Alloc, bool _S_instanceless, class _Node>
 class _Rb_tree_alloc_base {
 public:
   typedef typename _Alloc_traits<_Tp, _Alloc>::allocator_type allocator_type;
@@ -404,19 +723,21 @@ public:
     : _M_node_allocator(__a), _M_header(0) {}
 
 protected:
-  typename _Alloc_traits<_Rb_tree_node<_Tp>, _Alloc>::allocator_type
+  typename _Alloc_traits<_Node, _Alloc>::allocator_type
            _M_node_allocator;
   _Rb_tree_node<_Tp>* _M_header;
 
-  _Rb_tree_node<_Tp>* _M_get_node()
+  _Node* _M_get_node()
     { return _M_node_allocator.allocate(1); }
   void _M_put_node(_Rb_tree_node<_Tp>* __p)
-    { _M_node_allocator.deallocate(__p, 1); }
+    { _M_node_allocator.deallocate(static_cast<_Node*>(__p), 1); }
+  _Node* _M_get_nodes(int& __n)
+    { __n = 1; return _M_get_node(); }
 };
 
 // Specialization for instanceless allocators.
-template <class _Tp, class _Alloc>
-class _Rb_tree_alloc_base<_Tp, _Alloc, true> {
+template <class _Tp, class _Alloc, class _Node>
+class _Rb_tree_alloc_base<_Tp, _Alloc, true, _Node> {
 public:
   typedef typename _Alloc_traits<_Tp, _Alloc>::allocator_type allocator_type;
   allocator_type get_allocator() const { return allocator_type(); }
@@ -426,22 +747,24 @@ public:
 protected:
   _Rb_tree_node<_Tp>* _M_header;
 
-  typedef typename _Alloc_traits<_Rb_tree_node<_Tp>, _Alloc>::_Alloc_type
+  typedef typename _Alloc_traits<_Node, _Alloc>::_Alloc_type
           _Alloc_type;
 
-  _Rb_tree_node<_Tp>* _M_get_node()
+  _Node* _M_get_node()
     { return _Alloc_type::allocate(1); }
   void _M_put_node(_Rb_tree_node<_Tp>* __p)
-    { _Alloc_type::deallocate(__p, 1); }
+    { _Alloc_type::deallocate(static_cast<_Node*>(__p), 1); }
+  _Node* _M_get_nodes(int& __n)
+    { __n = 1; return _M_get_node(); }
 };
 
-template <class _Tp, class _Alloc>
+template <class _Tp, class _Alloc, class _Node = _Rb_tree_node<_Tp> >
 struct _Rb_tree_base
   : public _Rb_tree_alloc_base<_Tp, _Alloc,
-                               _Alloc_traits<_Tp, _Alloc>::_S_instanceless>
+                               _Alloc_traits<_Tp, _Alloc>::_S_instanceless, _Node>
 {
   typedef _Rb_tree_alloc_base<_Tp, _Alloc,
-                              _Alloc_traits<_Tp, _Alloc>::_S_instanceless>
+                              _Alloc_traits<_Tp, _Alloc>::_S_instanceless, _Node>
           _Base;
   typedef typename _Base::allocator_type allocator_type;
 
@@ -453,7 +776,8 @@ struct _Rb_tree_base
 
 #else /* __STL_USE_STD_ALLOCATORS */
 
-template<class _Tp, class _Alloc>
+// _Node is the node type, an _Rb_tree_node<_Tp> or one derived from it
+template<class _Tp, class _Alloc, class _Node = _Rb_tree_node<_Tp> >
 struct _Rb_tree_base {
     typedef _Alloc allocator_type;
 
@@ -467,22 +791,43 @@ struct _Rb_tree_base {
 protected:
     _Rb_tree_node<_Tp> *_M_header;
 
-    typedef simpleAlloc<_Rb_tree_node<_Tp>, _Alloc> _Alloc_type;
+    typedef simpleAlloc<_Node, _Alloc> _Alloc_type;
+
+    _Node *_M_get_node() { return _Alloc_type::allocate(1); }
 
-    _Rb_tree_node<_Tp> *_M_get_node() { return _Alloc_type::allocate(1); }
+    void _M_put_node(_Rb_tree_node<_Tp> *__p) { _Alloc_type::deallocate(static_cast<_Node *>(__p), 1); }
 
-    void _M_put_node(_Rb_tree_node<_Tp> *__p) { _Alloc_type::deallocate(__p, 1); }
+    // up to __n nodes side by side, __n is set to how many; _M_put_node frees each one
+    _Node *_M_get_nodes(int &__n) { return _Alloc_type::allocate_run(__n); }
 };
 
 #endif /* __STL_USE_STD_ALLOCATORS */
 
+// node_handle operations for _Rb_tree nodes, which the allocator hands out one
+// at a time, so a node may outlive the tree it was extracted from.
+template<class _Value, class _Node, class _Alloc>
+struct _Rb_tree_node_ops {
+    typedef _Value value_type;
+
+    static _Value &value(_Node *__p) { return __p->_M_value_field; }
+
+    static void drop(_Node *__p) {
+        destroy(&__p->_M_value_field);
+        simpleAlloc<_Node, _Alloc>::deallocate(__p, 1);
+    }
+};
+
 template<class _Key, class _Value, class _KeyOfValue, class _Compare,
-        class _Alloc = STL_DEFAULT_ALLOCATOR>
-class _Rb_tree : protected _Rb_tree_base<_Value, _Alloc> {
-    typedef _Rb_tree_base<_Value, _Alloc> _Base;
+        class _Alloc = STL_DEFAULT_ALLOCATOR,
+        class _Augment = _Rb_tree_no_augment>
+class _Rb_tree : protected _Rb_tree_base<_Value, _Alloc,
+        typename _Augment::template _Traits<_Value>::_Node> {
+    typedef typename _Augment::template _Traits<_Value> _Augment_traits;
+    typedef typename _Augment_traits::_Node _Node_type;
+    typedef typename _Augment_traits::_Update _Update;
+    typedef _Rb_tree_base<_Value, _Alloc, _Node_type> _Base;
 protected:
     typedef _Rb_tree_node_base *_Base_ptr;
-    typedef _Rb_tree_node<_Value> _Rb_tree_node;
     typedef _Rb_tree_Color_type _Color_type;
 public:
     typedef _Key key_type;
@@ -491,7 +836,7 @@ public:
     typedef const value_type *const_pointer;
     typedef value_type &reference;
     typedef const value_type &const_reference;
-    typedef _Rb_tree_node *_Link_type;
+    typedef _Rb_tree_node<_Value> *_Link_type;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
 
@@ -503,6 +848,7 @@ protected:
 
     using _Base::_M_get_node;
     using _Base::_M_put_node;
+    using _Base::_M_get_nodes;
     using _Base::_M_header;
 
 
@@ -517,9 +863,20 @@ protected:
         return __tmp;
     }
 
+    template<class... _Args>
+    _Link_type _M_create_node(_Args &&... __args) {
+        _Link_type __tmp = _M_get_node();
+        __STL_TRY {
+            construct(&__tmp->_M_value_field, std::forward<_Args>(__args)...);
+        }
+        __STL_UNWIND(_M_put_node(__tmp));
+        return __tmp;
+    }
+
     _Link_type _M_clone_node(_Link_type __x) {
         _Link_type __tmp = _M_create_node(__x->_M_value_field);
-        __tmp->_M_color = __x->_M_color;
+        __tmp->_M_set_color(__x->_M_get_color());
+        _Update::_S_copy(__tmp, __x);
         __tmp->_M_left = 0;
         __tmp->_M_right = 0;
         return __tmp;
@@ -534,7 +891,9 @@ protected:
     size_type _M_node_count; // keeps track of size of tree
     _Compare _M_key_compare;
 
-    _Link_type &_M_root() const { return (_Link_type &) _M_header->_M_parent; }
+    // by value: the header's parent link may carry the colour bit, so the
+    // root is set through _M_header->_M_parent
+    _Link_type _M_root() const { return (_Link_type) (_Base_ptr) _M_header->_M_parent; }
 
     _Link_type &_M_leftmost() const { return (_Link_type &) _M_header->_M_left; }
 
@@ -544,25 +903,25 @@ protected:
 
     static _Link_type &_S_right(_Link_type __x) { return (_Link_type &) (__x->_M_right); }
 
-    static _Link_type &_S_parent(_Link_type __x) { return (_Link_type &) (__x->_M_parent); }
+    static _Link_type _S_parent(_Link_type __x) { return (_Link_type) (_Base_ptr) __x->_M_parent; }
 
     static reference _S_value(_Link_type __x) { return __x->_M_value_field; }
 
     static const _Key &_S_key(_Link_type __x) { return _KeyOfValue()(_S_value(__x)); }
 
-    static _Color_type &_S_color(_Link_type __x) { return (_Color_type &) (__x->_M_color); }
+    static _Color_type _S_color(_Link_type __x) { return __x->_M_get_color(); }
 
     static _Link_type &_S_left(_Base_ptr __x) { return (_Link_type &) (__x->_M_left); }
 
     static _Link_type &_S_right(_Base_ptr __x) { return (_Link_type &) (__x->_M_right); }
 
-    static _Link_type &_S_parent(_Base_ptr __x) { return (_Link_type &) (__x->_M_parent); }
+    static _Link_type _S_parent(_Base_ptr __x) { return (_Link_type) (_Base_ptr) __x->_M_parent; }
 
     static reference _S_value(_Base_ptr __x) { return ((_Link_type) __x)->_M_value_field; }
 
     static const _Key &_S_key(_Base_ptr __x) { return _KeyOfValue()(_S_value(_Link_type(__x))); }
 
-    static _Color_type &_S_color(_Base_ptr __x) { return (_Color_type &) (_Link_type(__x)->_M_color); }
+    static _Color_type _S_color(_Base_ptr __x) { return __x->_M_get_color(); }
 
     static _Link_type _S_minimum(_Link_type __x) { return (_Link_type) _Rb_tree_node_base::_S_minimum(__x); }
 
@@ -577,10 +936,77 @@ public:
 private:
     iterator _M_insert(_Base_ptr __x, _Base_ptr __y, const value_type &__v);
 
+    iterator _M_insert_node(_Base_ptr __x, _Base_ptr __y, _Link_type __z);
+
+    iterator _M_insert_unique_after(iterator __position, const value_type &__v);
+
+    // where a node with key __k goes, as (__x, __y) for _M_insert_node; for
+    // unique keys __y is null when __x already holds __k.  A key that goes
+    // after _M_rightmost() costs one comparison instead of a descent, so
+    // ingesting keys in order through plain insert is amortized O(1) apart
+    // from the allocation.
+    std::pair<_Base_ptr, _Base_ptr> _M_get_insert_unique_pos(const key_type &__k);
+
+    std::pair<_Base_ptr, _Base_ptr> _M_get_insert_equal_pos(const key_type &__k);
+
+    // takes the node out of the tree without destroying it
+    _Link_type _M_unlink(iterator __position) {
+        _Base_ptr __root = _M_root();
+        _Link_type __y = (_Link_type) _Rb_tree_rebalance_for_erase(__position._M_node,
+                                                                   __root,
+                                                                   _M_header->_M_left,
+                                                                   _M_header->_M_right,
+                                                                   _Update());
+        _M_header->_M_parent = __root;
+        --_M_node_count;
+        return __y;
+    }
+
     _Link_type _M_copy(_Link_type __x, _Link_type __p);
 
     void _M_erase(_Link_type __x);
 
+    template<class _II>
+    void _M_insert_range(_II __first, _II __last, bool __unique);
+
+    _Link_type _M_build_balanced(_Link_type &__list, size_type __n, size_type __depth, size_type __red_depth);
+
+    enum _Set_op {
+        _S_union, _S_intersection, _S_difference
+    };
+
+    // Subtrees a set operation drops, linked through their roots' _M_parent.
+    // They are freed after the threads are done, the node allocator is not
+    // thread safe.
+    struct _Dropped {
+        _Base_ptr _M_first;
+        _Base_ptr _M_last;
+
+        _Dropped() : _M_first(0), _M_last(0) {}
+
+        void _M_push(_Base_ptr __x) {
+            __x->_M_parent = 0;
+            if (_M_last) _M_last->_M_parent = __x;
+            else _M_first = __x;
+            _M_last = __x;
+        }
+
+        void _M_splice(_Dropped &__d) {
+            if (__d._M_first == 0) return;
+            if (_M_last) _M_last->_M_parent = __d._M_first;
+            else _M_first = __d._M_first;
+            _M_last = __d._M_last;
+        }
+    };
+
+    void _M_split(_Link_type __t, const key_type &__k, _Link_type &__l, _Link_type &__m, _Link_type &__r);
+
+    _Link_type _M_combine(_Link_type __a, _Link_type __b, _Set_op __op, _Dropped &__d, unsigned __forks);
+
+    void _M_set_operation(_Rb_tree &__x, _Set_op __op, unsigned __threads);
+
+    size_type _M_erase_counted(_Link_type __x);
+
 public:
     // allocation/deallocation
     _Rb_tree()
@@ -592,14 +1018,14 @@ public:
     _Rb_tree(const _Compare &__comp, const allocator_type &__a)
             : _Base(__a), _M_node_count(0), _M_key_compare(__comp) { _M_empty_initialize(); }
 
-    _Rb_tree(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__x)
+    _Rb_tree(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__x)
             : _Base(__x.get_allocator()),
               _M_node_count(0), _M_key_compare(__x._M_key_compare) {
         if (__x._M_root() == 0)
             _M_empty_initialize();
         else {
-            _S_color(_M_header) = _S_rb_tree_red;
-            _M_root() = _M_copy(__x._M_root(), _M_header);
+            _M_header->_M_set_color(_S_rb_tree_red);
+            _M_header->_M_parent = _M_copy(__x._M_root(), _M_header);
             _M_leftmost() = _S_minimum(_M_root());
             _M_rightmost() = _S_maximum(_M_root());
         }
@@ -608,14 +1034,14 @@ public:
 
     ~_Rb_tree() { clear(); }
 
-    _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &
-    operator=(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__x);
+    _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &
+    operator=(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__x);
 
 private:
     void _M_empty_initialize() {
-        _S_color(_M_header) = _S_rb_tree_red; // used to distinguish header from
+        _M_header->_M_set_color(_S_rb_tree_red); // used to distinguish header from
         // __root, in iterator.operator++
-        _M_root() = 0;
+        _M_header->_M_parent = 0;
         _M_leftmost() = _M_header;
         _M_rightmost() = _M_header;
     }
@@ -638,7 +1064,7 @@ public:
 
     size_type max_size() const { return size_type(-1); }
 
-    void swap(_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__t) {
+    void swap(_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__t) {
         std::swap(_M_header, __t._M_header);
         std::swap(_M_node_count, __t._M_node_count);
         std::swap(_M_key_compare, __t._M_key_compare);
@@ -654,6 +1080,11 @@ public:
 
     iterator insert_equal(iterator __position, const value_type &__x);
 
+    // Looks __k up first; the node is only constructed from __args when
+    // __k is not already in the tree.
+    template<class... _Args>
+    std::pair<iterator, bool> try_emplace_unique(const key_type &__k, _Args &&... __args);
+
 #ifdef __STL_MEMBER_TEMPLATES
     template <class _InputIterator>
   void insert_unique(_InputIterator __first, _InputIterator __last);
@@ -671,6 +1102,31 @@ public:
 
 #endif /* __STL_MEMBER_TEMPLATES */
 
+    // Node handles.  extract() unlinks an element and hands over its node,
+    // insert_unique and insert_equal link such a node back, into this tree or
+    // another one of the same type, and merge_unique and merge_equal move
+    // every node of __src that fits, leaving the rest there.  No element is
+    // allocated, copied or destroyed on the way.
+    typedef node_handle<_Node_type, _Rb_tree_node_ops<_Value, _Node_type, _Alloc> > node_type;
+    typedef node_insert_return<iterator, node_type> insert_return_type;
+
+    node_type extract(iterator __position) {
+        return node_type(static_cast<_Node_type *>(_M_unlink(__position)));
+    }
+
+    node_type extract(const key_type &__k) {
+        iterator __i = find(__k);
+        return __i == end() ? node_type() : extract(__i);
+    }
+
+    insert_return_type insert_unique(node_type &&__nh);
+
+    iterator insert_equal(node_type &&__nh);
+
+    void merge_unique(_Rb_tree &__src);
+
+    void merge_equal(_Rb_tree &__src);
+
     void erase(iterator __position);
 
     size_type erase(const key_type &__x);
@@ -679,11 +1135,26 @@ public:
 
     void erase(const key_type *__first, const key_type *__last);
 
+    // Join-based set operations for trees of unique keys.  __x is split at
+    // each key of this tree in O(log n) and the halves are combined on up to
+    // __threads threads, all cores by default; no sequence is built on the way.
+    // The nodes of __x end up in this tree or freed, and __x is left empty.
+    // Where both trees hold a key, this tree's element stays.  _Compare must
+    // not throw: both trees are already taken apart when it runs, so a throw
+    // would leave them empty and lose every node, and a throw on one of the
+    // worker threads calls std::terminate.  A thread that cannot be started
+    // is not an error; its half of the work is done on the calling thread.
+    void unite(_Rb_tree &__x, unsigned __threads = 0) { _M_set_operation(__x, _S_union, __threads); }
+
+    void intersect(_Rb_tree &__x, unsigned __threads = 0) { _M_set_operation(__x, _S_intersection, __threads); }
+
+    void subtract(_Rb_tree &__x, unsigned __threads = 0) { _M_set_operation(__x, _S_difference, __threads); }
+
     void clear() {
         if (_M_node_count != 0) {
             _M_erase(_M_root());
             _M_leftmost() = _M_header;
-            _M_root() = 0;
+            _M_header->_M_parent = 0;
             _M_rightmost() = _M_header;
             _M_node_count = 0;
         }
@@ -709,25 +1180,248 @@ public:
 
     std::pair<const_iterator, const_iterator> equal_range(const key_type &__x) const;
 
+    // Heterogeneous lookup.  These overloads take part only when _Compare
+    // declares is_transparent (e.g. std::less<>), so that a key can be
+    // looked up without first being converted to key_type.
+    template<class _Kt, class _Result>
+    struct _If_transparent
+            : public std::enable_if<_Is_transparent<_Compare>::value &&
+                                    !std::is_convertible<_Kt, iterator>::value &&
+                                    !std::is_convertible<_Kt, const_iterator>::value, _Result> {
+    };
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, iterator>::type find(const _Kt &__k) {
+        return iterator(_M_find_tr(__k));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, const_iterator>::type find(const _Kt &__k) const {
+        return const_iterator(_M_find_tr(__k));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, size_type>::type count(const _Kt &__k) const {
+        _Link_type __last = _M_upper_bound_tr(__k);
+        size_type __n = 0;
+        for (const_iterator __it(_M_lower_bound_tr(__k)); __it._M_node != __last; ++__it)
+            ++__n;
+        return __n;
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, iterator>::type lower_bound(const _Kt &__k) {
+        return iterator(_M_lower_bound_tr(__k));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, const_iterator>::type lower_bound(const _Kt &__k) const {
+        return const_iterator(_M_lower_bound_tr(__k));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, iterator>::type upper_bound(const _Kt &__k) {
+        return iterator(_M_upper_bound_tr(__k));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, const_iterator>::type upper_bound(const _Kt &__k) const {
+        return const_iterator(_M_upper_bound_tr(__k));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, std::pair<iterator, iterator> >::type equal_range(const _Kt &__k) {
+        return std::pair<iterator, iterator>(iterator(_M_lower_bound_tr(__k)),
+                                             iterator(_M_upper_bound_tr(__k)));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, std::pair<const_iterator, const_iterator> >::type
+    equal_range(const _Kt &__k) const {
+        return std::pair<const_iterator, const_iterator>(const_iterator(_M_lower_bound_tr(__k)),
+                                                         const_iterator(_M_upper_bound_tr(__k)));
+    }
+
+    template<class _Kt>
+    typename _If_transparent<_Kt, size_type>::type erase(const _Kt &__k) {
+        size_type __n = count(__k);
+        erase(iterator(_M_lower_bound_tr(__k)), iterator(_M_upper_bound_tr(__k)));
+        return __n;
+    }
+
+private:
+    template<class _Kt>
+    _Link_type _M_lower_bound_tr(const _Kt &__k) const {
+        _Link_type __y = _M_header; /* Last node which is not less than __k. */
+        _Link_type __x = _M_root(); /* Current node. */
+
+        while (__x != 0)
+            if (!_M_key_compare(_S_key(__x), __k))
+                __y = __x, __x = _S_left(__x);
+            else
+                __x = _S_right(__x);
+
+        return __y;
+    }
+
+    template<class _Kt>
+    _Link_type _M_upper_bound_tr(const _Kt &__k) const {
+        _Link_type __y = _M_header; /* Last node which is greater than __k. */
+        _Link_type __x = _M_root(); /* Current node. */
+
+        while (__x != 0)
+            if (_M_key_compare(__k, _S_key(__x)))
+                __y = __x, __x = _S_left(__x);
+            else
+                __x = _S_right(__x);
+
+        return __y;
+    }
+
+    template<class _Kt>
+    _Link_type _M_find_tr(const _Kt &__k) const {
+        _Link_type __j = _M_lower_bound_tr(__k);
+        return (__j == _M_header || _M_key_compare(__k, _S_key(__j))) ? _M_header : __j;
+    }
+
+    static size_type _S_count(_Base_ptr __x) { return _Augment_traits::_S_count(__x); }
+
+    _Link_type _M_select(size_type __k) const;
+
+public:
+    // Order statistics in O(log n), for trees whose augmentation counts the
+    // nodes of each subtree, such as rb_tree_order_statistics.  select(__k)
+    // is the element with __k elements before it, or end(); rank(__x) is the
+    // number of keys less than __x; index_of(__it) is the number of elements
+    // before __it, size() for end().
+    iterator select(size_type __k) { return iterator(_M_select(__k)); }
+
+    const_iterator select(size_type __k) const { return const_iterator(_M_select(__k)); }
+
+    size_type rank(const key_type &__x) const;
+
+    size_type index_of(const_iterator __it) const;
+
+    typedef typename _Augment_traits::_Aggregate aggregate_type;
+
+    // The aggregate of the whole tree and of the keys in [__lo, __hi), in
+    // O(1) and O(log n), for trees whose augmentation provides one, such as
+    // rb_tree_aggregate<rb_tree_sum<int> >.  With rb_tree_order_statistics
+    // it is the number of elements.
+    aggregate_type aggregate() const { return _Augment_traits::_S_aggregate(_M_root()); }
+
+    aggregate_type range_aggregate(const key_type &__lo, const key_type &__hi) const;
+
+    // Recomputes the summaries above __it after its value was changed in
+    // place, such as the mapped value of a map element.
+    void refresh(const_iterator __it) { _Rb_tree_update_path(__it._M_node, _M_header, _Update()); }
+
 public:
     // Debugging.
     bool __rb_verify() const;
 };
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::_Link_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::_M_select(size_type __k) const {
+    _Link_type __x = _M_root();
+    while (__x != 0) {
+        const size_type __left = _S_count(__x->_M_left);
+        if (__k < __left)
+            __x = _S_left(__x);
+        else if (__k == __left)
+            return __x;
+        else {
+            __k -= __left + 1;
+            __x = _S_right(__x);
+        }
+    }
+    return _M_header;
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::size_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::rank(const key_type &__k) const {
+    size_type __r = 0;
+    _Link_type __x = _M_root();
+    while (__x != 0)
+        if (_M_key_compare(_S_key(__x), __k)) {
+            __r += _S_count(__x->_M_left) + 1;
+            __x = _S_right(__x);
+        } else
+            __x = _S_left(__x);
+    return __r;
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::size_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::index_of(const_iterator __it) const {
+    _Base_ptr __x = __it._M_node;
+    if (__x == _M_header) return _M_node_count;
+    size_type __r = _S_count(__x->_M_left);
+    for (; __x != _M_root(); __x = __x->_M_parent)
+        if (__x == __x->_M_parent->_M_right)
+            __r += _S_count(__x->_M_parent->_M_left) + 1;
+    return __r;
+}
+
+// Descends to the highest node inside [__lo, __hi), then down each side of
+// it: on the left every node not below __lo brings itself and its right
+// subtree, on the right every node below __hi brings its left subtree and
+// itself.  Only O(log n) whole-subtree summaries are combined, in key order.
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::aggregate_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::range_aggregate(const key_type &__lo, const key_type &__hi) const {
+    typedef _Augment_traits _Tr;
+    _Link_type __x = _M_root();
+    while (__x != 0)
+        if (_M_key_compare(_S_key(__x), __lo))
+            __x = _S_right(__x);
+        else if (!_M_key_compare(_S_key(__x), __hi))
+            __x = _S_left(__x);
+        else
+            break;
+    if (__x == 0) return _Tr::_S_identity();
+
+    aggregate_type __left = _Tr::_S_identity();
+    for (_Link_type __y = _S_left(__x); __y != 0;)
+        if (_M_key_compare(_S_key(__y), __lo))
+            __y = _S_right(__y);
+        else {
+            __left = _Tr::_S_combine(_Tr::_S_combine(_Tr::_S_lift(__y), _Tr::_S_aggregate(__y->_M_right)), __left);
+            __y = _S_left(__y);
+        }
+
+    aggregate_type __right = _Tr::_S_identity();
+    for (_Link_type __y = _S_right(__x); __y != 0;)
+        if (_M_key_compare(_S_key(__y), __hi)) {
+            __right = _Tr::_S_combine(__right, _Tr::_S_combine(_Tr::_S_aggregate(__y->_M_left), _Tr::_S_lift(__y)));
+            __y = _S_right(__y);
+        } else
+            __y = _S_left(__y);
+
+    return _Tr::_S_combine(_Tr::_S_combine(__left, _Tr::_S_lift(__x)), __right);
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
 inline bool
-operator==(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__x,
-           const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__y) {
+operator==(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__x,
+           const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__y) {
     return __x.size() == __y.size() &&
            equal(__x.begin(), __x.end(), __y.begin());
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
+        class _Compare, class _Alloc, class _Augment>
 inline bool
-operator<(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__x,
-          const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__y) {
+operator<(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__x,
+          const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__y) {
     return lexicographical_compare(__x.begin(), __x.end(),
                                    __y.begin(), __y.end());
 }
@@ -735,43 +1429,43 @@ operator<(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__x,
 #ifdef __STL_FUNCTION_TMPL_PARTIAL_ORDER
 
 template <class _Key, class _Value, class _KeyOfValue,
-          class _Compare, class _Alloc>
+          class _Compare, class _Alloc, class _Augment>
 inline bool
-operator!=(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x,
-           const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __y) {
+operator!=(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __x,
+           const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __y) {
   return !(__x == __y);
 }
 
 template <class _Key, class _Value, class _KeyOfValue,
-          class _Compare, class _Alloc>
+          class _Compare, class _Alloc, class _Augment>
 inline bool
-operator>(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x,
-          const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __y) {
+operator>(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __x,
+          const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __y) {
   return __y < __x;
 }
 
 template <class _Key, class _Value, class _KeyOfValue,
-          class _Compare, class _Alloc>
+          class _Compare, class _Alloc, class _Augment>
 inline bool
-operator<=(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x,
-           const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __y) {
+operator<=(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __x,
+           const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __y) {
   return !(__y < __x);
 }
 
 template <class _Key, class _Value, class _KeyOfValue,
-          class _Compare, class _Alloc>
+          class _Compare, class _Alloc, class _Augment>
 inline bool
-operator>=(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x,
-           const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __y) {
+operator>=(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __x,
+           const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __y) {
   return !(__x < __y);
 }
 
 
 template <class _Key, class _Value, class _KeyOfValue,
-          class _Compare, class _Alloc>
+          class _Compare, class _Alloc, class _Augment>
 inline void
-swap(_Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x,
-     _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __y)
+swap(_Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __x,
+     _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc, _Augment>& __y)
 {
   __x.swap(__y);
 }
@@ -780,21 +1474,21 @@ swap(_Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x,
 
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
-::operator=(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> &__x) {
+        class _Compare, class _Alloc, class _Augment>
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::operator=(const _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> &__x) {
     if (this != &__x) {
         // Note that _Key may be a constant type.
         clear();
         _M_node_count = 0;
         _M_key_compare = __x._M_key_compare;
         if (__x._M_root() == 0) {
-            _M_root() = 0;
+            _M_header->_M_parent = 0;
             _M_leftmost() = _M_header;
             _M_rightmost() = _M_header;
         } else {
-            _M_root() = _M_copy(__x._M_root(), _M_header);
+            _M_header->_M_parent = _M_copy(__x._M_root(), _M_header);
             _M_leftmost() = _S_minimum(_M_root());
             _M_rightmost() = _S_maximum(_M_root());
             _M_node_count = __x._M_node_count;
@@ -804,90 +1498,95 @@ _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::_M_insert(_Base_ptr __x_, _Base_ptr __y_, const _Value &__v) {
+    return _M_insert_node(__x_, __y_, _M_create_node(__v));
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_insert_node(_Base_ptr __x_, _Base_ptr __y_, _Link_type __z) {
+    // links an already constructed node below __y_
     _Link_type __x = (_Link_type) __x_;
     _Link_type __y = (_Link_type) __y_;
-    _Link_type __z;
 
     if (__y == _M_header || __x != 0 ||
-        _M_key_compare(_KeyOfValue()(__v), _S_key(__y))) {
-        __z = _M_create_node(__v);
+        _M_key_compare(_S_key(__z), _S_key(__y))) {
         _S_left(__y) = __z;               // also makes _M_leftmost() = __z
         //    when __y == _M_header
         if (__y == _M_header) {
-            _M_root() = __z;
+            _M_header->_M_parent = __z;
             _M_rightmost() = __z;
         } else if (__y == _M_leftmost())
             _M_leftmost() = __z;   // maintain _M_leftmost() pointing to min node
     } else {
-        __z = _M_create_node(__v);
         _S_right(__y) = __z;
         if (__y == _M_rightmost())
             _M_rightmost() = __z;  // maintain _M_rightmost() pointing to max node
     }
-    _S_parent(__z) = __y;
+    __z->_M_parent = __y;
     _S_left(__z) = 0;
     _S_right(__z) = 0;
-    _Rb_tree_rebalance(__z, _M_header->_M_parent);
+    _Base_ptr __root = _M_root();
+    _Rb_tree_rebalance(__z, __root, _Update());
+    _M_header->_M_parent = __root;
     ++_M_node_count;
     return iterator(__z);
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::insert_equal(const _Value &__v) {
-    _Link_type __y = _M_header;
-    _Link_type __x = _M_root();
-    while (__x != 0) {
-        __y = __x;
-        __x = _M_key_compare(_KeyOfValue()(__v), _S_key(__x)) ?
-              _S_left(__x) : _S_right(__x);
-    }
-    return _M_insert(__x, __y, __v);
+    std::pair<_Base_ptr, _Base_ptr> __pos = _M_get_insert_equal_pos(_KeyOfValue()(__v));
+    return _M_insert(__pos.first, __pos.second, __v);
 }
 
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-std::pair<typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator,
+        class _Compare, class _Alloc, class _Augment>
+std::pair<typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator,
         bool>
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::insert_unique(const _Value &__v) {
-    _Link_type __y = _M_header;
-    _Link_type __x = _M_root();
-    bool __comp = true;
-    while (__x != 0) {
-        __y = __x;
-        __comp = _M_key_compare(_KeyOfValue()(__v), _S_key(__x));
-        __x = __comp ? _S_left(__x) : _S_right(__x);
-    }
-    iterator __j = iterator(__y);
-    if (__comp)
-        if (__j == begin())
-            return pair<iterator, bool>(_M_insert(__x, __y, __v), true);
-        else
-            --__j;
-    if (_M_key_compare(_S_key(__j._M_node), _KeyOfValue()(__v)))
-        return pair<iterator, bool>(_M_insert(__x, __y, __v), true);
-    return pair<iterator, bool>(__j, false);
+    std::pair<_Base_ptr, _Base_ptr> __pos = _M_get_insert_unique_pos(_KeyOfValue()(__v));
+    if (__pos.second)
+        return std::pair<iterator, bool>(_M_insert(__pos.first, __pos.second, __v), true);
+    return std::pair<iterator, bool>(iterator((_Link_type) __pos.first), false);
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+template<class... _Args>
+std::pair<typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator,
+        bool>
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::try_emplace_unique(const _Key &__k, _Args &&... __args) {
+    std::pair<_Base_ptr, _Base_ptr> __pos = _M_get_insert_unique_pos(__k);
+    if (__pos.second)
+        return std::pair<iterator, bool>(
+                _M_insert_node(__pos.first, __pos.second, _M_create_node(std::forward<_Args>(__args)...)), true);
+    return std::pair<iterator, bool>(iterator((_Link_type) __pos.first), false);
 }
 
 
 template<class _Key, class _Val, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc>::iterator
-_Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::insert_unique(iterator __position, const _Val &__v) {
     if (__position._M_node == _M_header->_M_left) { // begin()
         if (size() > 0 &&
             _M_key_compare(_KeyOfValue()(__v), _S_key(__position._M_node)))
             return _M_insert(__position._M_node, __position._M_node, __v);
             // first argument just needs to be non-null
+        else if (size() > 0)
+            return _M_insert_unique_after(__position, __v);
         else
             return insert_unique(__v).first;
     } else if (__position._M_node == _M_header) { // end()
@@ -895,6 +1594,11 @@ _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc>
             return _M_insert(0, _M_rightmost(), __v);
         else
             return insert_unique(__v).first;
+    } else if (__position._M_node == _M_rightmost()
+               && _M_key_compare(_S_key(__position._M_node), _KeyOfValue()(__v))) {
+        // past the last element, without the climb to the header that
+        // ++__position would take
+        return _M_insert(0, __position._M_node, __v);
     } else {
         iterator __before = __position;
         --__before;
@@ -906,14 +1610,34 @@ _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc>
                 return _M_insert(__position._M_node, __position._M_node, __v);
             // first argument just needs to be non-null
         } else
-            return insert_unique(__v).first;
+            return _M_insert_unique_after(__position, __v);
     }
 }
 
+// The hint may also be the element just before __v, such as the iterator
+// returned by the previous insert of an ascending run.
 template<class _Key, class _Val, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc>::iterator
-_Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_insert_unique_after(iterator __position, const _Val &__v) {
+    iterator __after = __position;
+    ++__after;
+    if (_M_key_compare(_S_key(__position._M_node), _KeyOfValue()(__v))
+        && (__after._M_node == _M_header || _M_key_compare(_KeyOfValue()(__v), _S_key(__after._M_node)))) {
+        if (_S_right(__position._M_node) == 0)
+            return _M_insert(0, __position._M_node, __v);
+        else
+            return _M_insert(__after._M_node, __after._M_node, __v);
+        // first argument just needs to be non-null
+    }
+    return insert_unique(__v).first;
+}
+
+template<class _Key, class _Val, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::insert_equal(iterator __position, const _Val &__v) {
     if (__position._M_node == _M_header->_M_left) { // begin()
         if (size() > 0 &&
@@ -942,87 +1666,263 @@ _Rb_tree<_Key, _Val, _KeyOfValue, _Compare, _Alloc>
     }
 }
 
+// Sorted input into an empty tree is built in O(n): the nodes are created
+// in order, from runs of adjacent memory, and threaded through _M_right
+// into a list that _M_build_balanced then hangs up as a balanced tree.
+// The first element out of order, and everything after it, is inserted
+// one at a time, as is any range going into a tree that is not empty.
+template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
+template<class _II>
+void _Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc, _Augment>
+::_M_insert_range(_II __first, _II __last, bool __unique) {
+    if (_M_node_count == 0 && __first != __last) {
+        _Link_type __head = 0;
+        _Link_type __tail = 0;
+        size_type __n = 0;
+        _Node_type *__run = 0;
+        int __run_left = 0;
+        int __run_size = 8;
+        __STL_TRY {
+            for (; __first != __last; ++__first) {
+                if (__tail != 0) {
+                    if (_M_key_compare(_KoV()(*__first), _S_key(__tail)))
+                        break;
+                    if (__unique && !_M_key_compare(_S_key(__tail), _KoV()(*__first)))
+                        continue;
+                }
+                if (__run_left == 0) {
+                    int __got = __run_size;
+                    __run = _M_get_nodes(__got);
+                    __run_left = __got;
+                    if (__run_size < 1024) __run_size *= 2;
+                }
+                construct(&__run->_M_value_field, *__first);
+                __run->_M_right = 0;
+                if (__tail != 0) __tail->_M_right = __run;
+                else __head = __run;
+                __tail = __run;
+                ++__n;
+                ++__run;
+                --__run_left;
+            }
+        }
+        __STL_UNWIND(for (; __run_left > 0; --__run_left) _M_put_node(__run++);
+                     while (__head != 0) {
+                         _Link_type __next = _S_right(__head);
+                         destroy_node(__head);
+                         __head = __next;
+                     });
+        for (; __run_left > 0; --__run_left)
+            _M_put_node(__run++);
+
+        // the deepest level of a tree split evenly at every node is red,
+        // so every path to a leaf passes the same number of black nodes
+        size_type __depth = 0;
+        while ((__n >> (__depth + 1)) != 0) ++__depth;
+        _Link_type __list = __head;
+        _M_header->_M_parent = _M_build_balanced(__list, __n, 0, __depth);
+        _M_root()->_M_parent = _M_header;
+        _M_leftmost() = __head;
+        _M_rightmost() = __tail;
+        _M_node_count = __n;
+    }
+    // a hint at end() makes a sorted tail cheap to add
+    for (; __first != __last; ++__first)
+        if (__unique) insert_unique(end(), *__first);
+        else insert_equal(end(), *__first);
+}
+
+template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc, _Augment>::_Link_type
+_Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc, _Augment>
+::_M_build_balanced(_Link_type &__list, size_type __n, size_type __depth, size_type __red_depth) {
+    if (__n == 0) return 0;
+    _Link_type __left = _M_build_balanced(__list, (__n - 1) / 2, __depth + 1, __red_depth);
+    _Link_type __x = __list;
+    __list = _S_right(__list);
+    __x->_M_left = __left;
+    if (__left != 0) __left->_M_parent = __x;
+    __x->_M_set_color((__depth == __red_depth && __depth != 0) ? _S_rb_tree_red : _S_rb_tree_black);
+    _Link_type __right = _M_build_balanced(__list, __n - 1 - (__n - 1) / 2, __depth + 1, __red_depth);
+    __x->_M_right = __right;
+    if (__right != 0) __right->_M_parent = __x;
+    _Update()(__x);
+    return __x;
+}
+
 #ifdef __STL_MEMBER_TEMPLATES
 
-template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
+template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
   template<class _II>
-void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc>
+void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc, _Augment>
   ::insert_equal(_II __first, _II __last)
 {
-  for ( ; __first != __last; ++__first)
-    insert_equal(*__first);
+  _M_insert_range(__first, __last, false);
 }
 
-template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
+template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
   template<class _II>
-void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc>
+void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc, _Augment>
   ::insert_unique(_II __first, _II __last) {
-  for ( ; __first != __last; ++__first)
-    insert_unique(*__first);
+  _M_insert_range(__first, __last, true);
 }
 
 #else /* __STL_MEMBER_TEMPLATES */
 
-template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
+template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
 void
-_Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc>
+_Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc, _Augment>
 ::insert_equal(const _Val *__first, const _Val *__last) {
-    for (; __first != __last; ++__first)
-        insert_equal(*__first);
+    _M_insert_range(__first, __last, false);
 }
 
-template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
+template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
 void
-_Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc>
+_Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc, _Augment>
 ::insert_equal(const_iterator __first, const_iterator __last) {
-    for (; __first != __last; ++__first)
-        insert_equal(*__first);
+    _M_insert_range(__first, __last, false);
 }
 
-template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
+template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
 void
-_Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc>
+_Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc, _Augment>
 ::insert_unique(const _Val *__first, const _Val *__last) {
-    for (; __first != __last; ++__first)
-        insert_unique(*__first);
+    _M_insert_range(__first, __last, true);
 }
 
-template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
-void _Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc>
+template<class _Key, class _Val, class _KoV, class _Cmp, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Val, _KoV, _Cmp, _Alloc, _Augment>
 ::insert_unique(const_iterator __first, const_iterator __last) {
-    for (; __first != __last; ++__first)
-        insert_unique(*__first);
+    _M_insert_range(__first, __last, true);
 }
 
 #endif /* __STL_MEMBER_TEMPLATES */
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-inline void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+inline void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::erase(iterator __position) {
-    _Link_type __y =
-            (_Link_type) _Rb_tree_rebalance_for_erase(__position._M_node,
-                                                      _M_header->_M_parent,
-                                                      _M_header->_M_left,
-                                                      _M_header->_M_right);
-    destroy_node(__y);
-    --_M_node_count;
+    destroy_node(_M_unlink(__position));
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+std::pair<_Rb_tree_node_base *, _Rb_tree_node_base *>
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_get_insert_unique_pos(const key_type &__k) {
+    typedef std::pair<_Base_ptr, _Base_ptr> _Res;
+    // appending in key order skips the descent
+    if (_M_node_count != 0 && _M_key_compare(_S_key(_M_rightmost()), __k))
+        return _Res(0, _M_rightmost());
+    _Link_type __y = _M_header;
+    _Link_type __x = _M_root();
+    bool __comp = true;
+    while (__x != 0) {
+        __y = __x;
+        __comp = _M_key_compare(__k, _S_key(__x));
+        __x = __comp ? _S_left(__x) : _S_right(__x);
+    }
+    iterator __j = iterator(__y);
+    if (__comp) {
+        if (__j == begin())
+            return _Res(__x, __y);
+        else
+            --__j;
+    }
+    if (_M_key_compare(_S_key(__j._M_node), __k))
+        return _Res(__x, __y);
+    return _Res(__j._M_node, 0);
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+std::pair<_Rb_tree_node_base *, _Rb_tree_node_base *>
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_get_insert_equal_pos(const key_type &__k) {
+    if (_M_node_count != 0 && !_M_key_compare(__k, _S_key(_M_rightmost())))
+        return std::pair<_Base_ptr, _Base_ptr>(0, _M_rightmost());
+    _Link_type __y = _M_header;
+    _Link_type __x = _M_root();
+    while (__x != 0) {
+        __y = __x;
+        __x = _M_key_compare(__k, _S_key(__x)) ? _S_left(__x) : _S_right(__x);
+    }
+    return std::pair<_Base_ptr, _Base_ptr>(__x, __y);
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::insert_return_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::insert_unique(node_type &&__nh) {
+    insert_return_type __r = {end(), false, node_type()};
+    if (__nh.empty()) return __r;
+    std::pair<_Base_ptr, _Base_ptr> __pos = _M_get_insert_unique_pos(_KeyOfValue()(__nh.value()));
+    if (__pos.second) {
+        __r.position = _M_insert_node(__pos.first, __pos.second, __nh.release());
+        __r.inserted = true;
+    } else {
+        __r.position = iterator((_Link_type) __pos.first);
+        __r.node = std::move(__nh);
+    }
+    return __r;
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::insert_equal(node_type &&__nh) {
+    if (__nh.empty()) return end();
+    std::pair<_Base_ptr, _Base_ptr> __pos = _M_get_insert_equal_pos(_KeyOfValue()(__nh.value()));
+    return _M_insert_node(__pos.first, __pos.second, __nh.release());
+}
+
+// Unlinking a node leaves every other node where it is, so __next stays valid.
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::merge_unique(_Rb_tree &__src) {
+    if (&__src == this) return;
+    for (iterator __i = __src.begin(); __i != __src.end();) {
+        iterator __next = __i;
+        ++__next;
+        std::pair<_Base_ptr, _Base_ptr> __pos = _M_get_insert_unique_pos(_S_key(__i._M_node));
+        if (__pos.second)
+            _M_insert_node(__pos.first, __pos.second, __src._M_unlink(__i));
+        __i = __next;
+    }
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::merge_equal(_Rb_tree &__src) {
+    if (&__src == this) return;
+    for (iterator __i = __src.begin(); __i != __src.end();) {
+        iterator __next = __i;
+        ++__next;
+        std::pair<_Base_ptr, _Base_ptr> __pos = _M_get_insert_equal_pos(_S_key(__i._M_node));
+        _M_insert_node(__pos.first, __pos.second, __src._M_unlink(__i));
+        __i = __next;
+    }
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::size_type
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::erase(const _Key &__x) {
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::size_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::erase(const _Key &__x) {
     std::pair<iterator, iterator> __p = equal_range(__x);
     size_type __n = 0;
-    distance(__p.first, __p.second, __n);
+    for (iterator __it = __p.first; __it != __p.second; ++__it)
+        ++__n;
     erase(__p.first, __p.second);
     return __n;
 }
 
-template<class _Key, class _Val, class _KoV, class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Val, _KoV, _Compare, _Alloc>::_Link_type
-_Rb_tree<_Key, _Val, _KoV, _Compare, _Alloc>
+template<class _Key, class _Val, class _KoV, class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Val, _KoV, _Compare, _Alloc, _Augment>::_Link_type
+_Rb_tree<_Key, _Val, _KoV, _Compare, _Alloc, _Augment>
 ::_M_copy(_Link_type __x, _Link_type __p) {
     // structural copy.  __x and __p must be non-null.
     _Link_type __top = _M_clone_node(__x);
@@ -1050,8 +1950,144 @@ _Rb_tree<_Key, _Val, _KoV, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_split(_Link_type __t, const key_type &__k, _Link_type &__l, _Link_type &__m, _Link_type &__r) {
+    if (__t == 0) {
+        __l = __m = __r = 0;
+        return;
+    }
+    _Link_type __tl = _S_left(__t);
+    _Link_type __tr = _S_right(__t);
+    if (__tl) __tl->_M_parent = 0;
+    if (__tr) __tr->_M_parent = 0;
+    if (_M_key_compare(__k, _S_key(__t))) {
+        _M_split(__tl, __k, __l, __m, __r);
+        __r = (_Link_type) _Rb_tree_join(__r, __t, __tr, _Update());
+    } else if (_M_key_compare(_S_key(__t), __k)) {
+        _M_split(__tr, __k, __l, __m, __r);
+        __l = (_Link_type) _Rb_tree_join(__tl, __t, __l, _Update());
+    } else {
+        __l = __tl;
+        __r = __tr;
+        __m = __t;
+        __t->_M_left = __t->_M_right = 0;
+    }
+}
+
+// __b is split at the root key of __a, the halves are combined with the
+// subtrees of __a, on a thread of their own while __forks allows, and joined
+// back around the root of __a when the operation keeps it.
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::_Link_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_combine(_Link_type __a, _Link_type __b, _Set_op __op, _Dropped &__d, unsigned __forks) {
+    if (__a == 0) {
+        if (__op == _S_union) return __b;
+        if (__b) __d._M_push(__b);
+        return 0;
+    }
+    if (__b == 0) {
+        if (__op != _S_intersection) return __a;
+        __d._M_push(__a);
+        return 0;
+    }
+    _Link_type __al = _S_left(__a);
+    _Link_type __ar = _S_right(__a);
+    if (__al) __al->_M_parent = 0;
+    if (__ar) __ar->_M_parent = 0;
+    _Link_type __bl, __m, __br;
+    _M_split(__b, _S_key(__a), __bl, __m, __br);
+
+    _Link_type __l, __r;
+    _Dropped __dl;
+    std::thread __left;
+    if (__forks > 1) {
+        // with no thread to be had (std::system_error, or bad_alloc for its state) both
+        // halves are done here, so nothing is lost half way through
+        __STL_TRY {
+            __left = std::thread([&] { __l = _M_combine(__al, __bl, __op, __dl, __forks / 2); });
+        }
+        __STL_CATCH_ALL {}
+    }
+    if (__left.joinable()) {
+        __r = _M_combine(__ar, __br, __op, __d, __forks - __forks / 2);
+        __left.join();
+        __d._M_splice(__dl);
+    } else {
+        __l = _M_combine(__al, __bl, __op, __d, 1);
+        __r = _M_combine(__ar, __br, __op, __d, 1);
+    }
+
+    if (__m) __d._M_push(__m);
+    if (__op == _S_union || (__op == _S_intersection) == (__m != 0))
+        return (_Link_type) _Rb_tree_join(__l, __a, __r, _Update());
+    __a->_M_left = __a->_M_right = 0;
+    __d._M_push(__a);
+    return (_Link_type) _Rb_tree_join2(__l, __r, _Update());
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_set_operation(_Rb_tree &__x, _Set_op __op, unsigned __threads) {
+    if (this == &__x) {
+        if (__op == _S_difference) clear();
+        return;
+    }
+    if (__threads == 0) __threads = std::thread::hardware_concurrency();
+    // a thread costs about as much as a few thousand comparisons
+    if (_M_node_count + __x._M_node_count < 65536 || __threads == 0) __threads = 1;
+
+    const size_type __n = _M_node_count + __x._M_node_count;
+    _Link_type __a = _M_root();
+    _Link_type __b = __x._M_root();
+    if (__a) __a->_M_parent = 0;
+    if (__b) __b->_M_parent = 0;
+    _M_empty_initialize();
+    _M_node_count = 0;
+    __x._M_empty_initialize();
+    __x._M_node_count = 0;
+
+    _Dropped __d;
+    _Link_type __root = _M_combine(__a, __b, __op, __d, __threads);
+    size_type __dropped = 0;
+    for (_Base_ptr __y = __d._M_first; __y != 0;) {
+        _Base_ptr __next = __y->_M_parent;
+        __dropped += _M_erase_counted((_Link_type) __y);
+        __y = __next;
+    }
+
+    if (__root) {
+        __root->_M_set_color(_S_rb_tree_black);
+        __root->_M_parent = _M_header;
+        _M_header->_M_parent = __root;
+        _M_leftmost() = _S_minimum(__root);
+        _M_rightmost() = _S_maximum(__root);
+        _M_node_count = __n - __dropped;
+    }
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::size_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
+::_M_erase_counted(_Link_type __x) {
+    size_type __n = 0;
+    while (__x != 0) {
+        __n += _M_erase_counted(_S_right(__x));
+        _Link_type __y = _S_left(__x);
+        destroy_node(__x);
+        __x = __y;
+        ++__n;
+    }
+    return __n;
+}
+
+template<class _Key, class _Value, class _KeyOfValue,
+        class _Compare, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::_M_erase(_Link_type __x) {
     // erase without rebalancing
     while (__x != 0) {
@@ -1063,8 +2099,8 @@ void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::erase(iterator __first, iterator __last) {
     if (__first == begin() && __last == end())
         clear();
@@ -1073,16 +2109,16 @@ void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+void _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::erase(const _Key *__first, const _Key *__last) {
     while (__first != __last) erase(*__first++);
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::find(const _Key &__k) {
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::find(const _Key &__k) {
     _Link_type __y = _M_header;      // Last node which is not less than __k.
     _Link_type __x = _M_root();      // Current node.
 
@@ -1098,9 +2134,9 @@ _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::find(const _Key &__k) {
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::const_iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::find(const _Key &__k) const {
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::const_iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::find(const _Key &__k) const {
     _Link_type __y = _M_header; /* Last node which is not less than __k. */
     _Link_type __x = _M_root(); /* Current node. */
 
@@ -1116,20 +2152,21 @@ _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::find(const _Key &__k) con
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::size_type
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::size_type
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::count(const _Key &__k) const {
     std::pair<const_iterator, const_iterator> __p = equal_range(__k);
     size_type __n = 0;
-    distance(__p.first, __p.second, __n);
+    for (const_iterator __it = __p.first; __it != __p.second; ++__it)
+        ++__n;
     return __n;
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::lower_bound(const _Key &__k) {
     _Link_type __y = _M_header; /* Last node which is not less than __k. */
     _Link_type __x = _M_root(); /* Current node. */
@@ -1144,9 +2181,9 @@ _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::const_iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::const_iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::lower_bound(const _Key &__k) const {
     _Link_type __y = _M_header; /* Last node which is not less than __k. */
     _Link_type __x = _M_root(); /* Current node. */
@@ -1161,9 +2198,9 @@ _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::upper_bound(const _Key &__k) {
     _Link_type __y = _M_header; /* Last node which is greater than __k. */
     _Link_type __x = _M_root(); /* Current node. */
@@ -1178,9 +2215,9 @@ _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::const_iterator
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+        class _Compare, class _Alloc, class _Augment>
+typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::const_iterator
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::upper_bound(const _Key &__k) const {
     _Link_type __y = _M_header; /* Last node which is greater than __k. */
     _Link_type __x = _M_root(); /* Current node. */
@@ -1195,23 +2232,23 @@ _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
+        class _Compare, class _Alloc, class _Augment>
 inline
-std::pair<typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator,
-        typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::iterator>
-_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>
+std::pair<typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator,
+        typename _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::iterator>
+_Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>
 ::equal_range(const _Key &__k) {
-    return pair<iterator, iterator>(lower_bound(__k), upper_bound(__k));
+    return std::pair<iterator, iterator>(lower_bound(__k), upper_bound(__k));
 }
 
-template<class _Key, class _Value, class _KoV, class _Compare, class _Alloc>
+template<class _Key, class _Value, class _KoV, class _Compare, class _Alloc, class _Augment>
 inline
-std::pair<typename _Rb_tree<_Key, _Value, _KoV, _Compare, _Alloc>::const_iterator,
-        typename _Rb_tree<_Key, _Value, _KoV, _Compare, _Alloc>::const_iterator>
-_Rb_tree<_Key, _Value, _KoV, _Compare, _Alloc>
+std::pair<typename _Rb_tree<_Key, _Value, _KoV, _Compare, _Alloc, _Augment>::const_iterator,
+        typename _Rb_tree<_Key, _Value, _KoV, _Compare, _Alloc, _Augment>::const_iterator>
+_Rb_tree<_Key, _Value, _KoV, _Compare, _Alloc, _Augment>
 ::equal_range(const _Key &__k) const {
-    return pair<const_iterator, const_iterator>(lower_bound(__k),
-                                                upper_bound(__k));
+    return std::pair<const_iterator, const_iterator>(lower_bound(__k),
+                                                     upper_bound(__k));
 }
 
 inline int
@@ -1219,7 +2256,7 @@ __black_count(_Rb_tree_node_base *__node, _Rb_tree_node_base *__root) {
     if (__node == 0)
         return 0;
     else {
-        int __bc = __node->_M_color == _S_rb_tree_black ? 1 : 0;
+        int __bc = __node->_M_get_color() == _S_rb_tree_black ? 1 : 0;
         if (__node == __root)
             return __bc;
         else
@@ -1228,8 +2265,8 @@ __black_count(_Rb_tree_node_base *__node, _Rb_tree_node_base *__root) {
 }
 
 template<class _Key, class _Value, class _KeyOfValue,
-        class _Compare, class _Alloc>
-bool _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::__rb_verify() const {
+        class _Compare, class _Alloc, class _Augment>
+bool _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment>::__rb_verify() const {
     if (_M_node_count == 0 || begin() == end())
         return _M_node_count == 0 && begin() == end() &&
                _M_header->_M_left == _M_header && _M_header->_M_right == _M_header;
@@ -1240,9 +2277,9 @@ bool _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::__rb_verify() const
         _Link_type __L = _S_left(__x);
         _Link_type __R = _S_right(__x);
 
-        if (__x->_M_color == _S_rb_tree_red)
-            if ((__L && __L->_M_color == _S_rb_tree_red) ||
-                (__R && __R->_M_color == _S_rb_tree_red))
+        if (__x->_M_get_color() == _S_rb_tree_red)
+            if ((__L && __L->_M_get_color() == _S_rb_tree_red) ||
+                (__R && __R->_M_get_color() == _S_rb_tree_red))
                 return false;
 
         if (__L && _M_key_compare(_S_key(__x), _S_key(__L)))
@@ -1266,9 +2303,10 @@ bool _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc>::__rb_verify() const
 // compatibility with the HP STL.
 
 template<class _Key, class _Value, class _KeyOfValue, class _Compare,
-        class _Alloc = STL_DEFAULT_ALLOCATOR>
-struct rb_tree : public _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> {
-    typedef _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> _Base;
+        class _Alloc = STL_DEFAULT_ALLOCATOR,
+        class _Augment = _Rb_tree_no_augment>
+struct rb_tree : public _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> {
+    typedef _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> _Base;
     typedef typename _Base::allocator_type allocator_type;
 
     rb_tree(const _Compare &__comp = _Compare(),
@@ -1278,6 +2316,31 @@ struct rb_tree : public _Rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> {
     ~rb_tree() {}
 };
 
+// the tree behind map, multimap and set; btree.h provides btree_backend as the alternative
+struct rb_tree_backend {
+    template<class _Key, class _Value, class _KeyOfValue, class _Compare, class _Alloc>
+    struct rebind {
+        typedef rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc> other;
+    };
+};
+
+// an rb_tree whose nodes carry _Augment, such as rb_tree_order_statistics for select and rank
+template<class _Augment>
+struct augmented_rb_tree_backend {
+    template<class _Key, class _Value, class _KeyOfValue, class _Compare, class _Alloc>
+    struct rebind {
+        typedef rb_tree<_Key, _Value, _KeyOfValue, _Compare, _Alloc, _Augment> other;
+    };
+};
+
+// whether a backend keeps summaries of the values themselves, which a value changed in place
+// would leave stale; map and multimap then hand out const elements only, as set always does
+template<class _Backend>
+struct rb_tree_summarizes_values : std::false_type {};
+
+template<class _Monoid>
+struct rb_tree_summarizes_values<augmented_rb_tree_backend<rb_tree_aggregate<_Monoid> > > : std::true_type {};
+
 #if defined(__sgi) && !defined(__GNUC__) && (_MIPS_SIM != _MIPS_SIM_ABI32)
 #pragma reset woff 1375
 #endif
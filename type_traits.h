@@ -366,6 +366,24 @@ __STL_TEMPLATE_NULL struct _Is_integer<unsigned long long> {
 
 #endif /* __STL_LONG_LONG */
 
+// The _Is_transparent template is used to enable heterogeneous lookup in
+// the associative containers.  A hash function, key equality or key
+// comparison object opts in by declaring a nested is_transparent type, as
+// std::less<> and std::equal_to<> do.
+
+template <class _Tp> struct _Void_type {
+    typedef void type;
+};
+
+template <class _Tp, class = void> struct _Is_transparent {
+    static const bool value = false;
+};
+
+template <class _Tp>
+struct _Is_transparent<_Tp, typename _Void_type<typename _Tp::is_transparent>::type> {
+    static const bool value = true;
+};
+
 #endif /* __TYPE_TRAITS_H */
 
 // Local Variables:
@@ -6,61 +6,73 @@
 #define BETHSTL_UNINITIALIZED_H
 
 #include "type_traits.h"
+#include "iterator.h"
 #include <algorithm>
+#include <cstring>
 #include "construct.h"
 
-template<class ForwardIterator, class Size, class T>
-inline ForwardIterator uninitialized_fill_n(ForwardIterator first, Size n, const T &value) {
-    return __uninitialized_fill_n(first, n, value, value_type(first));
-}
-
-template<class ForwardIterator, class Size, class T, class T1>
-inline ForwardIterator uninitialized_fill_n(ForwardIterator first, Size n, const T &value, T1 *) {
-    typedef typename __type_traits<T1>::is_POD_type is_POD;
-    return __uninitialized_fill_n_aux(first, n, value, is_POD());  // plain old data need ctor and dtor
-}
-
 template<class ForwardIterator, class Size, class T>
 inline ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T &value, __true_type) {
-    return fill_n(first, n, value);
+    return std::fill_n(first, n, value);
 }
 
 template<class ForwardIterator, class Size, class T>
 ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T &value, __false_type) {
     ForwardIterator cur = first;
-    for (int i = 0; i < n; ++i, ++cur) {
-        construct(&*cur, value);
+    try {
+        for (; n > 0; --n, ++cur) {
+            construct(&*cur, value);
+        }
+    } catch (...) {
+        ::destroy(first, cur);
+        throw;
     }
     return cur;
 }
 
-template<class InputIterator, class ForwardIterator>
-inline ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result) {
-    return __uninitialized_copy(first, last, result, value_type(result));
+template<class ForwardIterator, class Size, class T, class T1>
+inline ForwardIterator __uninitialized_fill_n(ForwardIterator first, Size n, const T &value, T1 *) {
+    typedef typename __type_traits<T1>::is_POD_type is_POD;
+    return __uninitialized_fill_n_aux(first, n, value, is_POD());  // plain old data need ctor and dtor
 }
 
-template<class InputIterator, class ForwardIterator, class T>
-inline ForwardIterator __uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result, T *) {
-    typedef typename __type_traits<T>::is_POD_type is_POD;
-    return __uninitialized_copy_aux(first, last, result, is_POD());
+template<class ForwardIterator, class Size, class T>
+inline ForwardIterator uninitialized_fill_n(ForwardIterator first, Size n, const T &value) {
+    return __uninitialized_fill_n(first, n, value, value_type(first));
 }
 
 template<class InputIterator, class ForwardIterator>
 inline ForwardIterator
 __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator result, __true_type) {
-    return copy(first, last, result);
+    return std::copy(first, last, result);
 }
 
 template<class InputIterator, class ForwardIterator>
 ForwardIterator
 __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type) {
     ForwardIterator cur = result;
-    for (; first != last; ++first, ++cur) {
-        construct(&*cur, *first);
+    try {
+        for (; first != last; ++first, ++cur) {
+            construct(&*cur, *first);
+        }
+    } catch (...) {
+        ::destroy(result, cur);
+        throw;
     }
     return cur;
 }
 
+template<class InputIterator, class ForwardIterator, class T>
+inline ForwardIterator __uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result, T *) {
+    typedef typename __type_traits<T>::is_POD_type is_POD;
+    return __uninitialized_copy_aux(first, last, result, is_POD());
+}
+
+template<class InputIterator, class ForwardIterator>
+inline ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result) {
+    return __uninitialized_copy(first, last, result, value_type(result));
+}
+
 //for char* and wchar_t* , write a special version to maximize performance
 inline char *uninitialized_copy(const char *first, const char *last, char *result) {
     memmove(result, first, last - first);
@@ -73,28 +85,33 @@ inline wchar_t *uninitialized_copy(const wchar_t *first, const wchar_t *last, wc
 }
 
 template<class ForwardIterator, class T>
-inline void uninitialized_fill(ForwardIterator first, ForwardIterator last, const T &value) {
-    __uninitialized_fill(first, last, value, value_type(first));
+inline void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T &value, __true_type) {
+    std::fill(first, last, value);
+}
+
+template<class ForwardIterator, class T>
+void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T &value, __false_type) {
+    ForwardIterator cur = first;
+    try {
+        for (; cur != last; ++cur) {
+            construct(&*cur, value);
+        }
+    } catch (...) {
+        ::destroy(first, cur);
+        throw;
+    }
 }
 
 template<class ForwardIterator, class T, class T1>
 inline void __uninitialized_fill(ForwardIterator first, ForwardIterator last, const T &value, T1 *) {
-    typedef typename __type_traits<T1>::is_POD is_POD;
+    typedef typename __type_traits<T1>::is_POD_type is_POD;
     __uninitialized_fill_aux(first, last, value, is_POD());
 }
 
 template<class ForwardIterator, class T>
-inline void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T &value, __true_type) {
-    fill(first, last, value);
-}
-
-template<class ForwardIterator, class T>
-void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T &value, __false_type) {
-    ForwardIterator cur = first;
-    for (; cur != last; ++cur) {
-        construct(&*cur, value);
-    }
+inline void uninitialized_fill(ForwardIterator first, ForwardIterator last, const T &value) {
+    __uninitialized_fill(first, last, value, value_type(first));
 }
 
 
-#endif //BETHSTL_UNINITIALIZED_H
\ No newline at end of file
+#endif //BETHSTL_UNINITIALIZED_H
@@ -36,6 +36,9 @@ protected:
 
     void insert_aux(iterator pos, size_type n, const T &x);
 
+    template<class ForwardIterator>
+    void range_insert(iterator pos, ForwardIterator first, ForwardIterator last);
+
     void deallocate() {
         if (start) data_allocator::deallocate(start, end_of_storage - start);
     }
@@ -51,6 +54,10 @@ public:
 
     iterator end() { return finish; }
 
+    const_iterator begin() const { return start; }
+
+    const_iterator end() const { return finish; }
+
     size_t size() const { return (size_t) (end() - begin()); }
 
     size_t capacity() const { return (size_t) (end_of_storage - begin()); }
@@ -71,15 +78,39 @@ public:
 
     explicit vector(size_t n) { fill_initialize(n, T()); }
 
+    vector(const vector &x) {
+        start = allocate_and_copy(x.size(), x.begin(), x.end());
+        finish = start + x.size();
+        end_of_storage = finish;
+    }
+
     ~vector() {
-        destroy(start, finish);
+        ::destroy(start, finish);
         deallocate();
     }
 
+    vector &operator=(const vector &x) {
+        if (&x != this) {
+            vector temp(x);
+            swap(temp);
+        }
+        return *this;
+    }
+
+    void swap(vector &x) {
+        std::swap(start, x.start);
+        std::swap(finish, x.finish);
+        std::swap(end_of_storage, x.end_of_storage);
+    }
+
     reference front() { return *begin(); }
 
+    const_reference front() const { return *begin(); }
+
     reference back() { return *(end() - 1); }
 
+    const_reference back() const { return *(end() - 1); }
+
     void push_back(const T &value) {
         if (finish != end_of_storage) {
             construct(finish, value);
@@ -105,13 +136,13 @@ public:
 
     iterator erase(iterator first, iterator last) {
         iterator head = std::copy(last, finish, first);
-        destroy(head, finish);
+        ::destroy(head, finish);
         finish = finish - (last - first);
         return first;
     }
 
     void resize(size_type newSize, const T &value) {
-        if (newSize > size()) {
+        if (newSize < size()) {
             erase(begin() + newSize, end());
         } else {
             insert(end(), newSize - size(), value);
@@ -126,8 +157,8 @@ public:
         if (capacity() < __n) {
             const size_type __old_size = size();
             iterator __tmp = allocate_and_copy(__n, start, finish);
-            destroy(start, finish);
-            deallocate(start, end_of_storage - start);
+            ::destroy(start, finish);
+            deallocate();
             start = __tmp;
             finish = __tmp + __old_size;
             end_of_storage = start + __n;
@@ -160,10 +191,32 @@ public:
         return (begin() + n);
     }
 
+    void insert(iterator pos, size_type n, const T &value) { insert_aux(pos, n, value); }
+
+    template<class ForwardIterator>
+    void insert(iterator pos, ForwardIterator first, ForwardIterator last) { range_insert(pos, first, last); }
+
 protected:
     iterator allocate_and_fill(size_type n, const T &value) {
         iterator result = data_allocator::allocate(n);
-        uninitialized_fill_n(begin(), n, value);
+        try {
+            ::uninitialized_fill_n(result, n, value);
+        } catch (...) {
+            data_allocator::deallocate(result, n);
+            throw;
+        }
+        return result;
+    }
+
+    template<class ForwardIterator>
+    iterator allocate_and_copy(size_type n, ForwardIterator first, ForwardIterator last) {
+        iterator result = data_allocator::allocate(n);
+        try {
+            ::uninitialized_copy(first, last, result);
+        } catch (...) {
+            data_allocator::deallocate(result, n);
+            throw;
+        }
         return result;
     }
 };
@@ -182,18 +235,18 @@ void vector<T, Alloc>::insert_aux(iterator pos, const T &value) {
         iterator newStart = data_allocator::allocate(newSize);
         iterator newFinish = newStart;
         try {
-            newFinish = uninitialized_copy(start, pos, newStart);
+            newFinish = ::uninitialized_copy(start, pos, newStart);
             construct(newFinish, value);
             ++newFinish;
-            newFinish = uninitialized_copy(pos, finish, newFinish);
+            newFinish = ::uninitialized_copy(pos, finish, newFinish);
         } catch (...) {
             // roll back all operation
-            destroy(newStart, newFinish);
+            ::destroy(newStart, newFinish);
             data_allocator::deallocate(newStart, newSize);
             throw;
         }
 
-        destroy(start, finish);
+        ::destroy(start, finish);
         deallocate();
 
         start = newStart;
@@ -218,14 +271,14 @@ void vector<T, Alloc>::insert_aux(iterator pos, size_t n, const T &value) {
         // If this space haven't been initialized, invoke uninitialized_copy(fill) rather than std::copy(fill)
         // and invoke copy rather than fill when there still have old value to use.
         if (elemAfterPos > n) {
-            uninitialized_copy(finish - n, finish, finish);
+            ::uninitialized_copy(finish - n, finish, finish);
             finish += n;
             std::copy_backward(pos, oldFinish - n, oldFinish);
             std::fill(pos, pos + n, copy);
         } else {
-            uninitialized_fill_n(finish, n - elemAfterPos, copy);
+            ::uninitialized_fill_n(finish, n - elemAfterPos, copy);
             finish += n - elemAfterPos;
-            uninitialized_copy(pos, oldFinish, finish);
+            ::uninitialized_copy(pos, oldFinish, finish);
             finish += elemAfterPos;
             std::fill(pos, oldFinish, copy);
         }
@@ -237,16 +290,61 @@ void vector<T, Alloc>::insert_aux(iterator pos, size_t n, const T &value) {
         iterator newStart = data_allocator::allocate(newSize);
         iterator newFinish = newStart;
         try {
-            newFinish = uninitialized_copy(start, pos, newStart);
-            newFinish = uninitialized_fill_n(newFinish, n, copy);
-            newFinish = uninitialized_copy(pos, finish, newFinish);
+            newFinish = ::uninitialized_copy(start, pos, newStart);
+            newFinish = ::uninitialized_fill_n(newFinish, n, copy);
+            newFinish = ::uninitialized_copy(pos, finish, newFinish);
+        } catch (...) {
+            ::destroy(newStart, newFinish);
+            data_allocator::deallocate(newStart, newSize);
+            throw;
+        }
+
+        ::destroy(start, finish);
+        deallocate();
+        start = newStart;
+        finish = newFinish;
+        end_of_storage = newStart + newSize;
+    }
+}
+
+template<class T, class Alloc>
+template<class ForwardIterator>
+void vector<T, Alloc>::range_insert(iterator pos, ForwardIterator first, ForwardIterator last) {
+    if (first == last) return;
+    const size_type n = (size_type) ::distance(first, last);
+    if ((size_t) (end_of_storage - finish) >= n) {
+        const size_type elemAfterPos = finish - pos;
+        iterator oldFinish = finish;
+        if (elemAfterPos > n) {
+            ::uninitialized_copy(finish - n, finish, finish);
+            finish += n;
+            std::copy_backward(pos, oldFinish - n, oldFinish);
+            std::copy(first, last, pos);
+        } else {
+            ForwardIterator mid = first;
+            ::advance(mid, elemAfterPos);
+            ::uninitialized_copy(mid, last, finish);
+            finish += n - elemAfterPos;
+            ::uninitialized_copy(pos, oldFinish, finish);
+            finish += elemAfterPos;
+            std::copy(first, mid, pos);
+        }
+    } else {
+        const size_type oldSize = size();
+        const size_type newSize = oldSize + std::max(n, oldSize);
+        iterator newStart = data_allocator::allocate(newSize);
+        iterator newFinish = newStart;
+        try {
+            newFinish = ::uninitialized_copy(start, pos, newStart);
+            newFinish = ::uninitialized_copy(first, last, newFinish);
+            newFinish = ::uninitialized_copy(pos, finish, newFinish);
         } catch (...) {
-            destroy(newStart, newFinish);
+            ::destroy(newStart, newFinish);
             data_allocator::deallocate(newStart, newSize);
             throw;
         }
 
-        destroy(start, finish);
+        ::destroy(start, finish);
         deallocate();
         start = newStart;
         finish = newFinish;